@@ -1,5 +1,5 @@
 #include "directory_list.hh"
-#include "threads/lock.hh"
+#include "threads/rw_lock.hh"
 
 DirectoryList::DirectoryList()
 {
@@ -25,7 +25,7 @@ DirectoryList::IsEmpty()
     return size == 0;
 }
 
-Lock*
+RWLock*
 DirectoryList::AddDirectory(int sector)
 {
     DirEntry *ptr;
@@ -39,7 +39,7 @@ DirectoryList::AddDirectory(int sector)
     DirEntry *element = new DirEntry();
     element->sector = sector;
     element->numThreads = 1;
-    element->lockDir = new Lock("subdirectoryLock");
+    element->lockDir = new RWLock("subdirectoryLock");
     element->next = nullptr;
     
     if (IsEmpty()) {
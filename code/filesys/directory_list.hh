@@ -1,8 +1,7 @@
 #ifndef NACHOS_FILESYS_DIRECTORYLIST__HH
 #define NACHOS_FILESYS_DIRECTORYLIST__HH
 
-//#include "threads/lock.hh"
-class Lock;
+class RWLock;
 
 class DirEntry {
 public:
@@ -11,7 +10,8 @@ public:
 
     int sector;
 
-    Lock *lockDir;
+    /// Readers and writers of the directory.
+    RWLock *lockDir;
 
     DirEntry *next;
 };
@@ -25,7 +25,9 @@ public:
 
     bool IsEmpty();
 
-    Lock *AddDirectory(int sector);
+    /// Count one more user of the directory at `sector`, and return its
+    /// lock.
+    RWLock *AddDirectory(int sector);
 
     bool CloseDirectory(int sector);
 
@@ -46,7 +46,7 @@
 #include "directory.hh"
 #include "file_header.hh"
 #include "lib/bitmap.hh"
-#include "threads/lock.hh"
+#include "threads/rw_lock.hh"
 #include "threads/system.hh"
 
 #include <stdio.h>
@@ -68,7 +68,7 @@ FileSystem::FileSystem(bool format)
     lockBitmap = new Lock("lockBitmap");
     openfiles = new OpenFileTable(TABLE_INIT_CAPACITY);
     directories = new DirectoryList();
-    Lock *lockDirectory = directories->AddDirectory(DIRECTORY_SECTOR);
+    RWLock *lockDirectory = directories->AddDirectory(DIRECTORY_SECTOR);
 
     if (format) {
         Bitmap     *freeMap = new Bitmap(NUM_SECTORS);
@@ -102,10 +102,12 @@ FileSystem::FileSystem(bool format)
         // The file system operations assume these two files are left open
         // while Nachos is running.
 
-        freeMapFile   = new OpenFile(FREE_MAP_SECTOR);
-        directoryFile = new OpenFile(DIRECTORY_SECTOR);
         openfiles->OpenFileAdd(FREE_MAP_SECTOR);
         openfiles->OpenFileAdd(DIRECTORY_SECTOR);
+        freeMapFile   = new OpenFile(FREE_MAP_SECTOR,
+                                     openfiles->GetLock(FREE_MAP_SECTOR));
+        directoryFile = new OpenFile(DIRECTORY_SECTOR,
+                                     openfiles->GetLock(DIRECTORY_SECTOR));
 
         // Once we have the files “open”, we can write the initial version of
         // each file back to disk.  The directory at this point is completely
@@ -117,9 +119,9 @@ FileSystem::FileSystem(bool format)
         lockBitmap->Acquire();
         freeMap->WriteBack(freeMapFile);     // flush changes to disk
         lockBitmap->Release();
-        lockDirectory->Acquire();
+        lockDirectory->AcquireWrite();
         dir->WriteBack(directoryFile);
-        lockDirectory->Release();
+        lockDirectory->ReleaseWrite();
 
         if (debug.IsEnabled('f')) {
             freeMap->Print();
@@ -134,10 +136,12 @@ FileSystem::FileSystem(bool format)
         // If we are not formatting the disk, just open the files
         // representing the bitmap and directory; these are left open while
         // Nachos is running.
-        freeMapFile   = new OpenFile(FREE_MAP_SECTOR);
-        directoryFile = new OpenFile(DIRECTORY_SECTOR);
         openfiles->OpenFileAdd(FREE_MAP_SECTOR);
         openfiles->OpenFileAdd(DIRECTORY_SECTOR);
+        freeMapFile   = new OpenFile(FREE_MAP_SECTOR,
+                                     openfiles->GetLock(FREE_MAP_SECTOR));
+        directoryFile = new OpenFile(DIRECTORY_SECTOR,
+                                     openfiles->GetLock(DIRECTORY_SECTOR));
     }
 }
 
@@ -278,8 +282,8 @@ FileSystem::Create(const char *name, unsigned initialSize, bool isDir)
         strcpy(fileName, name);
     }
 
-    Lock *lockDirectory = directories->AddDirectory(sector);
-    lockDirectory->Acquire();
+    RWLock *lockDirectory = directories->AddDirectory(sector);
+    lockDirectory->AcquireWrite();
 
     bool success;
 
@@ -329,7 +333,7 @@ FileSystem::Create(const char *name, unsigned initialSize, bool isDir)
         lockBitmap->Release();
         delete freeMap;
     }
-    lockDirectory->Release();
+    lockDirectory->ReleaseWrite();
     delete dir;
     return success;
 }
@@ -391,13 +395,15 @@ FileSystem::Open(const char *name)
         strcpy(fileName, name);
     }
 
-    Lock *lockDirectory = directories->AddDirectory(sector);
-    lockDirectory->Acquire();
+    // Lookups only read the directory, so they may run in parallel.  The
+    // open file table is updated without blocking.
+    RWLock *lockDirectory = directories->AddDirectory(sector);
+    lockDirectory->AcquireRead();
     sector = dir->Find(fileName);
 
     if (sector == -1) {
         DEBUG('f', "File %s does not exist.\n", fileName);
-        lockDirectory->Release();
+        lockDirectory->ReleaseRead();
         return nullptr;
     }
 
@@ -406,9 +412,10 @@ FileSystem::Open(const char *name)
 
     else if (sector >= 0 && openfiles->OpenFileAdd(sector)) {
         DEBUG('f', "We add the file to the table for the first time.\n");
-        openFile = new OpenFile(sector);  // `name` was found in directory.
+        // `name` was found in directory.
+        openFile = new OpenFile(sector, openfiles->GetLock(sector));
     }
-    lockDirectory->Release();
+    lockDirectory->ReleaseRead();
     delete dir;
     if (openFile != nullptr)
         DEBUG('f', "Successful opening file %s.\n", name);
@@ -474,13 +481,13 @@ FileSystem::Remove(const char *name)
         strcpy(fileName, name);
     }
 
-    Lock *lockDirectory = directories->AddDirectory(sector);
-    lockDirectory->Acquire();
+    RWLock *lockDirectory = directories->AddDirectory(sector);
+    lockDirectory->AcquireWrite();
 
     sector = dir->Find(fileName);
     if (sector == -1) {
         DEBUG('f', "Unable to remove because file %s was not found.\n", name);
-        lockDirectory->Release();
+        lockDirectory->ReleaseWrite();
         delete dir;
         return false;  // file not found
     }
@@ -498,7 +505,7 @@ FileSystem::Remove(const char *name)
             if (raw->table[i].inUse) {
                 DEBUG('f', "Removing file %s from directory %s.\n", raw->table[i].name, fileName);
                 if (!Remove(raw->table[i].name)) {
-                    lockDirectory->Release();
+                    lockDirectory->ReleaseWrite();
                     delete dirToDelete;
                     delete dirFile;
                     return false;
@@ -527,7 +534,7 @@ FileSystem::Remove(const char *name)
     else 
         Release(sector);
     
-    lockDirectory->Release();
+    lockDirectory->ReleaseWrite();
     if (isDir)
         directories->CloseDirectory(sector);
     
@@ -556,11 +563,11 @@ FileSystem::List()
 {
     int numDirEntries = directoryFile->Length() / sizeof (DirectoryEntry);   
     Directory *dir = new Directory(numDirEntries);
-    Lock *lockDirectory = directories->AddDirectory(DIRECTORY_SECTOR);
-    lockDirectory->Acquire();
+    RWLock *lockDirectory = directories->AddDirectory(DIRECTORY_SECTOR);
+    lockDirectory->AcquireRead();
     dir->FetchFrom(directoryFile);
     dir->List();
-    lockDirectory->Release();
+    lockDirectory->ReleaseRead();
     delete dir;
 }
 
@@ -804,27 +811,3 @@ FileSystem::ReleaseFreeMap(Bitmap *freeMap)
     // lockBitmap->Release();
     delete freeMap;
 }
-
-void 
-FileSystem::AcquireRead(int sector)
-{
-    openfiles->AcquireRead(sector);
-}
-
-void 
-FileSystem::ReleaseRead(int sector)
-{
-    openfiles->ReleaseRead(sector);
-}
-
-void 
-FileSystem::AcquireWrite(int sector)
-{
-    openfiles->AcquireWrite(sector);
-}
-
-void 
-FileSystem::ReleaseWrite(int sector)
-{
-    openfiles->ReleaseWrite(sector);
-}
\ No newline at end of file
@@ -157,14 +157,6 @@ public:
 
     void ReleaseFreeMap(Bitmap *freeMap);
 
-    void AcquireRead(int sector);
-
-    void ReleaseRead(int sector);
-
-    void AcquireWrite(int sector);
-
-    void ReleaseWrite(int sector);
-
     DirectoryList *directories;
 
 private:
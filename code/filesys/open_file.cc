@@ -14,7 +14,7 @@
 #include "open_file.hh"
 #include "file_header.hh"
 #include "threads/system.hh"
-#include "threads/condition.hh"
+#include "threads/rw_lock.hh"
 #include <string.h>
 
 
@@ -28,6 +28,16 @@ OpenFile::OpenFile(int s)
     hdr->FetchFrom(s);
     seekPosition = 0;
     sector = s;
+    lock = nullptr;
+}
+
+OpenFile::OpenFile(int s, RWLock *fileLock)
+{
+    hdr = new FileHeader;
+    hdr->FetchFrom(s);
+    seekPosition = 0;
+    sector = s;
+    lock = fileLock;
 }
 
 /// Close a Nachos file, de-allocating any in-memory data structures.
@@ -134,15 +144,14 @@ OpenFile::ReadAt(char *into, unsigned numBytes, unsigned position)
     // Read in all the full and partial sectors that we need.
     buf = new char [numSectors * SECTOR_SIZE];
 
-    // solo es null cuando se crea el sistema de archivos de nachos
-    if (fileSystem)
-        fileSystem->AcquireRead(sector);
+    if (lock != nullptr)
+        lock->AcquireRead();
     for (unsigned i = firstSector; i <= lastSector; i++) {
         synchDisk->ReadSector(hdr->ByteToSector(i * SECTOR_SIZE),
                               &buf[(i - firstSector) * SECTOR_SIZE]);
     }
-    if (fileSystem)
-        fileSystem->ReleaseRead(sector);
+    if (lock != nullptr)
+        lock->ReleaseRead();
 
     // Copy the part we want.
     memcpy(into, &buf[position - firstSector * SECTOR_SIZE], numBytes);
@@ -209,15 +218,14 @@ OpenFile::WriteAt(const char *from, unsigned numBytes, unsigned position)
     memcpy(&buf[position - firstSector * SECTOR_SIZE], from, numBytes);
 
     // Write modified sectors back.
-    // solo es null cuando se crea el sistema de archivos de nachos
-    if (fileSystem)
-        fileSystem->AcquireWrite(sector);
+    if (lock != nullptr)
+        lock->AcquireWrite();
     for (unsigned i = firstSector; i <= lastSector; i++) {
         synchDisk->WriteSector(hdr->ByteToSector(i * SECTOR_SIZE),
                                &buf[(i - firstSector) * SECTOR_SIZE]);
     }
-    if (fileSystem)
-        fileSystem->ReleaseWrite(sector);
+    if (lock != nullptr)
+        lock->ReleaseWrite();
     delete [] buf;
     return numBytes;
 }
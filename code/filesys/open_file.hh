@@ -85,8 +85,7 @@ private:
 
 #else // FILESYS
 class FileHeader;
-class Lock;
-class Condition;
+class RWLock;
 
 class OpenFile {
 public:
@@ -94,6 +93,10 @@ public:
     /// Open a file whose header is located at `sector` on the disk.
     OpenFile(int s);
 
+    /// Same, but reads and writes are synchronized with `fileLock`, the
+    /// lock of the file in the open file table.
+    OpenFile(int s, RWLock *fileLock);
+
     /// Close the file.
     ~OpenFile();
 
@@ -122,6 +125,7 @@ private:
     FileHeader *hdr;  ///< Header for this file.
     unsigned seekPosition;  ///< Current position within the file.
     int sector;
+    RWLock *lock;  ///< Null if accesses need not be synchronized.
 };
 
 #endif
@@ -1,22 +1,18 @@
 #include "open_file_table.hh"
-#include "threads/lock.hh"
-#include "threads/condition.hh"
+#include "threads/rw_lock.hh"
 
 OpenFileEntry::OpenFileEntry(int s) 
 {
     toDelete = 0;
     numThreads = 1;
     sector = s;
-    lockReadCount = new Lock("lockReadCount");
-    readCount = 0;
-    noReaders = new Condition("noReaders", lockReadCount);
+    lock = new RWLock("openFileLock");
     next = nullptr;
 }
 
 OpenFileEntry::~OpenFileEntry() 
 {
-    delete lockReadCount;
-    delete noReaders;
+    delete lock;
 }
 
 
@@ -121,69 +117,16 @@ OpenFileList::CloseOpenFile(int sector)
     return false;
 }
 
-void 
-OpenFileList::AcquireRead(int sector)
+RWLock *
+OpenFileList::GetLock(int sector)
 {
     ListNode *ptr;
     for (ptr = first; ptr != nullptr; ptr = ptr->next) {
         if (ptr->sector == sector) {
-            if (!ptr->lockReadCount->IsHeldByCurrentThread()) {
-                ptr->lockReadCount->Acquire();
-                ptr->readCount++;
-                ptr->lockReadCount->Release();
-            }
-            return;
-        }
-    }
-    return;
-}
-
-void 
-OpenFileList::ReleaseRead(int sector)
-{
-    ListNode *ptr;
-    for (ptr = first; ptr != nullptr; ptr = ptr->next) {
-        if (ptr->sector == sector) {
-            if (!ptr->lockReadCount->IsHeldByCurrentThread()) {
-                ptr->lockReadCount->Acquire();
-                ptr->readCount--;
-                if (ptr->readCount == 0)
-                    ptr->noReaders->Broadcast();
-                ptr->lockReadCount->Release();
-            }
-            return;
-        }
-    }
-    return;
-}
-
-void 
-OpenFileList::AcquireWrite(int sector)
-{
-    ListNode *ptr;
-    for (ptr = first; ptr != nullptr; ptr = ptr->next) {
-        if (ptr->sector == sector) {
-            ptr->lockReadCount->Acquire();
-            while (ptr->readCount > 0)
-                ptr->noReaders->Wait();
-            return;
-        }
-    }
-    return;
-}
-
-void 
-OpenFileList::ReleaseWrite(int sector)
-{
-    ListNode *ptr;
-    for (ptr = first; ptr != nullptr; ptr = ptr->next) {
-        if (ptr->sector == sector) {
-            ptr->noReaders->Broadcast();
-            ptr->lockReadCount->Release();
-            return;
+            return ptr->lock;
         }
     }
-    return;
+    return nullptr;
 }
 
 OpenFileTable::OpenFileTable(int cap){
@@ -222,30 +165,9 @@ OpenFileTable::CloseOpenFile(int sector) {
 	return table[hash].CloseOpenFile(sector); 
 }
 
-void 
-OpenFileTable::AcquireRead(int sector)
-{
-    int hash = getHash(sector);
-    table[hash].AcquireRead(sector);
-}
-
-void 
-OpenFileTable::ReleaseRead(int sector)
-{
-    int hash = getHash(sector);
-    table[hash].ReleaseRead(sector);
-}
-
-void 
-OpenFileTable::AcquireWrite(int sector)
-{
-    int hash = getHash(sector);
-    table[hash].AcquireWrite(sector);
-}
-
-void 
-OpenFileTable::ReleaseWrite(int sector)
+RWLock *
+OpenFileTable::GetLock(int sector)
 {
     int hash = getHash(sector);
-    table[hash].ReleaseWrite(sector);
+    return table[hash].GetLock(sector);
 }
@@ -4,8 +4,7 @@
 #include <string.h>
 #include "directory_entry.hh"
 
-class Lock;
-class Condition;
+class RWLock;
 
 class OpenFileEntry {
 public:
@@ -16,11 +15,8 @@ public:
 
     int sector;
 
-    Lock *lockReadCount;
-
-    int readCount;
-
-    Condition *noReaders;
+    /// Readers and writers of the file.
+    RWLock *lock;
 
     OpenFileEntry *next;
 
@@ -48,13 +44,7 @@ public:
 
     bool CloseOpenFile(int sector);
 
-    void AcquireRead(int sector);
-
-    void ReleaseRead(int sector);
-
-    void AcquireWrite(int sector);
-
-    void ReleaseWrite(int sector);
+    RWLock *GetLock(int sector);
 
     typedef OpenFileEntry ListNode;
 
@@ -89,13 +79,9 @@ public:
 
     bool CloseOpenFile(int sector);
 
-    void AcquireRead(int sector);
-
-    void ReleaseRead(int sector);
-
-    void AcquireWrite(int sector);
-
-    void ReleaseWrite(int sector);
+    /// Lock of the open file at `sector`, or null if it is not open.  The
+    /// `OpenFile` keeps it, so that reads and writes need no lookup.
+    RWLock *GetLock(int sector);
 };
 
 #endif
\ No newline at end of file
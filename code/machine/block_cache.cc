@@ -0,0 +1,207 @@
+/// Routines to translate and cache basic blocks of user code.
+///
+/// DO NOT CHANGE -- part of the machine emulation
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "block_cache.hh"
+#include "lib/utility.hh"
+
+
+/// Does `instr` change the flow of control, after its delay slot?
+static bool
+IsTransfer(const Instruction *instr)
+{
+    switch (instr->opCode) {
+        case OP_BEQ:
+        case OP_BGEZ:
+        case OP_BGEZAL:
+        case OP_BGTZ:
+        case OP_BLEZ:
+        case OP_BLTZ:
+        case OP_BLTZAL:
+        case OP_BNE:
+        case OP_J:
+        case OP_JAL:
+        case OP_JALR:
+        case OP_JR:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/// Does `instr` always enter the kernel?
+static bool
+IsTrap(const Instruction *instr)
+{
+    return instr->opCode == OP_SYSCALL || instr->opCode == OP_RES
+           || instr->opCode == OP_UNIMP;
+}
+
+static void
+FreeBlock(BlockCache::Block *block)
+{
+    delete [] block->ops;
+    delete block;
+}
+
+BlockCache::BlockCache(DecodeCache *aDecoded, unsigned aNumPages)
+{
+    ASSERT(aDecoded != nullptr);
+
+    decoded  = aDecoded;
+    numPages = aNumPages;
+    pages    = new Page *[numPages];
+    for (unsigned i = 0; i < numPages; i++) {
+        pages[i] = nullptr;
+    }
+    dropped  = nullptr;
+    numDrops = 0;
+}
+
+BlockCache::~BlockCache()
+{
+    for (unsigned i = 0; i < numPages; i++) {
+        if (pages[i] == nullptr) {
+            continue;
+        }
+        for (unsigned w = 0; w < WORDS_PER_PAGE; w++) {
+            if (pages[i]->blockAt[w] != nullptr) {
+                FreeBlock(pages[i]->blockAt[w]);
+            }
+        }
+        delete pages[i];
+    }
+    delete [] pages;
+    Collect();
+}
+
+BlockCache::Block *
+BlockCache::Lookup(unsigned physAddr)
+{
+    ASSERT(physAddr % 4 == 0);
+
+    unsigned frame = physAddr / PAGE_SIZE;
+    ASSERT(frame < numPages);
+
+    Page *page = pages[frame];
+    if (page == nullptr) {
+        page = pages[frame] = new Page;
+        for (unsigned w = 0; w < WORDS_PER_PAGE; w++) {
+            page->blockAt[w] = nullptr;
+            page->covered[w] = false;
+        }
+    }
+
+    Block *block = page->blockAt[physAddr % PAGE_SIZE / 4];
+    if (block == nullptr) {
+        block = Translate(page, physAddr);
+    }
+    return block;
+}
+
+BlockCache::Block *
+BlockCache::Chain(Block *from, unsigned physAddr)
+{
+    ASSERT(from != nullptr);
+
+    for (unsigned i = 0; i < 2; i++) {
+        if (from->exits[i] != nullptr && from->exitAddrs[i] == physAddr) {
+            return from->exits[i];
+        }
+    }
+
+    // Blocks of a page are dropped together, so an exit never outlives the
+    // block it leads to.
+    Block *to = Lookup(physAddr);
+    unsigned i = from->exits[0] == nullptr ? 0 : 1;
+    from->exits[i]     = to;
+    from->exitAddrs[i] = physAddr;
+    return to;
+}
+
+BlockCache::Block *
+BlockCache::Translate(Page *page, unsigned physAddr)
+{
+    ASSERT(page != nullptr);
+
+    unsigned base  = physAddr - physAddr % PAGE_SIZE;
+    unsigned first = physAddr % PAGE_SIZE / 4;
+    Instruction ops[WORDS_PER_PAGE];
+    unsigned length = 0;
+    bool inDelaySlot = false;
+
+    for (unsigned w = first; w < WORDS_PER_PAGE; w++) {
+        const Instruction *instr = decoded->Lookup(base + w * 4);
+        ops[length++] = *instr;
+        page->covered[w] = true;
+        if (inDelaySlot || IsTrap(instr)) {
+            break;
+        }
+        inDelaySlot = IsTransfer(instr);
+    }
+
+    Block *block = new Block;
+    block->ops = new Instruction [length];
+    for (unsigned i = 0; i < length; i++) {
+        block->ops[i] = ops[i];
+    }
+    block->length = length;
+    block->exits[0] = block->exits[1] = nullptr;
+    block->exitAddrs[0] = block->exitAddrs[1] = 0;
+    block->nextDropped = nullptr;
+    block->code = nullptr;
+    block->codeStart = 0;
+    block->runs = 0;
+
+    page->blockAt[first] = block;
+    return block;
+}
+
+void
+BlockCache::Invalidate(unsigned physAddr, unsigned size)
+{
+    if (size == 0) {
+        return;
+    }
+    ASSERT(physAddr + size <= numPages * PAGE_SIZE);
+
+    unsigned last = (physAddr + size - 1) / 4;
+    for (unsigned word = physAddr / 4; word <= last; word++) {
+        Page *page = pages[word / WORDS_PER_PAGE];
+        if (page == nullptr || !page->covered[word % WORDS_PER_PAGE]) {
+            continue;
+        }
+
+        for (unsigned w = 0; w < WORDS_PER_PAGE; w++) {
+            Block *block = page->blockAt[w];
+            if (block != nullptr) {
+                block->nextDropped = dropped;
+                dropped = block;
+                page->blockAt[w] = nullptr;
+            }
+            page->covered[w] = false;
+        }
+        numDrops++;
+    }
+}
+
+unsigned long
+BlockCache::GetNumDrops() const
+{
+    return numDrops;
+}
+
+void
+BlockCache::Collect()
+{
+    while (dropped != nullptr) {
+        Block *block = dropped;
+        dropped = block->nextDropped;
+        FreeBlock(block);
+    }
+}
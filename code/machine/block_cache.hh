@@ -0,0 +1,106 @@
+/// Cache of translated basic blocks of user code.
+///
+/// The threaded interpreter (see `mips_threaded.cc`) still fetches, and
+/// translates the address of, every instruction, and then checks whether
+/// an interrupt is due.  For straight-line code, the block cache lets it do
+/// that once per run of instructions instead.
+///
+/// A block is a copy of the decoded instructions from some address up to
+/// the first branch or jump and its delay slot, or up to a system call, or
+/// to the end of the page, whichever comes first.  Blocks never span
+/// pages, so one translation of the PC is good for all of a block, and
+/// blocks are kept, and dropped, by physical page.  Each block remembers the
+/// blocks that followed it in the same page, so that a loop can go from one
+/// block to the next without looking them up again.
+///
+/// Writing to an instruction of a block, through `MMU::WriteMem` or by
+/// filling its frame, drops every block of the page.  Dropped blocks are
+/// only freed by `Collect`, so that the block being run is never freed
+/// under the interpreter.
+///
+/// DO NOT CHANGE -- part of the machine emulation
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_MACHINE_BLOCKCACHE__HH
+#define NACHOS_MACHINE_BLOCKCACHE__HH
+
+
+#include "decode_cache.hh"
+
+
+class BlockCache {
+public:
+
+    /// A straight run of instructions, ready to be run one after the other.
+    struct Block {
+        Instruction *ops;
+        unsigned length;
+
+        /// Up to two blocks that followed this one, and their physical
+        /// addresses.
+        Block *exits[2];
+        unsigned exitAddrs[2];
+
+        /// Next in the list of dropped blocks.
+        Block *nextDropped;
+
+        /// Host code for the block, compiled when it started at virtual
+        /// address `codeStart`, and how many times it has run before that
+        /// (see `jit.hh`).
+        void *code;
+        unsigned codeStart;
+        unsigned runs;
+    };
+
+    /// Translate code of `numPages` pages, decoded by `decoded`.
+    BlockCache(DecodeCache *decoded, unsigned numPages);
+
+    ~BlockCache();
+
+    /// Return the block starting at physical address `physAddr`,
+    /// translating it if it is not cached yet.
+    Block *Lookup(unsigned physAddr);
+
+    /// Return the block starting at `physAddr`, which must be in the same
+    /// page as `from`, after `from`; remember it as an exit of `from`.
+    Block *Chain(Block *from, unsigned physAddr);
+
+    /// Drop the blocks of any page with an instruction in the `size` bytes
+    /// at `physAddr`.
+    void Invalidate(unsigned physAddr, unsigned size);
+
+    /// Times that blocks were dropped so far.  If it changes while running a
+    /// block, the rest of the block may be stale.
+    unsigned long GetNumDrops() const;
+
+    /// Free the blocks dropped so far.  No block may be running.
+    void Collect();
+
+private:
+
+    static const unsigned WORDS_PER_PAGE = PAGE_SIZE / 4;
+
+    /// Blocks of one page.
+    struct Page {
+        Block *blockAt[WORDS_PER_PAGE];  ///< By the word they start at.
+        bool covered[WORDS_PER_PAGE];    ///< Words in some block.
+    };
+
+    /// Translate the block at `physAddr` of `page`.
+    Block *Translate(Page *page, unsigned physAddr);
+
+    DecodeCache *decoded;
+    unsigned numPages;
+
+    /// One entry per physical page; null until code is run from it.
+    Page **pages;
+
+    Block *dropped;
+    unsigned long numDrops;
+};
+
+
+#endif
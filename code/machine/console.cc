@@ -15,6 +15,7 @@
 
 
 #include "console.hh"
+#include "interrupt_log.hh"
 #include "threads/system.hh"
 
 #include <stdio.h>
@@ -106,13 +107,26 @@ Console::CheckCharAvail()
     interrupt->Schedule(ConsoleReadPoll, this,
             CONSOLE_TIME, CONSOLE_READ_INT);
 
-    // Do nothing if character is already buffered, or none to be read.
-    if (incoming != EOF || !SystemDep::PollFile(readFileNo)) {
+    // Do nothing if character is already buffered, or none to be read.  When
+    // replaying, input comes from the log, at the time it was recorded.
+    InterruptLog *log = interrupt->GetLog();
+    if (incoming != EOF) {
         return;
     }
-
-    // Otherwise, read character and tell user about it.
-    SystemDep::Read(readFileNo, &c, sizeof c);
+    if (log != nullptr && log->IsReplaying()) {
+        if (!log->ReplayInput(&c)) {
+            return;
+        }
+    } else {
+        if (!SystemDep::PollFile(readFileNo)) {
+            return;
+        }
+        // Otherwise, read character and tell user about it.
+        SystemDep::Read(readFileNo, &c, sizeof c);
+        if (log != nullptr) {
+            log->RecordInput(c);
+        }
+    }
     incoming = c;
     stats->numConsoleCharsRead++;
     (*readHandler)(handlerArg);
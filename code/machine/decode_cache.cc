@@ -0,0 +1,76 @@
+/// Routines to cache decoded user instructions.
+///
+/// DO NOT CHANGE -- part of the machine emulation
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "decode_cache.hh"
+#include "endianness.hh"
+#include "lib/utility.hh"
+
+
+DecodeCache::DecodeCache(const char *aMemory, unsigned aNumPages)
+{
+    ASSERT(aMemory != nullptr);
+
+    memory   = aMemory;
+    numPages = aNumPages;
+    pages    = new Page *[numPages];
+    for (unsigned i = 0; i < numPages; i++) {
+        pages[i] = nullptr;
+    }
+}
+
+DecodeCache::~DecodeCache()
+{
+    for (unsigned i = 0; i < numPages; i++) {
+        delete pages[i];
+    }
+    delete [] pages;
+}
+
+const Instruction *
+DecodeCache::Lookup(unsigned physAddr)
+{
+    ASSERT(physAddr % 4 == 0);
+
+    unsigned frame = physAddr / PAGE_SIZE;
+    ASSERT(frame < numPages);
+
+    Page *page = pages[frame];
+    if (page == nullptr) {
+        page = pages[frame] = new Page;
+        for (unsigned i = 0; i < WORDS_PER_PAGE; i++) {
+            page->decoded[i] = false;
+        }
+    }
+
+    unsigned word = physAddr % PAGE_SIZE / 4;
+    Instruction *instr = &page->instrs[word];
+    if (!page->decoded[word]) {
+        instr->value = WordToHost(*(const unsigned *) &memory[physAddr]);
+        instr->Decode();
+        page->decoded[word] = true;
+    }
+    return instr;
+}
+
+void
+DecodeCache::Invalidate(unsigned physAddr, unsigned size)
+{
+    if (size == 0) {
+        return;
+    }
+    ASSERT(physAddr + size <= numPages * PAGE_SIZE);
+
+    unsigned last = (physAddr + size - 1) / 4;
+    for (unsigned word = physAddr / 4; word <= last; word++) {
+        Page *page = pages[word / WORDS_PER_PAGE];
+        if (page != nullptr) {
+            page->decoded[word % WORDS_PER_PAGE] = false;
+        }
+    }
+}
@@ -0,0 +1,65 @@
+/// Cache of decoded user instructions, by physical page.
+///
+/// The simulator used to read and decode every instruction it ran, so a
+/// loop body was decoded again on every iteration.  Instead, the first
+/// fetch from a word of physical memory decodes it and keeps the result,
+/// and later fetches from the same word just look it up.
+///
+/// The entries of a page are allocated on the first fetch from it, so pages
+/// that only hold data cost nothing but a pointer.  Anything that changes
+/// physical memory must invalidate what it changes: `MMU::WriteMem` does,
+/// and the kernel must too when it fills a frame directly (loading a
+/// program, or a page from swap), through `Machine::InvalidateCode`.
+///
+/// DO NOT CHANGE -- part of the machine emulation
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_MACHINE_DECODECACHE__HH
+#define NACHOS_MACHINE_DECODECACHE__HH
+
+
+#include "instruction.hh"
+#include "mmu.hh"
+
+
+class DecodeCache {
+    /// Compiled code (see `jit.hh`) checks `pages` by itself.
+    friend class Jit;
+
+public:
+
+    /// Cache the instructions in `numPages` pages of `memory`.
+    DecodeCache(const char *memory, unsigned numPages);
+
+    ~DecodeCache();
+
+    /// Return the instruction at physical address `physAddr`, decoding it
+    /// if it is not cached yet.  `physAddr` must be word aligned.
+    const Instruction *Lookup(unsigned physAddr);
+
+    /// Forget the instructions in the `size` bytes at `physAddr`.
+    void Invalidate(unsigned physAddr, unsigned size);
+
+private:
+
+    static const unsigned WORDS_PER_PAGE = PAGE_SIZE / 4;
+
+    /// Decoded instructions of one page.
+    struct Page {
+        Instruction instrs[WORDS_PER_PAGE];
+        bool decoded[WORDS_PER_PAGE];
+    };
+
+    const char *memory;
+    unsigned numPages;
+
+    /// One entry per physical page; null until something is fetched from
+    /// it.
+    Page **pages;
+};
+
+
+#endif
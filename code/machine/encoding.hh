@@ -91,6 +91,31 @@ enum {
     MAX_OPCODE  = 63
 };
 
+/// Specialised forms of some instructions, with routines of their own in the
+/// threaded interpreter (see `mips_threaded.cc`).  They are numbered after
+/// the opcodes, so that either can index the same table of routines.
+///
+/// `FORM_NOP`
+///     Only writes to register 0, or is a branch never taken.
+/// `FORM_MOVE`
+///     `addu` or `or` of a register and register 0.
+/// `FORM_LI`
+///     `addiu` to register 0: loads an immediate.
+/// `FORM_B`
+///     `beq` of a register with itself: always taken.
+/// `FORM_BEQZ`, `FORM_BNEZ`
+///     `beq` and `bne` against register 0.
+enum {
+    FORM_NOP    = MAX_OPCODE + 1,
+    FORM_MOVE,
+    FORM_LI,
+    FORM_B,
+    FORM_BEQZ,
+    FORM_BNEZ,
+
+    NUM_HANDLERS
+};
+
 /// Miscellaneous definitions.
 
 template<typename T>
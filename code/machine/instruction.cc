@@ -11,6 +11,78 @@
 #include "../lib/utility.hh"
 
 
+/// Pick the routine of the threaded interpreter for `instr`: a specialised
+/// one if its registers allow it, or else the one for its opcode.
+static unsigned char
+HandlerFor(const Instruction *instr)
+{
+    switch (instr->opCode) {
+        case OP_ADDU:
+        case OP_OR:
+            if (instr->rd == 0) {
+                return FORM_NOP;
+            } else if (instr->rt == 0) {
+                return FORM_MOVE;
+            }
+            break;
+
+        case OP_AND:
+        case OP_MFHI:
+        case OP_MFLO:
+        case OP_NOR:
+        case OP_SLL:
+        case OP_SLLV:
+        case OP_SLT:
+        case OP_SLTU:
+        case OP_SRA:
+        case OP_SRAV:
+        case OP_SRL:
+        case OP_SRLV:
+        case OP_SUBU:
+        case OP_XOR:
+            if (instr->rd == 0) {
+                return FORM_NOP;
+            }
+            break;
+
+        case OP_ADDIU:
+            if (instr->rt == 0) {
+                return FORM_NOP;
+            } else if (instr->rs == 0) {
+                return FORM_LI;
+            }
+            break;
+
+        case OP_ANDI:
+        case OP_LUI:
+        case OP_ORI:
+        case OP_SLTI:
+        case OP_SLTIU:
+        case OP_XORI:
+            if (instr->rt == 0) {
+                return FORM_NOP;
+            }
+            break;
+
+        case OP_BEQ:
+            if (instr->rs == instr->rt) {
+                return FORM_B;
+            } else if (instr->rt == 0) {
+                return FORM_BEQZ;
+            }
+            break;
+
+        case OP_BNE:
+            if (instr->rs == instr->rt) {
+                return FORM_NOP;
+            } else if (instr->rt == 0) {
+                return FORM_BNEZ;
+            }
+            break;
+    }
+    return instr->opCode;
+}
+
 /// Decode a MIPS instruction.
 void
 Instruction::Decode()
@@ -44,6 +116,7 @@ Instruction::Decode()
                  (i == 0x110000) ? OP_BGEZAL :
                                    OP_UNIMP;
     }
+    handler = HandlerFor(this);
 }
 
 int
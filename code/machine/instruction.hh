@@ -33,6 +33,9 @@ public:
     unsigned char rs, rt, rd;  ///< Three registers from instruction.
     int extra;  ///< Immediate or target or shamt field or offset.
                 ///< Immediates are sign-extended.
+    unsigned char handler;  ///< Routine that runs it in the threaded
+                            ///< interpreter: `opCode`, or one of the
+                            ///< specialised forms in `encoding.hh`.
 };
 
 
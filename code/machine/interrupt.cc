@@ -21,10 +21,12 @@
 
 
 #include "interrupt.hh"
+#include "interrupt_log.hh"
 #include "threads/system.hh"
 
 #include <limits.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 
 // String definitions for debugging messages
@@ -46,6 +48,25 @@ IsIntType(IntType t)
     return 0 <= t && t < NUM_INT_TYPES;
 }
 
+/// Initial size of the pending interrupt heap; it doubles when full.
+static const unsigned INITIAL_PENDING = 16;
+
+/// Does `a` fire before `b`?
+static inline bool
+Earlier(const PendingInterrupt &a, const PendingInterrupt &b)
+{
+    return a.when < b.when || (a.when == b.when && a.order < b.order);
+}
+
+PendingInterrupt::PendingInterrupt()
+{
+    handler = nullptr;
+    arg     = nullptr;
+    when    = 0;
+    type    = TIMER_INT;
+    order   = 0;
+}
+
 /// Initialize a hardware device interrupt that is to be scheduled to occur
 /// in the near future.
 ///
@@ -63,6 +84,7 @@ PendingInterrupt::PendingInterrupt(VoidFunctionPtr func, void *param,
     arg     = param;
     when    = time;
     type    = kind;
+    order   = 0;
 }
 
 /// Initialize the simulation of hardware device interrupts.
@@ -71,7 +93,11 @@ PendingInterrupt::PendingInterrupt(VoidFunctionPtr func, void *param,
 Interrupt::Interrupt()
 {
     level         = INT_OFF;
-    pending       = new List<PendingInterrupt *>;
+    capacity      = INITIAL_PENDING;
+    pending       = new PendingInterrupt [capacity];
+    numPending    = 0;
+    scheduled     = 0;
+    log           = nullptr;
     inHandler     = false;
     yieldOnReturn = false;
     status        = SYSTEM_MODE;
@@ -80,10 +106,8 @@ Interrupt::Interrupt()
 /// De-allocate the data structures needed by the interrupt simulation.
 Interrupt::~Interrupt()
 {
-    while (!pending->IsEmpty()) {
-        delete pending->Pop();
-    }
-    delete pending;
+    delete [] pending;
+    delete log;
 }
 
 /// Change interrupts to be enabled or disabled, without advancing the
@@ -147,12 +171,13 @@ Interrupt::OneTick()
 {
     MachineStatus old = status;
 
-    // Advance simulated time.
+    // Advance simulated time.  On a multiprocessor, global time only
+    // advances once every CPU has caught up.
     if (status == SYSTEM_MODE) {
-        stats->totalTicks += SYSTEM_TICK;
+        stats->totalTicks = scheduler->Step(SYSTEM_TICK, false);
         stats->systemTicks += SYSTEM_TICK;
     } else {  // USER_PROGRAM
-        stats->totalTicks += USER_TICK;
+        stats->totalTicks = scheduler->Step(USER_TICK, true);
         stats->userTicks += USER_TICK;
     }
     DEBUG('i', "== Tick %u ==\n", stats->totalTicks);
@@ -162,14 +187,44 @@ Interrupt::OneTick()
                                    // handlers run with interrupts disabled).
     while (CheckIfDue(false)) {}   // Check for pending interrupts.
     ChangeLevel(INT_OFF, INT_ON);  // Re-enable interrupts.
+    if (scheduler->TakePendingYield()) {  // Preempted from another CPU.
+        yieldOnReturn = true;
+    }
     if (yieldOnReturn) {           // If the timer device handler asked for a
                                    // context switch, ok to do it now.
         yieldOnReturn = false;
         status = SYSTEM_MODE;      // Yield is a kernel routine.
         DEBUG('i',"yieldOnReturn was set, yielding thread: %s\n", currentThread->GetName());
-        currentThread->Yield();
+        currentThread->Preempt();
         status = old;
     }
+    if (scheduler->GetNumCpus() > 1) {
+        ChangeLevel(INT_ON, INT_OFF);
+        status = SYSTEM_MODE;
+        scheduler->Rotate();       // Let the CPU furthest behind run.
+        status = old;
+        ChangeLevel(INT_OFF, INT_ON);
+    }
+}
+
+unsigned long
+Interrupt::GetDeadline() const
+{
+    if (scheduler->GetNumCpus() > 1 || debug.IsEnabled('i')
+          || yieldOnReturn) {
+        return stats->totalTicks;
+    }
+    return numPending > 0 ? pending[0].when : ULONG_MAX;
+}
+
+/// The part of `OneTick` that is left when no interrupt can be due.
+void
+Interrupt::UserTick(unsigned count)
+{
+    ASSERT(status == USER_MODE);
+
+    stats->totalTicks += count * USER_TICK;
+    stats->userTicks  += count * USER_TICK;
 }
 
 /// Called from within an interrupt handler, to cause a context switch (for
@@ -224,6 +279,10 @@ Interrupt::Halt()
 {
     printf("Machine halting!\n\n");
     stats->Print();
+    Thread::PrintAllStats();
+    if (lockProfiler != nullptr) {
+        lockProfiler->Print();
+    }
     Cleanup();  // Never returns.
 }
 
@@ -234,22 +293,19 @@ Interrupt::Halt()
 /// tick counter.  After some time (when `totalTicks` reach the maximum
 /// positive number) Nachos would schedule a pending interrupt at a negative
 /// time, and after that, it would hang.
+///
+/// Shifting every pending interrupt back by the same amount keeps the heap
+/// in order.
 void
 Interrupt::RestartTicks()
 {
-    List<PendingInterrupt *> *oldPending = pending;
-    pending = new List<PendingInterrupt *>;
-
-    PendingInterrupt *i;
-    unsigned          oldWhen = 0;
-    while ((i = oldPending->SortedPop((int *) &oldWhen)) != nullptr) {
-        unsigned newWhen = oldWhen - stats->totalTicks;
-        pending->SortedInsert(i, newWhen);
-        DEBUG('x', "Interrupt at time %u re-scheduled at new time %u.\n",
-              oldWhen, newWhen);
+    for (unsigned i = 0; i < numPending; i++) {
+        unsigned long oldWhen = pending[i].when;
+        pending[i].when = oldWhen - stats->totalTicks;
+        DEBUG('x', "Interrupt at time %lu re-scheduled at new time %lu.\n",
+              oldWhen, pending[i].when);
     }
 
-    delete oldPending;
     stats->totalTicks = 0;
     stats->tickResets += 1;
 }
@@ -258,7 +314,8 @@ Interrupt::RestartTicks()
 /// Arrange for the CPU to be interrupted when simulated time reaches `now +
 /// when`.
 ///
-/// Implementation: just put it on a sorted list.
+/// Implementation: add it to the heap of pending interrupts, growing the
+/// heap if it is full.
 ///
 /// NOTE: the Nachos kernel should not call this routine directly.  Instead,
 /// it is only called by the hardware device simulators.
@@ -276,6 +333,10 @@ Interrupt::Schedule(VoidFunctionPtr handler, void *arg,
     ASSERT(fromNow > 0);
     ASSERT(IsIntType(type));
 
+    if (log != nullptr) {
+        fromNow = log->Schedule(type, fromNow);
+    }
+
 #ifdef DFS_TICKS_FIX
     if (UINT_MAX - stats->totalTicks < fromNow) {
         DEBUG('x', "WARNING: total tick count is too large"
@@ -287,14 +348,105 @@ Interrupt::Schedule(VoidFunctionPtr handler, void *arg,
     ASSERT(ULONG_MAX - stats->totalTicks > fromNow);
 #endif
 
-    unsigned when = stats->totalTicks + fromNow;
-    PendingInterrupt *toOccur = new PendingInterrupt(handler, arg,
-                                                     when, type);
+    unsigned long when = stats->totalTicks + fromNow;
 
-    DEBUG('i', "Scheduling interrupt handler for the %s at time = %u\n",
+    DEBUG('i', "Scheduling interrupt handler for the %s at time = %lu\n",
           INT_TYPE_NAMES[type], when);
 
-    pending->SortedInsert(toOccur, when);
+    if (numPending == capacity) {
+        PendingInterrupt *old = pending;
+        capacity *= 2;
+        pending = new PendingInterrupt [capacity];
+        for (unsigned i = 0; i < numPending; i++) {
+            pending[i] = old[i];
+        }
+        delete [] old;
+    }
+    pending[numPending] = PendingInterrupt(handler, arg, when, type);
+    pending[numPending].order = scheduled++;
+    SiftUp(numPending++);
+}
+
+/// The heap is searched linearly; it is small, and devices seldom cancel.
+void
+Interrupt::Cancel(VoidFunctionPtr handler, void *arg)
+{
+    ASSERT(handler != nullptr);
+
+    unsigned i = 0;
+    while (i < numPending) {
+        if (pending[i].handler != handler || pending[i].arg != arg) {
+            i++;
+            continue;
+        }
+        DEBUG('i', "Cancelling interrupt handler for the %s at time %lu\n",
+              INT_TYPE_NAMES[pending[i].type], pending[i].when);
+        pending[i] = pending[--numPending];
+        if (i < numPending) {
+            SiftUp(i);
+            SiftDown(i);
+        }
+        i = 0;  // Sifting may have moved entries behind `i`.
+    }
+}
+
+bool
+Interrupt::GetNextDue(unsigned long *when) const
+{
+    ASSERT(when != nullptr);
+
+    if (numPending == 0) {
+        return false;
+    }
+    *when = pending[0].when;
+    return true;
+}
+
+unsigned
+Interrupt::GetNumPending() const
+{
+    return numPending;
+}
+
+void
+Interrupt::SiftUp(unsigned i)
+{
+    PendingInterrupt p = pending[i];
+    while (i > 0) {
+        unsigned parent = (i - 1) / 2;
+        if (!Earlier(p, pending[parent])) {
+            break;
+        }
+        pending[i] = pending[parent];
+        i = parent;
+    }
+    pending[i] = p;
+}
+
+void
+Interrupt::SiftDown(unsigned i)
+{
+    if (numPending == 0) {
+        return;
+    }
+
+    PendingInterrupt p = pending[i];
+    for (;;) {
+        unsigned child = 2 * i + 1;
+        if (child >= numPending) {
+            break;
+        }
+        if (child + 1 < numPending
+              && Earlier(pending[child + 1], pending[child])) {
+            child++;
+        }
+        if (!Earlier(pending[child], p)) {
+            break;
+        }
+        pending[i] = pending[child];
+        i = child;
+    }
+    pending[i] = p;
 }
 
 /// Check if an interrupt is scheduled to occur, and if so, fire it off.
@@ -304,41 +456,45 @@ Interrupt::Schedule(VoidFunctionPtr handler, void *arg,
 /// * `advanceClock` -- if true, there is nothing in the ready queue, so we
 ///   should simply advance the clock to when the next pending interrupt
 ///   would occur (if any).  If the pending interrupt is just the time-slice
-///   daemon, however, then we are done!
+///   daemon, however, and no alarm is set, then we are done!
 bool
 Interrupt::CheckIfDue(bool advanceClock)
 {
     MachineStatus old = status;
-    unsigned      when;
 
     ASSERT(level == INT_OFF);  // Interrupts need to be disabled, to invoke
                                // an interrupt handler.
     if (debug.IsEnabled('i')) {
         DumpState();
     }
-    PendingInterrupt *toOccur = pending->SortedPop((int *) &when);
+    if (numPending == 0) {  // No pending interrupts.
+        return false;
+    }
+    unsigned long when = pending[0].when;
 
-    if (toOccur == nullptr) {  // No pending interrupts.
+    // Check if there is nothing more to do, and if so, quit.  The timer
+    // is always pending, but it is only worth waiting for if some alarm is
+    // set.
+    if (status == IDLE_MODE && pending[0].type == TIMER_INT
+          && numPending == 1 && !alarms->IsPending()) {
         return false;
     }
 
     if (advanceClock && when > stats->totalTicks) {  // Advance the clock.
         stats->idleTicks += (when - stats->totalTicks);
         stats->totalTicks = when;
-    } else if (when > stats->totalTicks) {  // Not time yet, put it back.
-        pending->SortedInsert(toOccur, when);
+    } else if (when > stats->totalTicks) {  // Not time yet.
         return false;
     }
 
-    // Check if there is nothing more to do, and if so, quit.
-    if (status == IDLE_MODE && toOccur->type == TIMER_INT
-          && pending->IsEmpty()) {
-        pending->SortedInsert(toOccur, when);
-        return false;
-    }
+    // Take it off the heap before calling the handler, which may well
+    // schedule another interrupt.
+    PendingInterrupt toOccur = pending[0];
+    pending[0] = pending[--numPending];
+    SiftDown(0);
 
-    DEBUG('i', "Invoking interrupt handler for the %s at time %u\n",
-            INT_TYPE_NAMES[toOccur->type], toOccur->when);
+    DEBUG('i', "Invoking interrupt handler for the %s at time %lu\n",
+            INT_TYPE_NAMES[toOccur.type], toOccur.when);
 #ifdef USER_PROGRAM
     if (machine != nullptr) {
         machine->DelayedLoad(0, 0);
@@ -347,13 +503,31 @@ Interrupt::CheckIfDue(bool advanceClock)
     inHandler = true;
     status = SYSTEM_MODE;  // Whatever we were doing, we are now going to be
                            // running in the kernel.
-    (*toOccur->handler)(toOccur->arg);  // Call the interrupt handler.
+    (*toOccur.handler)(toOccur.arg);  // Call the interrupt handler.
     status = old;  // Restore the machine status.
     inHandler = false;
-    delete toOccur;
     return true;
 }
 
+void
+Interrupt::SetLog(InterruptLog *newLog)
+{
+    delete log;
+    log = newLog;
+}
+
+InterruptLog *
+Interrupt::GetLog() const
+{
+    return log;
+}
+
+bool
+Interrupt::IsReplaying() const
+{
+    return log != nullptr && log->IsReplaying();
+}
+
 IntStatus
 Interrupt::GetLevel() const
 {
@@ -372,15 +546,12 @@ Interrupt::SetStatus(MachineStatus st)
     status = st;
 }
 
-/// Print information about an interrupt that is scheduled to occur.  When,
-/// where, why, etc.
-static void
-PrintPending(PendingInterrupt *pend)
+static int
+ComparePending(const void *a, const void *b)
 {
-    ASSERT(pend != nullptr);
-
-    printf("    Handler %s, scheduled at %lu\n",
-           INT_TYPE_NAMES[pend->type], pend->when);
+    const PendingInterrupt *p = (const PendingInterrupt *) a;
+    const PendingInterrupt *q = (const PendingInterrupt *) b;
+    return Earlier(*p, *q) ? -1 : Earlier(*q, *p) ? 1 : 0;
 }
 
 /// Print the complete interrupt state -- the status, and all interrupts that
@@ -390,10 +561,22 @@ Interrupt::DumpState()
 {
     printf("Time: %lu, interrupts %s\n",
         stats->totalTicks, INT_LEVEL_NAMES[level]);
-    if (pending->IsEmpty()) {
+    if (numPending == 0) {
         printf("No pending interrupts\n");
-    } else {
-        printf("Pending interrupts:\n");
-        pending->Apply(PrintPending);
+        return;
+    }
+
+    // Print them in the order they will fire, which the heap does not keep.
+    PendingInterrupt *sorted = new PendingInterrupt [numPending];
+    for (unsigned i = 0; i < numPending; i++) {
+        sorted[i] = pending[i];
+    }
+    qsort(sorted, numPending, sizeof *sorted, ComparePending);
+
+    printf("Pending interrupts:\n");
+    for (unsigned i = 0; i < numPending; i++) {
+        printf("    Handler %s, scheduled at %lu\n",
+               INT_TYPE_NAMES[sorted[i].type], sorted[i].when);
     }
+    delete [] sorted;
 }
@@ -36,7 +36,7 @@
 #define NACHOS_MACHINE_INTERRUPT__HH
 
 
-#include "lib/list.hh"
+#include "lib/utility.hh"
 
 
 /// Interrupts can be disabled (`INT_OFF`) or enabled (`INT_ON`).
@@ -75,6 +75,9 @@ enum IntType {
 class PendingInterrupt {
 public:
 
+    /// An empty slot of the pending set.
+    PendingInterrupt();
+
     /// initialize an interrupt that will occur in the future.
     PendingInterrupt(VoidFunctionPtr func, void *param,
                      unsigned long time, IntType kind);
@@ -85,13 +88,22 @@ public:
     void *arg;  ///< The argument to the function.
     unsigned long when;  ///< When the interrupt is supposed to fire.
     IntType type;  ///< For debugging.
+    unsigned long order;  ///< Order of scheduling, to fire interrupts due
+                          ///< at the same time first come, first served.
 };
 
+class InterruptLog;
+
 /// The following class defines the data structures for the simulation
 /// of hardware interrupts.
 ///
 /// We record whether interrupts are enabled or disabled, and any hardware
 /// interrupts that are scheduled to occur in the future.
+///
+/// The pending interrupts are kept by value in a binary min-heap, ordered by
+/// time, so that scheduling one takes O(log n) and allocates nothing once
+/// the heap has grown, and finding out when the next one is due is O(1).
+/// That check is made after every tick of simulated time.
 class Interrupt {
 public:
 
@@ -128,6 +140,17 @@ public:
     // Print interrupt state.
     void DumpState();
 
+    /// Record every interrupt scheduled to `log`, or replay them from it
+    /// (see `interrupt_log.hh`).  Takes ownership of `log`.
+    void SetLog(InterruptLog *log);
+
+    /// The log being recorded or replayed, if any.
+    InterruptLog *GetLog() const;
+
+    /// Are the interrupt delays being replayed?  Devices need not work
+    /// their own out then.
+    bool IsReplaying() const;
+
 
     /// NOTE: the following are internal to the hardware simulation code.
     /// DO NOT call these directly.  I should make them “private”,
@@ -140,13 +163,44 @@ public:
     void Schedule(VoidFunctionPtr handler, void *arg,
                   unsigned long when, IntType type);
 
+    /// Take back the interrupts scheduled with `handler` and `arg` that
+    /// have not occurred yet.
+    ///
+    /// This is called by the hardware device simulators.
+    void Cancel(VoidFunctionPtr handler, void *arg);
+
+    /// Store in `when` the time at which the next interrupt is due.
+    /// Returns false if none is pending.
+    bool GetNextDue(unsigned long *when) const;
+
+    /// Number of interrupts pending.
+    unsigned GetNumPending() const;
+
     /// Advance simulated time.
     void OneTick();
 
+    /// Time up to which a user program may run without calling `OneTick`,
+    /// because nothing but the clock would change: when the next interrupt
+    /// is due.  Before then, each instruction may be accounted for with
+    /// `UserTick` instead.
+    ///
+    /// Returns the current time, so that every tick goes through `OneTick`,
+    /// when there are several CPUs to rotate, when interrupts are being
+    /// traced, or when a context switch is already due.
+    unsigned long GetDeadline() const;
+
+    /// Advance simulated time by `count` user ticks, all before the
+    /// deadline.
+    void UserTick(unsigned count = 1);
+
 private:
     IntStatus level;  ///< Are interrupts enabled or disabled?
-    List<PendingInterrupt *> *pending;  ///< The list of interrupts scheduled
-                                        ///< to occur in the future.
+    PendingInterrupt *pending;  ///< Heap of interrupts scheduled to occur in
+                                ///< the future; `pending[0]` is the next.
+    unsigned numPending;
+    unsigned capacity;
+    unsigned long scheduled;  ///< Interrupts scheduled so far.
+    InterruptLog *log;  ///< Record or replay of the delays, if any.
     bool inHandler;  ///< True if we are running an interrupt handler.
     bool yieldOnReturn;  ///< True if we are to context switch on return from
                          ///< the interrupt handler.
@@ -161,6 +215,10 @@ private:
     void ChangeLevel(IntStatus old,
                      IntStatus now);
 
+    /// Restore the heap order around slot `i`.
+    void SiftUp(unsigned i);
+    void SiftDown(unsigned i);
+
 #ifdef DFS_TICKS_FIX
     /// Restart total ticks and the pending interrupt list.
     void RestartTicks();
@@ -0,0 +1,279 @@
+/// Routines to record and replay the interrupt schedule.
+///
+/// DO NOT CHANGE -- part of the machine emulation
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "interrupt_log.hh"
+#include "threads/system.hh"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+static const unsigned char LOG_MAGIC[4] = { 'N', 'I', 'L', '2' };
+
+/// Flags in the header.
+static const unsigned char LOG_RANDOM_YIELD = 1;
+static const unsigned char LOG_TICKLESS = 2;
+
+/// Kind of the records of console input.
+static const unsigned char LOG_INPUT = 0xFF;
+
+InterruptLog::InterruptLog(const char *fileName, bool replay,
+                           LogSettings *settings)
+{
+    ASSERT(fileName != nullptr);
+    ASSERT(settings != nullptr);
+
+    replaying = replay;
+    lastTick  = 0;
+    used      = 0;
+    for (unsigned i = 0; i < NUM_INT_TYPES; i++) {
+        delays[i] = { nullptr, 0, 0, 0 };
+    }
+    inputs = { nullptr, 0, 0, 0 };
+
+    if (replaying) {
+        fd = SystemDep::OpenForReadWrite(fileName, false);
+        if (fd < 0) {
+            fprintf(stderr, "Cannot open interrupt log \"%s\".\n", fileName);
+            exit(1);
+        }
+        Load(settings);
+        SystemDep::Close(fd);
+        fd = -1;
+    } else {
+        fd = SystemDep::OpenForWrite(fileName);
+        for (unsigned i = 0; i < sizeof LOG_MAGIC; i++) {
+            Put(LOG_MAGIC[i]);
+        }
+        Put((settings->randomYield ? LOG_RANDOM_YIELD : 0)
+            | (settings->tickless ? LOG_TICKLESS : 0));
+        PutNumber(settings->seed);
+        PutNumber(settings->numCpus);
+        unsigned length = strlen(settings->policy);
+        Put(length);
+        for (unsigned i = 0; i < length; i++) {
+            Put(settings->policy[i]);
+        }
+    }
+}
+
+InterruptLog::~InterruptLog()
+{
+    if (!replaying) {
+        Flush();
+        SystemDep::Close(fd);
+    }
+    for (unsigned i = 0; i < NUM_INT_TYPES; i++) {
+        delete [] delays[i].events;
+    }
+    delete [] inputs.events;
+}
+
+bool
+InterruptLog::IsReplaying() const
+{
+    return replaying;
+}
+
+unsigned long
+InterruptLog::Schedule(IntType type, unsigned long fromNow)
+{
+    ASSERT(0 <= type && type < NUM_INT_TYPES);
+
+    if (!replaying) {
+        Put(type);
+        PutTick();
+        PutNumber(fromNow);
+        return fromNow;
+    }
+
+    EventList *list = &delays[type];
+    if (list->next == list->count) {
+        DEBUG('i', "Interrupt log exhausted for device %u.\n", type);
+        return fromNow;
+    }
+    return list->events[list->next++].value;
+}
+
+void
+InterruptLog::RecordInput(char c)
+{
+    ASSERT(!replaying);
+
+    Put(LOG_INPUT);
+    PutTick();
+    Put(c);
+}
+
+bool
+InterruptLog::ReplayInput(char *c)
+{
+    ASSERT(c != nullptr);
+    ASSERT(replaying);
+
+    if (inputs.next == inputs.count
+          || inputs.events[inputs.next].tick > stats->totalTicks) {
+        return false;
+    }
+    *c = inputs.events[inputs.next++].value;
+    return true;
+}
+
+void
+InterruptLog::Append(EventList *list, unsigned long tick, unsigned long value)
+{
+    if (list->count == list->capacity) {
+        Event *old = list->events;
+        list->capacity = list->capacity == 0 ? 64 : 2 * list->capacity;
+        list->events = new Event [list->capacity];
+        for (unsigned i = 0; i < list->count; i++) {
+            list->events[i] = old[i];
+        }
+        delete [] old;
+    }
+    list->events[list->count++] = { tick, value };
+}
+
+/// Read a number stored 7 bits per byte, least significant first, with the
+/// top bit set on every byte but the last, from `data` (of `size` bytes)
+/// at `*p`.  Returns false if the data ends first.
+static bool
+GetNumber(const unsigned char *data, unsigned size, unsigned *p,
+          unsigned long *n)
+{
+    *n = 0;
+    for (unsigned shift = 0;; shift += 7) {
+        if (*p == size) {
+            return false;
+        }
+        unsigned char byte = data[(*p)++];
+        *n |= (unsigned long) (byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+}
+
+/// Tick differences are mapped to unsigned numbers first: 0, -1, 1, -2...
+/// to 0, 1, 2, 3...
+void
+InterruptLog::Load(LogSettings *settings)
+{
+    unsigned size = 0;
+    unsigned capacity = sizeof buffer;
+    unsigned char *data = new unsigned char [capacity];
+    int n;
+    while ((n = SystemDep::ReadPartial(fd, (char *) data + size,
+                                       capacity - size)) > 0) {
+        size += n;
+        if (size == capacity) {
+            unsigned char *old = data;
+            capacity *= 2;
+            data = new unsigned char [capacity];
+            for (unsigned i = 0; i < size; i++) {
+                data[i] = old[i];
+            }
+            delete [] old;
+        }
+    }
+
+    bool valid = size > sizeof LOG_MAGIC;
+    for (unsigned i = 0; valid && i < sizeof LOG_MAGIC; i++) {
+        valid = data[i] == LOG_MAGIC[i];
+    }
+    unsigned p = sizeof LOG_MAGIC;
+
+    unsigned long seed, numCpus;
+    if (valid) {
+        unsigned char flags = data[p++];
+        settings->randomYield = flags & LOG_RANDOM_YIELD;
+        settings->tickless    = flags & LOG_TICKLESS;
+        valid = GetNumber(data, size, &p, &seed)
+                  && GetNumber(data, size, &p, &numCpus)
+                  && p < size && data[p] < sizeof settings->policy
+                  && size - p > data[p];
+    }
+    if (valid) {
+        settings->seed    = seed;
+        settings->numCpus = numCpus;
+        unsigned length = data[p++];
+        for (unsigned i = 0; i < length; i++) {
+            settings->policy[i] = data[p++];
+        }
+        settings->policy[length] = '\0';
+    }
+
+    unsigned long tick = 0;
+    while (valid && p < size) {
+        unsigned char kind = data[p++];
+        unsigned long number[2] = { 0, 0 };
+        unsigned numbers = kind == LOG_INPUT ? 1 : 2;
+        for (unsigned k = 0; valid && k < numbers; k++) {
+            valid = GetNumber(data, size, &p, &number[k]);
+        }
+        tick += number[0] & 1 ? ~(number[0] >> 1) : number[0] >> 1;
+
+        if (!valid) {
+            break;
+        } else if (kind == LOG_INPUT) {
+            valid = p < size;
+            if (valid) {
+                Append(&inputs, tick, data[p++]);
+            }
+        } else if (kind < NUM_INT_TYPES) {
+            Append(&delays[kind], tick, number[1]);
+        } else {
+            valid = false;
+        }
+    }
+    delete [] data;
+
+    if (!valid) {
+        fprintf(stderr, "The interrupt log is corrupt.\n");
+        exit(1);
+    }
+}
+
+void
+InterruptLog::Put(unsigned char byte)
+{
+    if (used == sizeof buffer) {
+        Flush();
+    }
+    buffer[used++] = byte;
+}
+
+void
+InterruptLog::PutNumber(unsigned long n)
+{
+    while (n >= 0x80) {
+        Put((n & 0x7F) | 0x80);
+        n >>= 7;
+    }
+    Put(n);
+}
+
+void
+InterruptLog::PutTick()
+{
+    unsigned long now = stats->totalTicks;
+    PutNumber(now >= lastTick ? (now - lastTick) << 1
+                              : ((lastTick - now - 1) << 1) | 1);
+    lastTick = now;
+}
+
+void
+InterruptLog::Flush()
+{
+    if (used > 0) {
+        SystemDep::WriteFile(fd, (const char *) buffer, used);
+        used = 0;
+    }
+}
@@ -0,0 +1,130 @@
+/// Record and replay of the interrupt schedule, for repeatable runs.
+///
+/// With `-rs`, timer interrupts come after random delays, drawn from the
+/// same generator the kernel may use for other things (the lottery policy
+/// does), and console input arrives whenever the host has it.  Two runs of
+/// slightly different kernels therefore see different event streams, and
+/// their timings cannot be compared.
+///
+/// When recording, every interrupt scheduled is logged with its device,
+/// the tick it was scheduled at and its delay, and every character read
+/// from the console with the tick it arrived at.  When replaying, each
+/// device gets the delays it got in the recorded run, in the same order,
+/// and console input comes from the log instead of the host.  Once the log
+/// of a device runs out, it goes back to its own delays.
+///
+/// How a run unfolds also depends on some options: whether the timer
+/// preempts at random (`-rs`, and its seed), whether it is tickless
+/// (`-nohz`), the scheduling policy (`-sp`) and the number of CPUs
+/// (`-cpus`).  These are kept in the header of the log, so that a replay
+/// can take them from there (see `LogSettings`).
+///
+/// The timer draws no random numbers while replaying, so a kernel that
+/// draws its own (like the lottery policy) sees a different sequence than
+/// in the recorded run.  Compare replays with replays.
+///
+/// The log is a binary file: a magic number, the settings, then one record
+/// per event.  The settings are a byte of flags (1 for `-rs`, 2 for
+/// `-nohz`), the seed and the number of CPUs, as variable-length numbers,
+/// and the name of the policy, as a length byte and the characters.  Every
+/// record starts with a byte for its kind (an `IntType`, or
+/// `LOG_INPUT`), followed by the tick, as a variable-length signed
+/// difference from the previous record's, and then either the delay, as a
+/// variable-length number, or the character read.
+///
+/// DO NOT CHANGE -- part of the machine emulation
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_MACHINE_INTERRUPTLOG__HH
+#define NACHOS_MACHINE_INTERRUPTLOG__HH
+
+
+#include "interrupt.hh"
+
+
+/// Options of a run that are kept in the header of its log.
+struct LogSettings {
+
+    /// Whether the timer preempts at random (`-rs`), and the seed.
+    bool randomYield;
+    unsigned seed;
+
+    /// Whether the timer is tickless (`-nohz`).
+    bool tickless;
+
+    unsigned numCpus;
+
+    /// Name of the scheduling policy.
+    char policy[16];
+};
+
+class InterruptLog {
+public:
+
+    /// Record to the file called `fileName`, or replay from it if `replay`
+    /// is set.  When recording, `settings` are written to the log; when
+    /// replaying, they are read from it.
+    InterruptLog(const char *fileName, bool replay, LogSettings *settings);
+
+    /// Write out what is left of the log, when recording.
+    ~InterruptLog();
+
+    bool IsReplaying() const;
+
+    /// A device asks for an interrupt of `type`, `fromNow` ticks from now.
+    /// Returns the delay to use: `fromNow` itself when recording, which is
+    /// logged, or the next one logged for the device when replaying.
+    unsigned long Schedule(IntType type, unsigned long fromNow);
+
+    /// Log that `c` was read from the console.
+    void RecordInput(char c);
+
+    /// When replaying, take the next character logged for the console into
+    /// `c`, if it has arrived by now.  Returns false if it has not.
+    bool ReplayInput(char *c);
+
+private:
+
+    /// A logged delay or console character.
+    struct Event {
+        unsigned long tick;
+        unsigned long value;
+    };
+
+    /// A growing list of events, consumed in order when replaying.
+    struct EventList {
+        Event *events;
+        unsigned count;
+        unsigned capacity;
+        unsigned next;
+    };
+
+    void Append(EventList *list, unsigned long tick, unsigned long value);
+
+    /// Read the whole log into `settings`, `delays` and `inputs`.
+    void Load(LogSettings *settings);
+
+    /// Writing, through a buffer.
+    void Put(unsigned char byte);
+    void PutNumber(unsigned long n);
+    void PutTick();
+    void Flush();
+
+    int fd;
+    bool replaying;
+
+    /// Tick of the last record, which the next one is relative to.
+    unsigned long lastTick;
+
+    unsigned char buffer[4096];
+    unsigned used;
+
+    EventList delays[NUM_INT_TYPES];
+    EventList inputs;
+};
+
+
+#endif
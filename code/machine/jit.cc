@@ -0,0 +1,775 @@
+/// Routines to compile blocks of user code to x86-64 code.
+///
+/// Compiled code is called as a function, following the System V calling
+/// convention for x86-64, with the simulated registers, the `Jit` and the
+/// count of instructions done and the host TLB of the MMU as arguments.  It
+/// keeps them in `rbx`, `r12`, `r13` and `r15`, saved by the callee, and
+/// uses `r14` for a loaded value that is waiting for the instruction to be
+/// done; it also keeps a word on the stack for `Load` to write to.
+///
+/// x86-64 hosts are little endian, as the simulated machine is, so words
+/// found through the host TLB are used as they are in memory.
+///
+/// DO NOT CHANGE -- part of the machine emulation
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "jit.hh"
+#include "machine.hh"
+#include "threads/system.hh"
+
+#include <stddef.h>
+
+
+#ifdef USE_JIT
+
+/// Host registers, as numbered in instructions.
+enum {
+    EAX = 0,
+    ECX = 1,
+    EDX = 2,
+    ESI = 6,
+    EDI = 7
+};
+
+/// Condition codes, for `Jcc`.
+enum {
+    CC_E  = 0x4,
+    CC_NE = 0x5,
+    CC_L  = 0xC,
+    CC_GE = 0xD,
+    CC_LE = 0xE,
+    CC_G  = 0xF
+};
+
+/// Does `instr` load from memory, with a delay?
+static inline bool
+IsLoad(const Instruction *instr)
+{
+    return instr->opCode == OP_LB || instr->opCode == OP_LBU
+           || instr->opCode == OP_LH || instr->opCode == OP_LHU
+           || instr->opCode == OP_LW;
+}
+
+/// Does `instr` store to memory?
+static inline bool
+IsStore(const Instruction *instr)
+{
+    return instr->opCode == OP_SB || instr->opCode == OP_SH
+           || instr->opCode == OP_SW;
+}
+
+/// Does `instr` change the flow of control, after its delay slot?
+static inline bool
+IsTransfer(const Instruction *instr)
+{
+    switch (instr->opCode) {
+        case OP_BEQ:
+        case OP_BGEZ:
+        case OP_BGEZAL:
+        case OP_BGTZ:
+        case OP_BLEZ:
+        case OP_BLTZ:
+        case OP_BLTZAL:
+        case OP_BNE:
+        case OP_J:
+        case OP_JAL:
+        case OP_JALR:
+        case OP_JR:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/// Compiled blocks are called with these arguments.
+typedef Jit::Result (*CompiledBlock)(int *registers, Jit *jit,
+                                     unsigned *done,
+                                     const void *hostTlb);
+
+Jit::Jit(BlockCache *aBlocks, DecodeCache *decoded)
+{
+    ASSERT(aBlocks != nullptr);
+    ASSERT(decoded != nullptr);
+    // `EmitProbe` finds an entry by shifting its index.
+    ASSERT(sizeof (MMU::HostEntry) == 16);
+
+    blocks = aBlocks;
+    decodedPages = decoded->pages;
+    pageShift = 0;
+    while (1U << pageShift < PAGE_SIZE) {
+        pageShift++;
+    }
+    ASSERT(1U << pageShift == PAGE_SIZE);
+    buffer = (unsigned char *) SystemDep::AllocExecutable(BUFFER_SIZE);
+    used   = 0;
+    code   = nullptr;
+    numTrapJumps = 0;
+    numMissJumps = 0;
+}
+
+Jit::~Jit()
+{
+    if (buffer != nullptr) {
+        SystemDep::DeallocExecutable((char *) buffer, BUFFER_SIZE);
+    }
+}
+
+Jit::Result
+Jit::Run(BlockCache::Block *block, int *registers, MMU *mmu, unsigned *done)
+{
+    ASSERT(block != nullptr);
+    ASSERT(registers != nullptr);
+    ASSERT(mmu != nullptr);
+    ASSERT(done != nullptr);
+
+    unsigned start = registers[PC_REG];
+    if (block->code == nullptr && block->runs < HOT_RUNS
+          && ++block->runs == HOT_RUNS) {
+        Compile(block, start);
+    }
+    // The same frame may have been mapped at another page since.
+    if (block->code == nullptr || block->codeStart != start) {
+        *done = 0;
+        return STOPPED;
+    }
+    return ((CompiledBlock) block->code)(registers, this, done,
+                                         mmu->hostTlb);
+}
+
+/// Compile as much of the block as possible; if the first instruction
+/// cannot be compiled, leave it all to the interpreter.
+bool
+Jit::Compile(BlockCache::Block *block, unsigned start)
+{
+    ASSERT(block != nullptr);
+
+    // Room for the longest code of every instruction, and more.
+    unsigned room = 512 * (block->length + 1);
+    if (buffer == nullptr || BUFFER_SIZE - used < room) {
+        return false;
+    }
+
+    unsigned char *entry = buffer + used;
+    code = entry;
+    numTrapJumps = 0;
+
+    Emit(0x53);                                      // push rbx
+    Emit(0x41); Emit(0x54);                          // push r12
+    Emit(0x41); Emit(0x55);                          // push r13
+    Emit(0x41); Emit(0x56);                          // push r14
+    Emit(0x41); Emit(0x57);                          // push r15
+    Emit(0x48); Emit(0x83); Emit(0xEC); Emit(0x10);  // sub rsp, 16
+    Emit(0x48); Emit(0x89); Emit(0xFB);              // mov rbx, rdi
+    Emit(0x49); Emit(0x89); Emit(0xF4);              // mov r12, rsi
+    Emit(0x49); Emit(0x89); Emit(0xD5);              // mov r13, rdx
+    Emit(0x49); Emit(0x89); Emit(0xCF);              // mov r15, rcx
+
+    bool inDelaySlot = false;  // Whether instruction `i` is in one.
+    bool afterLoad   = false;
+    bool lastInSlot  = false;
+    unsigned i;
+    for (i = 0; i < block->length; i++) {
+        const Instruction *instr = &block->ops[i];
+        unsigned char *before = code;
+        unsigned numJumps = numTrapJumps;
+        if (!CompileInstruction(instr, start, i, inDelaySlot)) {
+            code = before;
+            numTrapJumps = numJumps;
+            break;
+        }
+        bool load = IsLoad(instr);
+
+        // The delayed load, as `DelayedLoad` does it.  Only after a load is
+        // there one to do; before the first instruction, there may be.
+        if (i == 0 || afterLoad) {
+            EmitReg(0x8B, EAX, LOAD_REG);        // mov eax, [LOAD_REG]
+            EmitReg(0x8B, ECX, LOAD_VALUE_REG);  // mov ecx, [LOAD_VALUE]
+            Emit(0x89); Emit(0x0C); Emit(0x83);  // mov [rbx + rax*4], ecx
+        }
+        if (load) {
+            EmitSetReg(LOAD_REG, instr->rt);
+            Emit(0x44);                          // mov [LOAD_VALUE], r14d
+            EmitReg(0x89, 6, LOAD_VALUE_REG);
+        } else if (i == 0 || afterLoad) {
+            EmitSetReg(LOAD_REG, 0);
+            EmitSetReg(LOAD_VALUE_REG, 0);
+        }
+        if (i == 0 || afterLoad) {
+            EmitSetReg(0, 0);
+        }
+
+        // A store that dropped blocks leaves the rest of this one to be
+        // fetched again.
+        if (IsStore(instr) && i + 1 < block->length) {
+            Emit(0x41); Emit(0x83); Emit(0xFE); Emit(0x02);  // cmp r14d, 2
+            Emit(0x70 | CC_NE); Emit(0);                     // jne over
+            unsigned char *over = code;
+            EmitPcs(start, i + 1, false);
+            EmitReturn(STOPPED, i + 1);
+            over[-1] = code - over;
+        }
+
+        afterLoad   = load;
+        lastInSlot  = inDelaySlot;
+        inDelaySlot = IsTransfer(instr);
+    }
+    if (i == 0) {
+        code = nullptr;
+        return false;
+    }
+
+    if (i < block->length) {
+        EmitPcs(start, i, inDelaySlot);
+        EmitReturn(STOPPED, i);
+    } else {
+        // Advance the program counters past the last instruction.  A branch
+        // has already put the next PC in place; in its delay slot, the next
+        // PC is where it goes.
+        unsigned last = start + 4 * (i - 1);
+        EmitSetReg(PREV_PC_REG, last);
+        if (lastInSlot) {
+            EmitReg(0x8B, EAX, NEXT_PC_REG);  // mov eax, [NEXT_PC]
+            EmitReg(0x89, EAX, PC_REG);       // mov [PC], eax
+            Emit(0x05); Emit32(4);            // add eax, 4
+            EmitReg(0x89, EAX, NEXT_PC_REG);  // mov [NEXT_PC], eax
+        } else {
+            EmitSetReg(PC_REG, last + 4);
+            if (!inDelaySlot) {
+                EmitSetReg(NEXT_PC_REG, last + 8);
+            }
+        }
+        EmitReturn(FINISHED, i);
+    }
+
+    // Every trap comes here.
+    for (unsigned j = 0; j < numTrapJumps; j++) {
+        PatchJump(trapJumps[j]);
+    }
+    Emit(0xB8); Emit32(TRAPPED);                     // mov eax, TRAPPED
+    Emit(0x48); Emit(0x83); Emit(0xC4); Emit(0x10);  // add rsp, 16
+    Emit(0x41); Emit(0x5F);                          // pop r15
+    Emit(0x41); Emit(0x5E);                          // pop r14
+    Emit(0x41); Emit(0x5D);                          // pop r13
+    Emit(0x41); Emit(0x5C);                          // pop r12
+    Emit(0x5B);                                      // pop rbx
+    Emit(0xC3);                                      // ret
+
+    ASSERT((unsigned) (code - entry) <= room);
+    used += code - entry;
+    block->code = entry;
+    block->codeStart = start;
+    code = nullptr;
+    return true;
+}
+
+/// Only what cannot trap but by a load or store is compiled.
+bool
+Jit::CompileInstruction(const Instruction *instr, unsigned start,
+                        unsigned i, bool inDelaySlot)
+{
+    ASSERT(instr != nullptr);
+
+    unsigned pc = start + 4 * i;
+    unsigned char condition;     // For branches: when not to take them.
+    unsigned char opcode;        // For ALU operations.
+    unsigned char extension;     // For shifts and loads.
+    unsigned size;               // For loads and stores.
+
+    switch (instr->handler) {
+        case FORM_NOP:
+            return true;
+
+        case FORM_LI:
+            EmitResult(instr->rt, instr->extra);
+            return true;
+
+        case OP_LUI:
+            EmitResult(instr->rt, instr->extra << 16);
+            return true;
+
+        case FORM_MOVE:
+            EmitReg(0x8B, EAX, instr->rs);         // mov eax, [rs]
+            EmitStoreResult(instr->rd);
+            return true;
+
+        case OP_ADDU:  opcode = 0x03; goto alu;    // add eax, [rt]
+        case OP_SUBU:  opcode = 0x2B; goto alu;    // sub eax, [rt]
+        case OP_AND:   opcode = 0x23; goto alu;    // and eax, [rt]
+        case OP_OR:
+        case OP_NOR:   opcode = 0x0B; goto alu;    // or eax, [rt]
+        case OP_XOR:   opcode = 0x33;              // xor eax, [rt]
+        alu:
+            EmitReg(0x8B, EAX, instr->rs);
+            EmitReg(opcode, EAX, instr->rt);
+            if (instr->opCode == OP_NOR) {
+                Emit(0xF7); Emit(0xD0);            // not eax
+            }
+            EmitStoreResult(instr->rd);
+            return true;
+
+        case OP_ADDIU: opcode = 0x05; goto alu_immediate;
+        case OP_ANDI:  opcode = 0x25; goto alu_immediate;
+        case OP_ORI:   opcode = 0x0D; goto alu_immediate;
+        case OP_XORI:  opcode = 0x35;
+        alu_immediate:
+            EmitReg(0x8B, EAX, instr->rs);
+            Emit(opcode);                          // op eax, immediate
+            Emit32(instr->opCode == OP_ADDIU ? instr->extra
+                                             : instr->extra & 0xFFFF);
+            EmitStoreResult(instr->rt);
+            return true;
+
+        case OP_SLT:   condition = 0x9C; goto set;  // setl al
+        case OP_SLTU:  condition = 0x92;            // setb al
+        set:
+            EmitReg(0x8B, EAX, instr->rs);
+            EmitReg(0x3B, EAX, instr->rt);          // cmp eax, [rt]
+            Emit(0x0F); Emit(condition); Emit(0xC0);
+            Emit(0x0F); Emit(0xB6); Emit(0xC0);     // movzx eax, al
+            EmitStoreResult(instr->rd);
+            return true;
+
+        case OP_SLTI:  condition = 0x9C; goto set_immediate;
+        case OP_SLTIU: condition = 0x92;
+        set_immediate:
+            EmitReg(0x8B, EAX, instr->rs);
+            Emit(0x3D); Emit32(instr->extra);       // cmp eax, immediate
+            Emit(0x0F); Emit(condition); Emit(0xC0);
+            Emit(0x0F); Emit(0xB6); Emit(0xC0);
+            EmitStoreResult(instr->rt);
+            return true;
+
+        // As in `ExecInstruction`, logical shifts right are arithmetic.
+        case OP_SLL:   extension = 0xE0; goto shift;  // shl eax, amount
+        case OP_SRA:
+        case OP_SRL:   extension = 0xF8;              // sar eax, amount
+        shift:
+            EmitReg(0x8B, EAX, instr->rt);
+            if (instr->extra != 0) {
+                Emit(0xC1); Emit(extension); Emit(instr->extra);
+            }
+            EmitStoreResult(instr->rd);
+            return true;
+
+        case OP_SLLV:  extension = 0xE0; goto shift_variable;  // shl eax, cl
+        case OP_SRAV:
+        case OP_SRLV:  extension = 0xF8;                       // sar eax, cl
+        shift_variable:
+            EmitReg(0x8B, ECX, instr->rs);
+            EmitReg(0x8B, EAX, instr->rt);
+            Emit(0xD3); Emit(extension);
+            EmitStoreResult(instr->rd);
+            return true;
+
+        case OP_MFHI:
+        case OP_MFLO:
+            EmitReg(0x8B, EAX, instr->opCode == OP_MFHI ? HI_REG : LO_REG);
+            EmitStoreResult(instr->rd);
+            return true;
+
+        case OP_MTHI:
+        case OP_MTLO:
+            EmitReg(0x8B, EAX, instr->rs);
+            EmitReg(0x89, EAX, instr->opCode == OP_MTHI ? HI_REG : LO_REG);
+            return true;
+
+        case OP_MULT:
+            Emit(0x48); EmitReg(0x63, EAX, instr->rs);  // movsxd rax, [rs]
+            Emit(0x48); EmitReg(0x63, ECX, instr->rt);  // movsxd rcx, [rt]
+            goto multiply;
+        case OP_MULTU:
+            EmitReg(0x8B, EAX, instr->rs);
+            EmitReg(0x8B, ECX, instr->rt);
+        multiply:
+            Emit(0x48); Emit(0x0F); Emit(0xAF); Emit(0xC1);  // imul rax, rcx
+            EmitReg(0x89, EAX, LO_REG);
+            Emit(0x48); Emit(0xC1); Emit(0xE8); Emit(32);    // shr rax, 32
+            EmitReg(0x89, EAX, HI_REG);
+            return true;
+
+        case OP_DIV:
+        case OP_DIVU: {
+            // A division by 0 leaves 0 in both.
+            EmitReg(0x8B, ECX, instr->rt);
+            Emit(0x85); Emit(0xC9);                  // test ecx, ecx
+            Emit(0x70 | CC_NE); Emit(22);            // jne over the next
+            EmitSetReg(LO_REG, 0);
+            EmitSetReg(HI_REG, 0);
+            Emit(0xEB); Emit(0);                     // jmp over the rest
+            unsigned char *over = code;
+            EmitReg(0x8B, EAX, instr->rs);
+            if (instr->opCode == OP_DIV) {
+                Emit(0x99);                          // cdq
+                Emit(0xF7); Emit(0xF9);              // idiv ecx
+            } else {
+                Emit(0x31); Emit(0xD2);              // xor edx, edx
+                Emit(0xF7); Emit(0xF1);              // div ecx
+            }
+            EmitReg(0x89, EAX, LO_REG);
+            EmitReg(0x89, EDX, HI_REG);
+            over[-1] = code - over;
+            return true;
+        }
+
+        // Branches and jumps put where they go in the next PC right away,
+        // which is where it is after they are done.  One in a delay slot
+        // is left to the interpreter.
+
+        case OP_BEQ:   condition = CC_NE; goto compare;
+        case OP_BNE:   condition = CC_E;
+        compare:
+            if (inDelaySlot) {
+                return false;
+            }
+            EmitReg(0x8B, EAX, instr->rs);
+            EmitReg(0x3B, EAX, instr->rt);           // cmp eax, [rt]
+            goto branch;
+
+        case OP_BGEZAL:
+        case OP_BLTZAL:
+            if (inDelaySlot) {
+                return false;
+            }
+            EmitSetReg(RET_ADDR_REG, pc + 8);
+            condition = instr->opCode == OP_BGEZAL ? CC_L : CC_GE;
+            goto test;
+        case FORM_BEQZ: condition = CC_NE; goto test;
+        case FORM_BNEZ: condition = CC_E;  goto test;
+        case OP_BGEZ:   condition = CC_L;  goto test;
+        case OP_BLTZ:   condition = CC_GE; goto test;
+        case OP_BGTZ:   condition = CC_LE; goto test;
+        case OP_BLEZ:   condition = CC_G;
+        test:
+            if (inDelaySlot) {
+                return false;
+            }
+            EmitReg(0x8B, EAX, instr->rs);
+            Emit(0x85); Emit(0xC0);                  // test eax, eax
+        branch:
+            EmitSetReg(NEXT_PC_REG, pc + 8);
+            Emit(0x70 | condition); Emit(10);        // jcc over the next
+            EmitSetReg(NEXT_PC_REG, pc + 4 + IndexToAddr(instr->extra));
+            return true;
+
+        case FORM_B:
+            if (inDelaySlot) {
+                return false;
+            }
+            EmitSetReg(NEXT_PC_REG, pc + 4 + IndexToAddr(instr->extra));
+            return true;
+
+        case OP_JAL:
+        case OP_J:
+            if (inDelaySlot) {
+                return false;
+            }
+            if (instr->opCode == OP_JAL) {
+                EmitSetReg(RET_ADDR_REG, pc + 8);
+            }
+            EmitSetReg(NEXT_PC_REG,
+                       ((pc + 8) & 0xF0000000) | IndexToAddr(instr->extra));
+            return true;
+
+        case OP_JALR:
+        case OP_JR:
+            // A link to the register jumped through would be read back.
+            if (inDelaySlot
+                  || (instr->opCode == OP_JALR && instr->rd == instr->rs)) {
+                return false;
+            }
+            EmitReg(0x8B, EAX, instr->rs);
+            EmitReg(0x89, EAX, NEXT_PC_REG);
+            if (instr->opCode == OP_JALR) {
+                EmitResult(instr->rd, pc + 8);
+            }
+            return true;
+
+        // Loads and stores to a page in the host TLB are done right there.
+        // Any other calls `Load` or `Store`, with the program counters as
+        // for the interpreter, in case it traps.  A loaded value is kept in
+        // `r14` until the instruction is done.
+
+        case OP_LB:  size = 1; extension = 0xBE; goto load;  // movsx
+        case OP_LBU: size = 1; extension = 0xB6; goto load;  // movzx
+        case OP_LH:  size = 2; extension = 0xBF; goto load;  // movsx
+        case OP_LHU: size = 2; extension = 0xB7; goto load;  // movzx
+        case OP_LW:  size = 4; extension = 0;
+        load: {
+            EmitReg(0x8B, EDI, instr->rs);
+            Emit(0x81); Emit(0xC7); Emit32(instr->extra);  // add edi, offset
+            EmitProbe(EDI, size, false);
+            if (extension != 0) {
+                Emit(0x0F); Emit(extension); Emit(0x00);   // eax, [rax]
+            } else {
+                Emit(0x8B); Emit(0x00);                    // mov eax, [rax]
+            }
+            Emit(0x41); Emit(0x89); Emit(0xC6);            // mov r14d, eax
+            Emit(0xE9);                                    // jmp over
+            unsigned char *over = code;
+            Emit32(0);
+
+            for (unsigned j = 0; j < numMissJumps; j++) {
+                PatchJump(missJumps[j]);
+            }
+            EmitPcs(start, i, inDelaySlot);
+            EmitReg(0x8B, EDI, instr->rs);
+            Emit(0x81); Emit(0xC7); Emit32(instr->extra);  // add edi, offset
+            Emit(0xBE); Emit32(size);                      // mov esi, size
+            Emit(0x48); Emit(0x89); Emit(0xE2);            // mov rdx, rsp
+            EmitCall((const void *) &Load);
+            Emit(0x84); Emit(0xC0);                        // test al, al
+            EmitJumpToTrapped(CC_E);
+            Emit(0x8B); Emit(0x04); Emit(0x24);            // mov eax, [rsp]
+            if (extension != 0) {
+                Emit(0x0F); Emit(extension); Emit(0xC0);   // eax, al or ax
+            }
+            Emit(0x41); Emit(0x89); Emit(0xC6);            // mov r14d, eax
+            PatchJump(over);
+            return true;
+        }
+
+        case OP_SB:  size = 1; goto store;
+        case OP_SH:  size = 2; goto store;
+        case OP_SW:  size = 4;
+        store: {
+            EmitReg(0x8B, ESI, instr->rs);
+            Emit(0x81); Emit(0xC6); Emit32(instr->extra);  // add esi, offset
+            EmitProbe(ESI, size, true);
+            EmitReg(0x8B, ECX, instr->rt);
+            if (size == 2) {
+                Emit(0x66);                                // (16 bits)
+            }
+            Emit(size == 1 ? 0x88 : 0x89); Emit(0x08);     // mov [rax], ecx
+            Emit(0x41); Emit(0xBE); Emit32(1);             // mov r14d, 1
+            Emit(0xE9);                                    // jmp over
+            unsigned char *over = code;
+            Emit32(0);
+
+            for (unsigned j = 0; j < numMissJumps; j++) {
+                PatchJump(missJumps[j]);
+            }
+            EmitPcs(start, i, inDelaySlot);
+            Emit(0x4C); Emit(0x89); Emit(0xE7);            // mov rdi, r12
+            EmitReg(0x8B, ESI, instr->rs);
+            Emit(0x81); Emit(0xC6); Emit32(instr->extra);  // add esi, offset
+            Emit(0xBA); Emit32(size);                      // mov edx, size
+            EmitReg(0x8B, ECX, instr->rt);
+            EmitCall((const void *) &Store);
+            Emit(0x85); Emit(0xC0);                        // test eax, eax
+            EmitJumpToTrapped(CC_E);
+            Emit(0x41); Emit(0x89); Emit(0xC6);            // mov r14d, eax
+            PatchJump(over);
+            return true;
+        }
+
+        default:
+            return false;
+    }
+}
+
+/// Loads and stores also need the count of instructions done, for
+/// `RaiseException`.
+void
+Jit::EmitPcs(unsigned start, unsigned i, bool inDelaySlot)
+{
+    if (i > 0) {
+        EmitSetReg(PREV_PC_REG, start + 4 * (i - 1));
+        EmitSetReg(PC_REG, start + 4 * i);
+        if (!inDelaySlot) {
+            EmitSetReg(NEXT_PC_REG, start + 4 * i + 4);
+        }
+    }
+    Emit(0x41); Emit(0xC7); Emit(0x45); Emit(0x00);  // mov dword [r13], i
+    Emit32(i);
+}
+
+void
+Jit::EmitReturn(Result result, unsigned done)
+{
+    if (result != FINISHED) {
+        Emit(0x41); Emit(0xC7); Emit(0x45); Emit(0x00);  // mov [r13], done
+        Emit32(done);
+    }
+    Emit(0xB8); Emit32(result);                      // mov eax, result
+    Emit(0x48); Emit(0x83); Emit(0xC4); Emit(0x10);  // add rsp, 16
+    Emit(0x41); Emit(0x5F);                          // pop r15
+    Emit(0x41); Emit(0x5E);                          // pop r14
+    Emit(0x41); Emit(0x5D);                          // pop r13
+    Emit(0x41); Emit(0x5C);                          // pop r12
+    Emit(0x5B);                                      // pop rbx
+    Emit(0xC3);                                      // ret
+}
+
+void
+Jit::Emit(unsigned char byte)
+{
+    *code++ = byte;
+}
+
+void
+Jit::Emit32(unsigned value)
+{
+    for (unsigned k = 0; k < 4; k++) {
+        Emit(value >> 8 * k);
+    }
+}
+
+void
+Jit::Emit64(unsigned long value)
+{
+    Emit32(value);
+    Emit32(value >> 32);
+}
+
+/// The simulated register is addressed from `rbx`, with a 32-bit offset.
+void
+Jit::EmitReg(unsigned char opcode, unsigned host, unsigned reg)
+{
+    ASSERT(reg < NUM_TOTAL_REGS);
+
+    Emit(opcode);
+    Emit(0x83 | host << 3);
+    Emit32(reg * 4);
+}
+
+void
+Jit::EmitSetReg(unsigned reg, unsigned value)
+{
+    EmitReg(0xC7, 0, reg);  // mov dword [reg], value
+    Emit32(value);
+}
+
+/// Register 0 is set back to 0 when an instruction is done, and no
+/// instruction reads what it writes, so writes to it can be left out.
+void
+Jit::EmitResult(unsigned reg, unsigned value)
+{
+    if (reg != 0) {
+        EmitSetReg(reg, value);
+    }
+}
+
+void
+Jit::EmitStoreResult(unsigned reg)
+{
+    if (reg != 0) {
+        EmitReg(0x89, EAX, reg);  // mov [reg], eax
+    }
+}
+
+void
+Jit::EmitCall(const void *function)
+{
+    Emit(0x48); Emit(0xB8);  // mov rax, function
+    Emit64((unsigned long) function);
+    Emit(0xFF); Emit(0xD0);  // call rax
+}
+
+/// A host TLB entry is found as `MMU::ReadMem` and `MMU::WriteMem` find
+/// it, and checked the same way.  A store also needs the frame to be one
+/// that nothing has been fetched from, as otherwise it may change cached
+/// code; so one to code falls back to `Store`, and invalidates it there.
+void
+Jit::EmitProbe(unsigned host, unsigned size, bool writing)
+{
+    numMissJumps = 0;
+
+    Emit(0x89); Emit(0xC0 | host << 3);              // mov eax, address
+    Emit(0xC1); Emit(0xE8); Emit(pageShift);         // shr eax, page shift
+    Emit(0x89); Emit(0xC2);                          // mov edx, eax
+    Emit(0x81); Emit(0xE2);                          // and edx, entries - 1
+    Emit32(MMU::HOST_TLB_SIZE - 1);
+    Emit(0xC1); Emit(0xE2); Emit(4);                 // shl edx, 4
+    Emit(0x41); Emit(0x3B); Emit(0x44); Emit(0x17);  // cmp eax, [r15 +
+    Emit(writing ? offsetof(MMU::HostEntry, writePage)  //   rdx + page]
+                 : offsetof(MMU::HostEntry, readPage));
+    missJumps[numMissJumps++] = EmitJump(CC_NE);
+    if (size > 1) {
+        Emit(0xF7); Emit(0xC0 | host); Emit32(size - 1);  // test address
+        missJumps[numMissJumps++] = EmitJump(CC_NE);
+    }
+
+    Emit(0x49); Emit(0x8B); Emit(0x44); Emit(0x17);  // mov rax, [r15 +
+    Emit(offsetof(MMU::HostEntry, memory));          //   rdx + memory]
+    if (writing) {
+        Emit(0x48); Emit(0x89); Emit(0xC1);          // mov rcx, rax
+        Emit(0x48); Emit(0xBA);                      // mov rdx, mainMemory
+        Emit64((unsigned long) machine->mainMemory);
+        Emit(0x48); Emit(0x29); Emit(0xD1);          // sub rcx, rdx
+        Emit(0x48); Emit(0xC1); Emit(0xE9);          // shr rcx, page shift
+        Emit(pageShift);
+        Emit(0x48); Emit(0xBA);                      // mov rdx, pages
+        Emit64((unsigned long) decodedPages);
+        Emit(0x48); Emit(0x83); Emit(0x3C); Emit(0xCA);  // cmp qword [rdx +
+        Emit(0);                                         //   rcx*8], 0
+        missJumps[numMissJumps++] = EmitJump(CC_NE);
+    }
+    Emit(0x81); Emit(0xE0 | host);                   // and address,
+    Emit32(PAGE_SIZE - 1);                           //   page size - 1
+    Emit(0x48); Emit(0x01); Emit(0xC0 | host << 3);  // add rax, address
+
+#ifdef USE_TLB
+    // As counted by `Machine::ReadMem` and `Machine::WriteMem`.
+    Emit(0x48); Emit(0xB9);                          // mov rcx, &hits
+    Emit64((unsigned long) &stats->numPageHits);
+    Emit(0x48); Emit(0xFF); Emit(0x01);              // inc qword [rcx]
+#endif
+}
+
+unsigned char *
+Jit::EmitJump(unsigned char condition)
+{
+    Emit(0x0F); Emit(0x80 | condition);
+    unsigned char *rel = code;
+    Emit32(0);
+    return rel;
+}
+
+void
+Jit::PatchJump(unsigned char *rel)
+{
+    ASSERT(rel != nullptr);
+
+    unsigned offset = code - (rel + 4);
+    rel[0] = offset;
+    rel[1] = offset >> 8;
+    rel[2] = offset >> 16;
+    rel[3] = offset >> 24;
+}
+
+void
+Jit::EmitJumpToTrapped(unsigned char condition)
+{
+    ASSERT(numTrapJumps < PAGE_SIZE / 4);
+
+    trapJumps[numTrapJumps++] = EmitJump(condition);
+}
+
+/// Partial word loads are checked for alignment as in `ExecInstruction`.
+bool
+Jit::Load(unsigned addr, unsigned size, int *value)
+{
+    if (addr & (size - 1)) {
+        machine->RaiseException(ADDRESS_ERROR_EXCEPTION, addr);
+        return false;
+    }
+    return machine->ReadMem(addr, size, value);
+}
+
+/// Returns 0 if the store trapped, 2 if it dropped blocks, and 1
+/// otherwise.
+unsigned
+Jit::Store(Jit *jit, unsigned addr, unsigned size, int value)
+{
+    unsigned long drops = jit->blocks->GetNumDrops();
+    if (!machine->WriteMem(addr, size, value)) {
+        return 0;
+    }
+    return jit->blocks->GetNumDrops() == drops ? 1 : 2;
+}
+
+#endif
@@ -0,0 +1,156 @@
+/// Translation of user code to host code, on x86-64 hosts.
+///
+/// When built with `USE_JIT`, the threaded interpreter (see
+/// `mips_threaded.cc`) hands every block it is about to run (see
+/// `block_cache.hh`) to the translator first.  Once a block has been run
+/// `HOT_RUNS` times, it is compiled to x86-64 code, and from then on that
+/// code runs it instead of the interpreter.
+///
+/// Compiled code keeps the simulated registers where the interpreter does,
+/// and leaves them, the delayed load and the program counters exactly as
+/// the interpreter would after the same instructions.  Loads and stores
+/// look up the page in the host TLB of the MMU (see `mmu.hh`) by
+/// themselves, and go straight to memory if it is there; a store does so
+/// only if nothing has been fetched from the frame, which may hold code to
+/// invalidate.  Any other access goes through `Machine::ReadMem` or
+/// `Machine::WriteMem`, so it translates, and traps, as usual; when one
+/// traps, the PC is that of the instruction, and the ones before it are
+/// accounted for by `RaiseException` like for an interpreted block.
+///
+/// Only the common instructions are compiled: the arithmetic that cannot
+/// trap, multiplications and divisions, branches and jumps, and loads and
+/// stores but for the unaligned ones (`lwl` and the like).  A block is
+/// compiled up to the first instruction that is not, which is left, with
+/// the rest of the block, to the interpreter; so are system calls.  The
+/// interpreter also runs everything while single stepping or tracing, as
+/// blocks are not used then.
+///
+/// Code is never freed: it is written one block after the other to a
+/// buffer, and once the buffer is full, nothing more is compiled.
+///
+/// DO NOT CHANGE -- part of the machine emulation
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_MACHINE_JIT__HH
+#define NACHOS_MACHINE_JIT__HH
+
+
+#include "block_cache.hh"
+#include "decode_cache.hh"
+#include "mmu.hh"
+
+
+#ifdef USE_JIT
+
+#ifndef HOST_x86_64
+#error "USE_JIT needs an x86-64 host."
+#endif
+
+class Jit {
+public:
+
+    /// How a block handed to `Run` went.
+    enum Result {
+        FINISHED,  ///< All of the block ran.
+        TRAPPED,   ///< An instruction raised an exception.
+        STOPPED    ///< Only the first instructions ran, or none; the rest
+                   ///< are for the interpreter.
+    };
+
+    /// Compile blocks of `blocks`, whose instructions are decoded by
+    /// `decoded`.
+    Jit(BlockCache *blocks, DecodeCache *decoded);
+
+    ~Jit();
+
+    /// Run as much of `block` as there is compiled code for, with the
+    /// simulated `registers`, whose PC must be at the start of the block,
+    /// and `mmu`.  Store the number of instructions done in `done`, which
+    /// the machine must be watching (see `Machine::blockDone`).
+    Result Run(BlockCache::Block *block, int *registers, MMU *mmu,
+               unsigned *done);
+
+private:
+
+    static const unsigned HOT_RUNS = 16;
+    static const unsigned BUFFER_SIZE = 16 * 1024 * 1024;
+
+    /// Compile `block`, which starts at virtual address `start`.
+    bool Compile(BlockCache::Block *block, unsigned start);
+
+    /// Compile `instr`, instruction `i` of the block starting at `start`.
+    /// Returns false if it cannot be compiled.
+    bool CompileInstruction(const Instruction *instr, unsigned start,
+                            unsigned i, bool inDelaySlot);
+
+    /// Leave the program counters, and the count of instructions done, as
+    /// they are before instruction `i`.
+    void EmitPcs(unsigned start, unsigned i, bool inDelaySlot);
+
+    /// Return `result`, after `done` instructions.
+    void EmitReturn(Result result, unsigned done);
+
+    /// Machine code, by the byte.
+    void Emit(unsigned char byte);
+    void Emit32(unsigned value);
+    void Emit64(unsigned long value);
+
+    /// An instruction with `opcode`, between host register `host` and
+    /// simulated register `reg`.
+    void EmitReg(unsigned char opcode, unsigned host, unsigned reg);
+
+    /// Store `value` to simulated register `reg`.
+    void EmitSetReg(unsigned reg, unsigned value);
+
+    /// Write the result of an instruction, `value` or what is in `eax`, to
+    /// simulated register `reg`.
+    void EmitResult(unsigned reg, unsigned value);
+    void EmitStoreResult(unsigned reg);
+
+    /// Call `function`, with its arguments already in place.
+    void EmitCall(const void *function);
+
+    /// Look up the address in host register `host` in the host TLB, for an
+    /// access of `size` bytes, and leave where it is in host memory in
+    /// `rax`.  Jumps to be patched to where the access is left to `Load`
+    /// or `Store` are added to `missJumps`.
+    void EmitProbe(unsigned host, unsigned size, bool writing);
+
+    /// A jump to be patched later, and the patch to make it go to `code`.
+    unsigned char *EmitJump(unsigned char condition);
+    void PatchJump(unsigned char *rel);
+
+    /// A jump to `trapped`, to be patched.
+    void EmitJumpToTrapped(unsigned char condition);
+
+    static bool Load(unsigned addr, unsigned size, int *value);
+    static unsigned Store(Jit *jit, unsigned addr, unsigned size,
+                          int value);
+
+    BlockCache *blocks;
+
+    /// `DecodeCache::pages`, as compiled stores check it.
+    DecodeCache::Page **decodedPages;
+
+    /// Bits of an address that are the offset in its page.
+    unsigned pageShift;
+
+    unsigned char *buffer;
+    unsigned used;
+
+    /// Where code is being written, and where the jumps to the end of the
+    /// block for a trap are.
+    unsigned char *code;
+    unsigned char *trapJumps[PAGE_SIZE / 4];
+    unsigned numTrapJumps;
+    unsigned char *missJumps[3];
+    unsigned numMissJumps;
+};
+
+#endif
+
+
+#endif
@@ -42,7 +42,17 @@ CheckEndian()
 
 Machine::~Machine()
 {
+#ifdef USE_JIT
+    delete jit;
+#endif
+    delete blockCache;
+    delete decodeCache;
     delete [] mainMemory;
+    for (unsigned i = 0; i < numCpus; i++) {
+        delete cpuMmus[i];
+    }
+    delete [] cpuMmus;
+    delete [] cpuRegisters;
 }
 
 /// Initialize the simulation of user program execution.
@@ -50,17 +60,28 @@ Machine::~Machine()
 /// * `st` -- pointer to an object that performs single stepping, for
 ///   dropping into it after each user instruction is executed; if null,
 ///   execute normally, without single stepping.
-Machine::Machine(SingleStepper *st, unsigned aNumPhysicalPages): mmu(aNumPhysicalPages)
+Machine::Machine(SingleStepper *st, unsigned aNumPhysicalPages,
+                 unsigned aNumCpus)
 {
-    for (unsigned i = 0; i < NUM_TOTAL_REGS; i++) {
-        registers[i] = 0;
+    ASSERT(aNumCpus > 0);
+
+    numCpus      = aNumCpus;
+    cpuRegisters = new int [numCpus][NUM_TOTAL_REGS];
+    cpuMmus      = new MMU *[numCpus];
+    for (unsigned c = 0; c < numCpus; c++) {
+        for (unsigned i = 0; i < NUM_TOTAL_REGS; i++) {
+            cpuRegisters[c][i] = 0;
+        }
+        cpuMmus[c] = new MMU(aNumPhysicalPages);
     }
+    SelectCpu(0);
 
     for (unsigned i = 0; i < NUM_EXCEPTION_TYPES; i++) {
         handlers[i] = nullptr;
     }
 
     singleStepper = st;
+    numTraps = 0;
     CheckEndian();
 
     unsigned memory_size = aNumPhysicalPages * PAGE_SIZE;
@@ -69,7 +90,12 @@ Machine::Machine(SingleStepper *st, unsigned aNumPhysicalPages): mmu(aNumPhysica
         mainMemory[i] = 0;
     }
     numPhysicalPages = aNumPhysicalPages;
-    
+    decodeCache = new DecodeCache(mainMemory, numPhysicalPages);
+    blockCache  = new BlockCache(decodeCache, numPhysicalPages);
+    blockDone   = nullptr;
+#ifdef USE_JIT
+    jit = new Jit(blockCache, decodeCache);
+#endif
 }
 
 unsigned Machine::GetNumPhysicalPages() {
@@ -85,7 +111,28 @@ Machine::GetRegisters() const
 MMU *
 Machine::GetMMU()
 {
-    return &mmu;
+    return mmu;
+}
+
+MMU *
+Machine::GetMMU(unsigned cpu)
+{
+    ASSERT(cpu < numCpus);
+    return cpuMmus[cpu];
+}
+
+unsigned
+Machine::GetNumCpus() const
+{
+    return numCpus;
+}
+
+void
+Machine::SelectCpu(unsigned cpu)
+{
+    ASSERT(cpu < numCpus);
+    registers = cpuRegisters[cpu];
+    mmu       = cpuMmus[cpu];
 }
 
 /// Fetch or write the contents of a user program register.
@@ -111,7 +158,7 @@ Machine::WriteRegister(unsigned num, int value)
 bool
 Machine::ReadMem(unsigned addr, unsigned size, int *value)
 {
-    ExceptionType e = mmu.ReadMem(addr, size, value);
+    ExceptionType e = mmu->ReadMem(addr, size, value);
     if (e != NO_EXCEPTION) {
         RaiseException(e, addr);
         return false;
@@ -125,7 +172,7 @@ Machine::ReadMem(unsigned addr, unsigned size, int *value)
 bool
 Machine::WriteMem(unsigned addr, unsigned size, int value)
 {
-    ExceptionType e = mmu.WriteMem(addr, size, value);
+    ExceptionType e = mmu->WriteMem(addr, size, value);
     if (e != NO_EXCEPTION) {
         RaiseException(e, addr);
         return false;
@@ -136,6 +183,13 @@ Machine::WriteMem(unsigned addr, unsigned size, int value)
     return true;
 }
 
+void
+Machine::InvalidateCode(unsigned physAddr, unsigned size)
+{
+    decodeCache->Invalidate(physAddr, size);
+    blockCache->Invalidate(physAddr, size);
+}
+
 /// Transfer control to the Nachos kernel from user mode, because the user
 /// program either invoked a system call, or some exception occured (such as
 /// the address translation failed).
@@ -153,6 +207,14 @@ Machine::RaiseException(ExceptionType et, unsigned badVAddr)
     //ASSERT(interrupt->GetStatus() == USER_MODE);
     registers[BAD_VADDR_REG] = badVAddr;
     DelayedLoad(0, 0);  // Finish anything in progress.
+    numTraps++;
+    if (blockDone != nullptr) {
+        interrupt->UserTick(*blockDone);
+        #ifdef USE_TLB
+            stats->numPageHits += *blockDone;
+        #endif
+        blockDone = nullptr;
+    }
 
     // Call the associated handler with interrupts enabled in system mode.
     interrupt->SetStatus(SYSTEM_MODE);
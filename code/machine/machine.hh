@@ -21,6 +21,8 @@
 #define NACHOS_MACHINE_MACHINE__HH
 
 
+#include "block_cache.hh"
+#include "jit.hh"
 #include "exception_type.hh"
 #include "mmu.hh"
 #include "single_stepper.hh"
@@ -68,7 +70,11 @@ class Machine {
 public:
 
     /// Initialize the simulation of the hardware for running user programs.
-    Machine(SingleStepper *st, unsigned numPhysicalPages);
+    ///
+    /// Every one of the `numCpus` CPUs has its own registers and MMU, and
+    /// they all share the main memory.
+    Machine(SingleStepper *st, unsigned numPhysicalPages,
+            unsigned numCpus = 1);
 
     ~Machine();
     /// Routines callable by the Nachos kernel.
@@ -78,8 +84,16 @@ public:
 
     const int *GetRegisters() const;
 
+    /// MMU of the selected CPU, or of CPU `cpu`.
     MMU *GetMMU();
 
+    MMU *GetMMU(unsigned cpu);
+
+    unsigned GetNumCpus() const;
+
+    /// Make the registers and MMU of CPU `cpu` the ones in use.
+    void SelectCpu(unsigned cpu);
+
     /// Read the contents of a CPU register.
     int ReadRegister(unsigned num) const;
 
@@ -93,6 +107,11 @@ public:
 
     bool WriteMem(unsigned addr, unsigned size, int value);
 
+    /// Forget the instructions decoded from the `size` bytes of main memory
+    /// at physical address `physAddr`.  Must be called after writing to
+    /// main memory other than through `WriteMem`.
+    void InvalidateCode(unsigned physAddr, unsigned size);
+
     /// Print the user CPU and memory state.
     void DumpState();
 
@@ -100,8 +119,14 @@ public:
 
     /// Fetch one instruction of a user program.
     ///
+    /// Return null if an exception occurs, the decoded instruction
+    /// otherwise.
+    const Instruction *FetchInstruction();
+
+    /// Translate the PC into `physAddr`, as fetching would.
+    ///
     /// Return false if an exception occurs, true otherwise.
-    bool FetchInstruction(Instruction *instr);
+    bool TranslatePc(unsigned *physAddr);
 
     /// Run a certain instruction of a user program.
     void ExecInstruction(const Instruction *instr);
@@ -127,18 +152,45 @@ public:
     unsigned GetNumPhysicalPages();
 
 private:
+
+    /// The loop of `Run`, with threaded dispatch (see `mips_threaded.cc`).
+    void RunThreaded();
+
     SingleStepper *singleStepper;  ///< Drop back into the method of a
                                    ///< provided object (may be a debugger)
                                    ///< after each simulated instruction.
 
     /// Private data structures.
-    int registers[NUM_TOTAL_REGS];  ///< CPU registers, for executing user
-                                    ///< programs.
+    int *registers;  ///< CPU registers, for executing user programs; those
+                     ///< of the selected CPU.
+
+    MMU *mmu; ///< Memory management unit of the selected CPU.
 
-    MMU mmu; ///< Memory management unit.
+    /// Registers and MMU of every CPU.
+    int (*cpuRegisters)[NUM_TOTAL_REGS];
+    MMU **cpuMmus;
+    unsigned numCpus;
 
     ExceptionHandler handlers[NUM_EXCEPTION_TYPES];  ///< Exception handlers.
+
+    /// Exceptions raised so far, so that `Run` can tell when an instruction
+    /// has entered the kernel.
+    unsigned long numTraps;
     unsigned numPhysicalPages;
+
+    /// Instructions already decoded, and blocks already translated, by
+    /// physical address.
+    DecodeCache *decodeCache;
+    BlockCache *blockCache;
+
+    /// While a block runs, how many of its instructions are done.  They
+    /// are accounted for at the end of the block, or by `RaiseException`
+    /// if one traps, so that the kernel sees the right time and counts.
+    const unsigned *blockDone;
+
+#ifdef USE_JIT
+    Jit *jit;
+#endif
 };
 
 
@@ -24,26 +24,43 @@
 ///
 /// This routine is re-entrant, in that it can be called multiple times
 /// concurrently -- one for each thread executing user code.
+///
+/// Between interrupts, only the clock needs to advance after each
+/// instruction, so the full `Interrupt::OneTick` is only called once the
+/// next interrupt is due.  An instruction that traps into the kernel also
+/// goes through it, since the kernel may have scheduled interrupts or run
+/// other threads meanwhile; and so does every instruction while single
+/// stepping.
 void
 Machine::Run()
 {
-    Instruction *instr = new Instruction;
-      // Storage for decoded instruction.
-
     if (debug.IsEnabled('m')) {
         printf("Starting to run at time %lu\n", stats->totalTicks);
     }
     interrupt->SetStatus(USER_MODE);
 
+#ifdef THREADED_INTERPRETER
+    RunThreaded();
+#else
+    unsigned long deadline = interrupt->GetDeadline();
     for (;;) {
-        if (FetchInstruction(instr)) {
+        unsigned long traps = numTraps;
+        const Instruction *instr = FetchInstruction();
+        if (instr != nullptr) {
             ExecInstruction(instr);
         }
+        if (numTraps == traps && singleStepper == nullptr
+              && stats->totalTicks + USER_TICK < deadline) {
+            interrupt->UserTick();
+            continue;
+        }
         interrupt->OneTick();
+        deadline = interrupt->GetDeadline();
         if (singleStepper != nullptr && !singleStepper->Step()) {
             singleStepper = nullptr;
         }
     }
+#endif
 }
 
 /// Simulate effects of a delayed load.
@@ -59,17 +76,17 @@ Machine::DelayedLoad(unsigned nextReg, int nextValue)
     registers[0] = 0;  // And always make sure R0 stays zero.
 }
 
-bool
-Machine::FetchInstruction(Instruction *instr)
+/// The PC is still translated on every fetch, so that faults and the use
+/// bits of pages are as before, but the instruction comes decoded from
+/// `decodeCache`.
+const Instruction *
+Machine::FetchInstruction()
 {
-    ASSERT(instr != nullptr);
-
-    int raw;
-    if (!ReadMem(registers[PC_REG], 4, &raw)) {
-        return false;  // Exception occurred.
+    unsigned physAddr;
+    if (!TranslatePc(&physAddr)) {
+        return nullptr;  // Exception occurred.
     }
-    instr->value = raw;
-    instr->Decode();
+    const Instruction *instr = decodeCache->Lookup(physAddr);
 
     if (debug.IsEnabled('m')) {
         const struct OpString *str = &OP_STRINGS[instr->opCode];
@@ -81,6 +98,22 @@ Machine::FetchInstruction(Instruction *instr)
                         instr->RegFromType(str->args[2]));
         DEBUG_CONT('m', "\n");
     }
+    return instr;
+}
+
+bool
+Machine::TranslatePc(unsigned *physAddr)
+{
+    ASSERT(physAddr != nullptr);
+
+    ExceptionType e = mmu->TranslateFetch(registers[PC_REG], physAddr);
+    if (e != NO_EXCEPTION) {
+        RaiseException(e, registers[PC_REG]);
+        return false;
+    }
+    #ifdef USE_TLB
+        stats->numPageHits++;
+    #endif
     return true;
 }
 
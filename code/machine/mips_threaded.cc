@@ -0,0 +1,637 @@
+/// Threaded interpreter for the MIPS simulator.
+///
+/// `Machine::ExecInstruction` is a `switch` on the opcode, entered through
+/// a call for every instruction.  When built with `THREADED_INTERPRETER`,
+/// `Machine::Run` uses the loop below instead.  The routine of every
+/// instruction is a label, reached with a computed `goto` through the
+/// `handler` picked when the instruction was decoded (see `instruction.cc`),
+/// and every routine jumps straight back to the top of the loop.  Some
+/// common register forms have routines of their own: writes to register 0
+/// (the `nop` in delay slots among them), moves, immediate loads, and
+/// branches against register 0.
+///
+/// The partial word loads and stores, and the reserved and unimplemented
+/// instructions, are rare, and go through `ExecInstruction`.
+///
+/// Delayed loads and branch delay slots work as in `ExecInstruction`: an
+/// instruction computes the next PC and the load to delay, and only if it
+/// raised no exception are they installed.
+///
+/// Straight-line code runs by blocks (see `block_cache.hh`): the PC is
+/// translated once for the whole block, and the clock is advanced once at
+/// its end.  Only as many instructions of a block are run as fit before
+/// the next interrupt, so that every interrupt comes at the same
+/// instruction as when running one at a time.  If an instruction traps,
+/// the ones before it are accounted for, and the trap is handled as usual.
+/// From the end of a block, the next one in the same page is reached
+/// without translating the PC again.
+///
+/// With `USE_JIT`, blocks that run often are compiled to host code (see
+/// `jit.hh`), which runs them, or their first instructions, instead.
+///
+/// Computed `goto` is an extension of GCC, also supported by Clang.
+///
+/// DO NOT CHANGE -- part of the machine emulation
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "instruction.hh"
+#include "machine.hh"
+#include "threads/system.hh"
+
+#include <stdint.h>
+
+
+#ifdef THREADED_INTERPRETER
+
+/// Account for `count` more instructions fetched.
+static inline void
+CountFetches(unsigned count)
+{
+#ifdef USE_TLB
+    stats->numPageHits += count;
+#endif
+}
+
+/// How many of the first `length` instructions can run before the
+/// interrupt due at `deadline`.
+static inline unsigned
+Fit(unsigned length, unsigned long deadline)
+{
+    unsigned long now = stats->totalTicks;
+    if (now + length * USER_TICK < deadline) {
+        return length;
+    }
+    if (now + USER_TICK >= deadline) {
+        return 0;
+    }
+    return (deadline - now - 1) / USER_TICK;
+}
+
+void
+Machine::RunThreaded()
+{
+    static void *routines[NUM_HANDLERS];
+    static bool initialized = false;
+
+    if (!initialized) {
+        for (unsigned i = 0; i < NUM_HANDLERS; i++) {
+            routines[i] = &&other;
+        }
+        routines[OP_ADD]    = &&op_add;
+        routines[OP_ADDI]   = &&op_addi;
+        routines[OP_ADDIU]  = &&op_addiu;
+        routines[OP_ADDU]   = &&op_addu;
+        routines[OP_AND]    = &&op_and;
+        routines[OP_ANDI]   = &&op_andi;
+        routines[OP_BEQ]    = &&op_beq;
+        routines[OP_BGEZ]   = &&op_bgez;
+        routines[OP_BGEZAL] = &&op_bgezal;
+        routines[OP_BGTZ]   = &&op_bgtz;
+        routines[OP_BLEZ]   = &&op_blez;
+        routines[OP_BLTZ]   = &&op_bltz;
+        routines[OP_BLTZAL] = &&op_bltzal;
+        routines[OP_BNE]    = &&op_bne;
+        routines[OP_DIV]    = &&op_div;
+        routines[OP_DIVU]   = &&op_divu;
+        routines[OP_J]      = &&op_j;
+        routines[OP_JAL]    = &&op_jal;
+        routines[OP_JALR]   = &&op_jalr;
+        routines[OP_JR]     = &&op_jr;
+        routines[OP_LB]     = &&op_lb;
+        routines[OP_LBU]    = &&op_lbu;
+        routines[OP_LH]     = &&op_lh;
+        routines[OP_LHU]    = &&op_lhu;
+        routines[OP_LUI]    = &&op_lui;
+        routines[OP_LW]     = &&op_lw;
+        routines[OP_MFHI]   = &&op_mfhi;
+        routines[OP_MFLO]   = &&op_mflo;
+        routines[OP_MTHI]   = &&op_mthi;
+        routines[OP_MTLO]   = &&op_mtlo;
+        routines[OP_MULT]   = &&op_mult;
+        routines[OP_MULTU]  = &&op_multu;
+        routines[OP_NOR]    = &&op_nor;
+        routines[OP_OR]     = &&op_or;
+        routines[OP_ORI]    = &&op_ori;
+        routines[OP_SB]     = &&op_sb;
+        routines[OP_SH]     = &&op_sh;
+        routines[OP_SLL]    = &&op_sll;
+        routines[OP_SLLV]   = &&op_sllv;
+        routines[OP_SLT]    = &&op_slt;
+        routines[OP_SLTI]   = &&op_slti;
+        routines[OP_SLTIU]  = &&op_sltiu;
+        routines[OP_SLTU]   = &&op_sltu;
+        routines[OP_SRA]    = &&op_sra;
+        routines[OP_SRAV]   = &&op_srav;
+        routines[OP_SRL]    = &&op_srl;
+        routines[OP_SRLV]   = &&op_srlv;
+        routines[OP_SUB]    = &&op_sub;
+        routines[OP_SUBU]   = &&op_subu;
+        routines[OP_SW]     = &&op_sw;
+        routines[OP_SYSCALL] = &&op_syscall;
+        routines[OP_XOR]    = &&op_xor;
+        routines[OP_XORI]   = &&op_xori;
+        routines[FORM_NOP]  = &&form_nop;
+        routines[FORM_MOVE] = &&form_move;
+        routines[FORM_LI]   = &&form_li;
+        routines[FORM_B]    = &&form_b;
+        routines[FORM_BEQZ] = &&form_beqz;
+        routines[FORM_BNEZ] = &&form_bnez;
+        initialized = true;
+    }
+
+    const Instruction *instr;
+    unsigned long deadline = interrupt->GetDeadline();
+    unsigned long traps;
+    int pcAfter, nextLoadReg, nextLoadValue, sum, diff, tmp, value;
+    int64_t product;
+
+    // Tracing prints every instruction as it is fetched, so it needs them
+    // to be run one at a time.
+    bool useBlocks = !debug.IsEnabled('m');
+    BlockCache::Block *block = nullptr;  // The block being run, if any.
+    unsigned index = 0;  // Instruction of `block` being run.
+    unsigned limit = 0;  // Instructions of `block` to run.
+    unsigned physAddr, entryPage = 0, frameBase = 0;
+    unsigned long drops = 0;
+
+next:
+    blockCache->Collect();
+    traps = numTraps;
+    if (!useBlocks || singleStepper != nullptr
+          || registers[NEXT_PC_REG] != registers[PC_REG] + 4) {
+        instr = FetchInstruction();
+        if (instr == nullptr) {
+            goto done;
+        }
+        goto dispatch;
+    }
+
+    if (!TranslatePc(&physAddr)) {
+        goto done;
+    }
+    block = blockCache->Lookup(physAddr);
+    limit = Fit(block->length, deadline);
+    if (limit == 0) {
+        block = nullptr;
+        instr = decodeCache->Lookup(physAddr);
+        goto dispatch;
+    }
+    entryPage = (unsigned) registers[PC_REG] / PAGE_SIZE;
+    frameBase = physAddr - physAddr % PAGE_SIZE;
+    drops = blockCache->GetNumDrops();
+
+run_block:
+    index = 0;
+    blockDone = &index;
+#ifdef USE_JIT
+    if (limit == block->length) {
+        switch (jit->Run(block, registers, mmu, &index)) {
+            case Jit::FINISHED:
+                goto block_end;
+            case Jit::TRAPPED:
+                goto done;
+            case Jit::STOPPED:
+                if (blockCache->GetNumDrops() != drops) {
+                    goto code_changed;
+                }
+                break;
+        }
+    }
+#endif
+
+block_step:
+    instr = &block->ops[index];
+
+dispatch:
+    pcAfter = registers[NEXT_PC_REG] + 4;
+    goto *routines[instr->handler];
+
+    // Arithmetic and logic.
+
+op_add:
+    sum = registers[instr->rs] + registers[instr->rt];
+    if (!((registers[instr->rs] ^ registers[instr->rt]) & SIGN_BIT)
+          && (registers[instr->rs] ^ sum) & SIGN_BIT) {
+        RaiseException(OVERFLOW_EXCEPTION, 0);
+        goto done;
+    }
+    registers[instr->rd] = sum;
+    goto commit;
+
+op_addi:
+    sum = registers[instr->rs] + instr->extra;
+    if (!((registers[instr->rs] ^ instr->extra) & SIGN_BIT)
+          && (instr->extra ^ sum) & SIGN_BIT) {
+        RaiseException(OVERFLOW_EXCEPTION, 0);
+        goto done;
+    }
+    registers[instr->rt] = sum;
+    goto commit;
+
+op_addiu:
+    registers[instr->rt] = registers[instr->rs] + instr->extra;
+    goto commit;
+
+op_addu:
+    registers[instr->rd] = registers[instr->rs] + registers[instr->rt];
+    goto commit;
+
+op_and:
+    registers[instr->rd] = registers[instr->rs] & registers[instr->rt];
+    goto commit;
+
+op_andi:
+    registers[instr->rt] = registers[instr->rs] & (instr->extra & 0xFFFF);
+    goto commit;
+
+op_div:
+    if (registers[instr->rt] == 0) {
+        registers[LO_REG] = 0;
+        registers[HI_REG] = 0;
+    } else {
+        registers[LO_REG] = registers[instr->rs] / registers[instr->rt];
+        registers[HI_REG] = registers[instr->rs] % registers[instr->rt];
+    }
+    goto commit;
+
+op_divu:
+    if (registers[instr->rt] == 0) {
+        registers[LO_REG] = 0;
+        registers[HI_REG] = 0;
+    } else {
+        registers[LO_REG] = (unsigned) registers[instr->rs]
+                            / (unsigned) registers[instr->rt];
+        registers[HI_REG] = (unsigned) registers[instr->rs]
+                            % (unsigned) registers[instr->rt];
+    }
+    goto commit;
+
+op_lui:
+    DEBUG('m', "Executing: LUI r%d,%d\n", instr->rt, instr->extra);
+    registers[instr->rt] = instr->extra << 16;
+    goto commit;
+
+op_mfhi:
+    registers[instr->rd] = registers[HI_REG];
+    goto commit;
+
+op_mflo:
+    registers[instr->rd] = registers[LO_REG];
+    goto commit;
+
+op_mthi:
+    registers[HI_REG] = registers[instr->rs];
+    goto commit;
+
+op_mtlo:
+    registers[LO_REG] = registers[instr->rs];
+    goto commit;
+
+op_mult:
+    product = (int64_t) registers[instr->rs] * registers[instr->rt];
+    registers[HI_REG] = (int) (product >> 32);
+    registers[LO_REG] = (int) product;
+    goto commit;
+
+op_multu:
+    product = (int64_t) ((uint64_t) (unsigned) registers[instr->rs]
+                         * (unsigned) registers[instr->rt]);
+    registers[HI_REG] = (int) (product >> 32);
+    registers[LO_REG] = (int) product;
+    goto commit;
+
+op_nor:
+    registers[instr->rd] = ~(registers[instr->rs] | registers[instr->rt]);
+    goto commit;
+
+op_or:
+    registers[instr->rd] = registers[instr->rs] | registers[instr->rt];
+    goto commit;
+
+op_ori:
+    registers[instr->rt] = registers[instr->rs] | (instr->extra & 0xFFFF);
+    goto commit;
+
+op_sll:
+    registers[instr->rd] = registers[instr->rt] << instr->extra;
+    goto commit;
+
+op_sllv:
+    registers[instr->rd] = registers[instr->rt]
+                           << (registers[instr->rs] & 0x1F);
+    goto commit;
+
+op_slt:
+    registers[instr->rd] = registers[instr->rs] < registers[instr->rt];
+    goto commit;
+
+op_slti:
+    registers[instr->rt] = registers[instr->rs] < instr->extra;
+    goto commit;
+
+op_sltiu:
+    registers[instr->rt] = (unsigned) registers[instr->rs]
+                           < (unsigned) instr->extra;
+    goto commit;
+
+op_sltu:
+    registers[instr->rd] = (unsigned) registers[instr->rs]
+                           < (unsigned) registers[instr->rt];
+    goto commit;
+
+op_sra:
+    registers[instr->rd] = registers[instr->rt] >> instr->extra;
+    goto commit;
+
+op_srav:
+    registers[instr->rd] = registers[instr->rt]
+                           >> (registers[instr->rs] & 0x1F);
+    goto commit;
+
+op_srl:
+    // As in `ExecInstruction`, the value is shifted as a signed one.
+    tmp = registers[instr->rt];
+    registers[instr->rd] = tmp >> instr->extra;
+    goto commit;
+
+op_srlv:
+    tmp = registers[instr->rt];
+    registers[instr->rd] = tmp >> (registers[instr->rs] & 0x1F);
+    goto commit;
+
+op_sub:
+    diff = registers[instr->rs] - registers[instr->rt];
+    if ((registers[instr->rs] ^ registers[instr->rt]) & SIGN_BIT
+          && (registers[instr->rs] ^ diff) & SIGN_BIT) {
+        RaiseException(OVERFLOW_EXCEPTION, 0);
+        goto done;
+    }
+    registers[instr->rd] = diff;
+    goto commit;
+
+op_subu:
+    registers[instr->rd] = registers[instr->rs] - registers[instr->rt];
+    goto commit;
+
+op_xor:
+    registers[instr->rd] = registers[instr->rs] ^ registers[instr->rt];
+    goto commit;
+
+op_xori:
+    registers[instr->rt] = registers[instr->rs] ^ (instr->extra & 0xFFFF);
+    goto commit;
+
+form_nop:
+    goto commit;
+
+form_move:
+    registers[instr->rd] = registers[instr->rs];
+    goto commit;
+
+form_li:
+    registers[instr->rt] = instr->extra;
+    goto commit;
+
+    // Branches and jumps.
+
+op_beq:
+    if (registers[instr->rs] == registers[instr->rt]) {
+        pcAfter = registers[NEXT_PC_REG] + IndexToAddr(instr->extra);
+    }
+    goto commit;
+
+op_bgezal:
+    registers[RET_ADDR_REG] = registers[NEXT_PC_REG] + 4;
+op_bgez:
+    if (!(registers[instr->rs] & SIGN_BIT)) {
+        pcAfter = registers[NEXT_PC_REG] + IndexToAddr(instr->extra);
+    }
+    goto commit;
+
+op_bgtz:
+    if (registers[instr->rs] > 0) {
+        pcAfter = registers[NEXT_PC_REG] + IndexToAddr(instr->extra);
+    }
+    goto commit;
+
+op_blez:
+    if (registers[instr->rs] <= 0) {
+        pcAfter = registers[NEXT_PC_REG] + IndexToAddr(instr->extra);
+    }
+    goto commit;
+
+op_bltzal:
+    registers[RET_ADDR_REG] = registers[NEXT_PC_REG] + 4;
+op_bltz:
+    if (registers[instr->rs] & SIGN_BIT) {
+        pcAfter = registers[NEXT_PC_REG] + IndexToAddr(instr->extra);
+    }
+    goto commit;
+
+op_bne:
+    if (registers[instr->rs] != registers[instr->rt]) {
+        pcAfter = registers[NEXT_PC_REG] + IndexToAddr(instr->extra);
+    }
+    goto commit;
+
+form_b:
+    pcAfter = registers[NEXT_PC_REG] + IndexToAddr(instr->extra);
+    goto commit;
+
+form_beqz:
+    if (registers[instr->rs] == 0) {
+        pcAfter = registers[NEXT_PC_REG] + IndexToAddr(instr->extra);
+    }
+    goto commit;
+
+form_bnez:
+    if (registers[instr->rs] != 0) {
+        pcAfter = registers[NEXT_PC_REG] + IndexToAddr(instr->extra);
+    }
+    goto commit;
+
+op_jal:
+    registers[RET_ADDR_REG] = registers[NEXT_PC_REG] + 4;
+op_j:
+    pcAfter = (pcAfter & 0xF0000000) | IndexToAddr(instr->extra);
+    goto commit;
+
+op_jalr:
+    registers[instr->rd] = registers[NEXT_PC_REG] + 4;
+op_jr:
+    pcAfter = registers[instr->rs];
+    goto commit;
+
+    // Loads and stores.
+
+op_lb:
+    if (!ReadMem(registers[instr->rs] + instr->extra, 1, &value)) {
+        goto done;
+    }
+    nextLoadValue = (signed char) value;
+    goto commit_load;
+
+op_lbu:
+    if (!ReadMem(registers[instr->rs] + instr->extra, 1, &value)) {
+        goto done;
+    }
+    nextLoadValue = value & 0xFF;
+    goto commit_load;
+
+op_lh:
+    tmp = registers[instr->rs] + instr->extra;
+    if (tmp & 0x1) {
+        RaiseException(ADDRESS_ERROR_EXCEPTION, tmp);
+        goto done;
+    }
+    if (!ReadMem(tmp, 2, &value)) {
+        goto done;
+    }
+    nextLoadValue = (short) value;
+    goto commit_load;
+
+op_lhu:
+    tmp = registers[instr->rs] + instr->extra;
+    if (tmp & 0x1) {
+        RaiseException(ADDRESS_ERROR_EXCEPTION, tmp);
+        goto done;
+    }
+    if (!ReadMem(tmp, 2, &value)) {
+        goto done;
+    }
+    nextLoadValue = value & 0xFFFF;
+    goto commit_load;
+
+op_lw:
+    tmp = registers[instr->rs] + instr->extra;
+    if (tmp & 0x3) {
+        RaiseException(ADDRESS_ERROR_EXCEPTION, tmp);
+        goto done;
+    }
+    if (!ReadMem(tmp, 4, &value)) {
+        goto done;
+    }
+    nextLoadValue = value;
+    goto commit_load;
+
+op_sb:
+    if (!WriteMem((unsigned) (registers[instr->rs] + instr->extra),
+                  1, registers[instr->rt])) {
+        goto done;
+    }
+    goto commit;
+
+op_sh:
+    if (!WriteMem((unsigned) (registers[instr->rs] + instr->extra),
+                  2, registers[instr->rt])) {
+        goto done;
+    }
+    goto commit;
+
+op_sw:
+    if (!WriteMem((unsigned) (registers[instr->rs] + instr->extra),
+                  4, registers[instr->rt])) {
+        goto done;
+    }
+    goto commit;
+
+op_syscall:
+    RaiseException(SYSCALL_EXCEPTION, 0);
+    goto done;
+
+other:
+    ExecInstruction(instr);
+    if (numTraps != traps) {
+        goto done;
+    }
+    goto advanced;
+
+    // The instruction is done: do the delayed load, if any, and advance
+    // the program counters.
+
+commit_load:
+    nextLoadReg = instr->rt;
+    goto delayed_load;
+
+commit:
+    nextLoadReg = 0;
+    nextLoadValue = 0;
+
+delayed_load:
+    // What `DelayedLoad` does, without the call.
+    registers[registers[LOAD_REG]] = registers[LOAD_VALUE_REG];
+    registers[LOAD_REG] = nextLoadReg;
+    registers[LOAD_VALUE_REG] = nextLoadValue;
+    registers[0] = 0;
+
+    registers[PREV_PC_REG] = registers[PC_REG];
+    registers[PC_REG] = registers[NEXT_PC_REG];
+    registers[NEXT_PC_REG] = pcAfter;
+
+advanced:
+    if (block == nullptr) {
+        goto done;
+    }
+    index++;
+    if (index < limit) {
+        if (blockCache->GetNumDrops() == drops) {
+            goto block_step;
+        }
+        goto code_changed;
+    }
+    goto block_end;
+
+code_changed:
+    // The block wrote to code, maybe its own: fetch the rest again.
+    CountFetches(index - 1);
+    interrupt->UserTick(index);
+    block = nullptr;
+    blockDone = nullptr;
+    goto next;
+
+block_end:
+    // The block is done.  Go on to the next, if it is in the same page.
+    CountFetches(limit - 1);
+    interrupt->UserTick(limit);
+    if (limit == block->length && blockCache->GetNumDrops() == drops
+          && registers[NEXT_PC_REG] == registers[PC_REG] + 4
+          && (unsigned) registers[PC_REG] / PAGE_SIZE == entryPage
+          && registers[PC_REG] % 4 == 0) {
+        block = blockCache->Chain(block, frameBase
+                                         + registers[PC_REG] % PAGE_SIZE);
+        limit = Fit(block->length, deadline);
+        if (limit > 0) {
+            CountFetches(1);
+            goto run_block;
+        }
+    }
+    block = nullptr;
+    blockDone = nullptr;
+    goto next;
+
+    // Advance the clock, as `Run` does.
+
+done:
+    if (block != nullptr) {
+        // An instruction of the block trapped, and `RaiseException` has
+        // accounted for those before.
+        block = nullptr;
+    }
+    if (numTraps == traps && singleStepper == nullptr
+          && stats->totalTicks + USER_TICK < deadline) {
+        interrupt->UserTick();
+        goto next;
+    }
+    interrupt->OneTick();
+    deadline = interrupt->GetDeadline();
+    if (singleStepper != nullptr && !singleStepper->Step()) {
+        singleStepper = nullptr;
+    }
+    goto next;
+}
+
+#endif
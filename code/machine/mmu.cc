@@ -20,6 +20,11 @@
 /// Note that the contents of the TLB are specific to an address space.
 /// If the address space changes, so does the contents of the TLB!
 ///
+/// Translations that have been done once are also kept in a host TLB, which
+/// maps virtual pages straight to simulated physical memory, so that loads
+/// and stores to them skip the lookup.  It is not part of the simulated
+/// machine: the kernel only has to flush it when it changes translations.
+///
 /// DO NOT CHANGE -- part of the machine emulation
 ///
 /// Copyright (c) 1992-1993 The Regents of the University of California.
@@ -50,7 +55,7 @@ MMU::MMU(unsigned aNumPhysPages)
     tlb = nullptr;
     pageTable = nullptr;
 #endif
-   
+    FlushHostTlb();
 }
 
 MMU::~MMU()
@@ -60,6 +65,95 @@ MMU::~MMU()
     }
 }
 
+void
+MMU::FlushHostTlb()
+{
+    for (unsigned i = 0; i < HOST_TLB_SIZE; i++) {
+        hostTlb[i].readPage  = NO_PAGE;
+        hostTlb[i].writePage = NO_PAGE;
+    }
+}
+
+void
+MMU::FlushHostTlbPage(unsigned vpn)
+{
+    HostEntry *h = &hostTlb[vpn % HOST_TLB_SIZE];
+    if (h->readPage == vpn) {
+        h->readPage  = NO_PAGE;
+        h->writePage = NO_PAGE;
+    }
+}
+
+void
+MMU::FlushHostTlbFrame(unsigned frame)
+{
+    char *memory = &machine->mainMemory[frame * PAGE_SIZE];
+    for (unsigned i = 0; i < HOST_TLB_SIZE; i++) {
+        if (hostTlb[i].readPage != NO_PAGE && hostTlb[i].memory == memory) {
+            hostTlb[i].readPage  = NO_PAGE;
+            hostTlb[i].writePage = NO_PAGE;
+        }
+    }
+}
+
+void
+MMU::FillHostTlb(unsigned vpn, const TranslationEntry *entry)
+{
+    if (debug.IsEnabled('a')) {
+        return;
+    }
+
+    HostEntry *h = &hostTlb[vpn % HOST_TLB_SIZE];
+    h->readPage  = vpn;
+    h->writePage = entry->dirty && !entry->readOnly ? vpn : NO_PAGE;
+    h->memory    = &machine->mainMemory[entry->physicalPage * PAGE_SIZE];
+}
+
+/// Read `size` (1, 2, or 4) bytes at `p`, in the byte order of the
+/// simulated machine.
+static inline int
+LoadHost(const char *p, unsigned size)
+{
+    switch (size) {
+        case 1:
+            return *p;
+
+        case 2:
+            return ShortToHost(*(const unsigned short *) p);
+
+        case 4:
+            return WordToHost(*(const unsigned *) p);
+
+        default:
+            ASSERT(false);
+            return 0;
+    }
+}
+
+/// Write the lower `size` (1, 2, or 4) bytes of `value` at `p`, in the byte
+/// order of the simulated machine.
+static inline void
+StoreHost(char *p, unsigned size, int value)
+{
+    switch (size) {
+        case 1:
+            *p = (unsigned char) (value & 0xFF);
+            break;
+
+        case 2:
+            *(unsigned short *) p
+              = ShortToMachine((unsigned short) (value & 0xFFFF));
+            break;
+
+        case 4:
+            *(unsigned *) p = WordToMachine((unsigned) value);
+            break;
+
+        default:
+            ASSERT(false);
+    }
+}
+
 void
 MMU::PrintTLB() const
 {
@@ -92,6 +186,13 @@ MMU::ReadMem(unsigned addr, unsigned size, int *value)
 {
     ASSERT(value != nullptr);
 
+    // Misaligned accesses are left to `Translate`, which rejects them.
+    const HostEntry *h = &hostTlb[addr / PAGE_SIZE % HOST_TLB_SIZE];
+    if (h->readPage == addr / PAGE_SIZE && (addr & (size - 1)) == 0) {
+        *value = LoadHost(h->memory + addr % PAGE_SIZE, size);
+        return NO_EXCEPTION;
+    }
+
     DEBUG('a', "Reading VA 0x%X, size %u\n", addr, size);
 
     unsigned physicalAddress;
@@ -100,26 +201,7 @@ MMU::ReadMem(unsigned addr, unsigned size, int *value)
         return e;
     }
 
-    int data;
-    switch (size) {
-        case 1:
-            data = machine->mainMemory[physicalAddress];
-            *value = data;
-            break;
-
-        case 2:
-            data = *(unsigned short *) &(machine->mainMemory[physicalAddress]);
-            *value = ShortToHost(data);
-            break;
-
-        case 4:
-            data = *(unsigned *) &(machine->mainMemory[physicalAddress]);
-            *value = WordToHost(data);
-            break;
-
-        default:
-            ASSERT(false);
-    }
+    *value = LoadHost(&machine->mainMemory[physicalAddress], size);
 
     DEBUG('a', "\tValue read: %8.8X\n", *value);
     return NO_EXCEPTION;
@@ -137,35 +219,41 @@ MMU::ReadMem(unsigned addr, unsigned size, int *value)
 ExceptionType
 MMU::WriteMem(unsigned addr, unsigned size, int value)
 {
+    unsigned physicalAddress;
+
+    const HostEntry *h = &hostTlb[addr / PAGE_SIZE % HOST_TLB_SIZE];
+    if (h->writePage == addr / PAGE_SIZE && (addr & (size - 1)) == 0) {
+        StoreHost(h->memory + addr % PAGE_SIZE, size, value);
+        physicalAddress = h->memory - machine->mainMemory + addr % PAGE_SIZE;
+        machine->InvalidateCode(physicalAddress, size);
+        return NO_EXCEPTION;
+    }
+
     DEBUG('a', "Writing VA 0x%X, size %u, value 0x%X\n", addr, size, value);
 
-    unsigned physicalAddress;
     ExceptionType e = Translate(addr, &physicalAddress, size, true);
     if (e != NO_EXCEPTION) {
         return e;
     }
 
-    switch (size) {
-        case 1:
-            machine->mainMemory[physicalAddress]
-              = (unsigned char) (value & 0xFF);
-            break;
-
-        case 2:
-            *(unsigned short *) &(machine->mainMemory[physicalAddress])
-              = ShortToMachine((unsigned short) (value & 0xFFFF));
-            break;
+    StoreHost(&machine->mainMemory[physicalAddress], size, value);
+    machine->InvalidateCode(physicalAddress, size);
 
-        case 4:
-            *(unsigned *) &(machine->mainMemory[physicalAddress])
-              = WordToMachine((unsigned) value);
-            break;
+    return NO_EXCEPTION;
+}
 
-        default:
-            ASSERT(false);
+ExceptionType
+MMU::TranslateFetch(unsigned addr, unsigned *physAddr)
+{
+    const HostEntry *h = &hostTlb[addr / PAGE_SIZE % HOST_TLB_SIZE];
+    if (h->readPage == addr / PAGE_SIZE && (addr & 0x3) == 0) {
+        *physAddr = h->memory - machine->mainMemory + addr % PAGE_SIZE;
+        return NO_EXCEPTION;
     }
 
-    return NO_EXCEPTION;
+    DEBUG('a', "Fetching VA 0x%X\n", addr);
+
+    return Translate(addr, physAddr, 4, false);
 }
 
 ExceptionType
@@ -272,6 +360,8 @@ MMU::Translate(unsigned virtAddr, unsigned *physAddr,
         entry->dirty = true;
     }
 
+    FillHostTlb(vpn, entry);
+
     *physAddr = pageFrame * PAGE_SIZE + offset;
     ASSERT(*physAddr >= 0 && *physAddr + size <= memorySize);
     DEBUG_CONT('a', "physical address 0x%X\n", *physAddr);
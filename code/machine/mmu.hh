@@ -31,6 +31,9 @@ const unsigned TLB_SIZE = 4;
 /// This class simulates an MMU (memory management unit) that can use either
 /// page tables or a TLB.
 class MMU {
+    /// Compiled code (see `jit.hh`) looks up `hostTlb` by itself.
+    friend class Jit;
+
 public:
     // Initialize the MMU subsystem.
     MMU(unsigned numPhysicalPages);
@@ -45,6 +48,20 @@ public:
 
     ExceptionType WriteMem(unsigned addr, unsigned size, int value);
 
+    /// Translate the address `addr` of an instruction to fetch into
+    /// `physAddr`, checking it as a read of a word would be.
+    ExceptionType TranslateFetch(unsigned addr, unsigned *physAddr);
+
+    /// Forget what the host TLB (see below) keeps: everything, what it
+    /// keeps for virtual page `vpn`, or for physical page `frame`.
+    ///
+    /// The kernel must call one of these whenever it changes the TLB or the
+    /// page table, takes a frame from a page, or clears the `use` or `dirty`
+    /// bit of an entry.
+    void FlushHostTlb();
+    void FlushHostTlbPage(unsigned vpn);
+    void FlushHostTlbFrame(unsigned frame);
+
     void PrintTLB() const;
 
     /// Data structures -- all of these are accessible to Nachos kernel code.
@@ -92,6 +109,33 @@ private:
     /// completed.
     ExceptionType Translate(unsigned virtAddr, unsigned *physAddr,
                             unsigned size, bool writing);
+
+    /// Keep the translation of virtual page `vpn`, given by `entry`, in the
+    /// host TLB.
+    void FillHostTlb(unsigned vpn, const TranslationEntry *entry);
+
+    /// The host TLB is a direct-mapped cache from virtual page numbers to
+    /// where the page is in `mainMemory`, so that most loads and stores
+    /// need neither `Translate` nor a TLB lookup.
+    ///
+    /// A page is only kept for reading once the `use` bit of its entry is
+    /// set, and for writing once `dirty` is set too and it is not
+    /// read-only; so going through `Translate` instead would not change
+    /// anything the kernel can see.  Nothing is kept while tracing
+    /// translations (debug flag `a`), so that they are all printed.
+    struct HostEntry {
+        unsigned readPage;   ///< Page that `memory` may be read for, or
+                             ///< `NO_PAGE`.
+        unsigned writePage;  ///< Page that `memory` may be written for, or
+                             ///< `NO_PAGE`.
+        char *memory;        ///< Start of the frame of the page.
+    };
+
+    static const unsigned HOST_TLB_SIZE = 32;  ///< Must be a power of 2.
+    static const unsigned NO_PAGE = (unsigned) -1;
+
+    HostEntry hostTlb[HOST_TLB_SIZE];
+
     unsigned memorySize;
     unsigned numPhysicalPages;
 };
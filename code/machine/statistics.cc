@@ -21,6 +21,12 @@ Statistics::Statistics()
     numDiskReads = numDiskWrites = 0;
     numConsoleCharsRead = numConsoleCharsWritten = 0;
     numPageFaults = 0;
+    numContextSwitches = 0;
+    numCpus = 1;
+    for (unsigned i = 0; i < MAX_CPUS; i++) {
+        cpuSystemTicks[i] = cpuUserTicks[i] = cpuMigrations[i] = 0;
+    }
+    realTimeJobs = deadlineMisses = 0;
 #ifdef DFS_TICKS_FIX
     tickResets = 0;
 #endif
@@ -44,8 +50,13 @@ Statistics::Print()
                " statistics may be invalid.\n\n", tickResets);
     }
 #endif
-    printf("Ticks: total %lu, idle %lu, system %lu, user %lu\n",
-           totalTicks, idleTicks, systemTicks, userTicks);
+    if (numCpus > 1) {
+        // System and user time are given for each CPU, below.
+        printf("Ticks: total %lu, idle %lu\n", totalTicks, idleTicks);
+    } else {
+        printf("Ticks: total %lu, idle %lu, system %lu, user %lu\n",
+               totalTicks, idleTicks, systemTicks, userTicks);
+    }
     printf("Disk I/O: reads %lu, writes %lu\n", numDiskReads, numDiskWrites);
     printf("Console I/O: reads %lu, writes %lu\n",
            numConsoleCharsRead, numConsoleCharsWritten);
@@ -55,6 +66,22 @@ Statistics::Print()
 #else
     printf("\n");
 #endif
+    printf("Context switches: %lu\n", numContextSwitches);
+    if (numCpus > 1) {
+        for (unsigned i = 0; i < numCpus; i++) {
+            unsigned long busy = cpuSystemTicks[i] + cpuUserTicks[i];
+            printf("CPU %u: system %lu, user %lu, idle %lu ticks"
+                   " (busy %.1f%%), migrations in %lu\n",
+                   i, cpuSystemTicks[i], cpuUserTicks[i],
+                   totalTicks > busy ? totalTicks - busy : 0,
+                   totalTicks ? 100.0 * busy / totalTicks : 0.0,
+                   cpuMigrations[i]);
+        }
+    }
+    if (realTimeJobs > 0) {
+        printf("Real-time jobs: %lu, deadline misses %lu\n",
+               realTimeJobs, deadlineMisses);
+    }
 #ifdef USE_SWAP
     printf("Swap: sent to swap %lu, brought back %lu\n", numSwapIn, numSwapOut);
 #endif
@@ -11,6 +11,9 @@
 #define NACHOS_MACHINE_STATS__HH
 
 
+/// Most virtual CPUs that can be simulated.
+const unsigned MAX_CPUS = 8;
+
 /// The following class defines the statistics that are to be kept about
 /// Nachos behavior -- how much time (ticks) elapsed, how many user
 /// instructions executed, etc.
@@ -26,6 +29,10 @@ public:
     unsigned long idleTicks;
 
     /// Time spent executing system code.
+    ///
+    /// With several CPUs, this and `userTicks` add up the time of all of
+    /// them, so they are not comparable to `totalTicks`; see the per-CPU
+    /// counters instead.
     unsigned long systemTicks;
 
     /// Time spent executing user code (this is also equal to # of user
@@ -47,6 +54,22 @@ public:
     /// Number of virtual memory page faults.
     unsigned long numPageFaults;
 
+    /// Number of times the CPU was switched from one thread to another.
+    unsigned long numContextSwitches;
+
+    /// Number of virtual CPUs, and for each of them, time spent running
+    /// system and user code, and number of threads that were moved to it
+    /// from another CPU.
+    unsigned numCpus;
+    unsigned long cpuSystemTicks[MAX_CPUS];
+    unsigned long cpuUserTicks[MAX_CPUS];
+    unsigned long cpuMigrations[MAX_CPUS];
+
+    /// Number of jobs of real-time threads released, and of those that
+    /// missed their deadline.
+    unsigned long realTimeJobs;
+    unsigned long deadlineMisses;
+
 #ifdef USE_TLB
     /// Number of virtual memory page hits.
     unsigned long numPageHits;
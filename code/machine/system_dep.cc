@@ -395,4 +395,26 @@ DeallocBoundedArray(const char *ptr, unsigned size)
     delete [] (ptr - pgSize);
 }
 
+/// Return `size` bytes of memory that can be written and executed, for
+/// code generated at run time, or null if the host refuses to map it.
+char *
+AllocExecutable(unsigned size)
+{
+    ASSERT(size > 0);
+
+    void *ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE | PROT_EXEC,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    return ptr == MAP_FAILED ? nullptr : (char *) ptr;
+}
+
+/// Unmap memory returned by `AllocExecutable`.
+void
+DeallocExecutable(char *ptr, unsigned size)
+{
+    ASSERT(ptr != nullptr);
+    ASSERT(size > 0);
+
+    munmap(ptr, size);
+}
+
 };
@@ -64,6 +64,13 @@ namespace SystemDep {
     char *AllocBoundedArray(unsigned size);
 
     void DeallocBoundedArray(const char *p, unsigned size);
+
+    /// Allocate, de-allocate memory that host code can be written to and
+    /// then run from.  Returns null if the host does not allow it.
+
+    char *AllocExecutable(unsigned size);
+
+    void DeallocExecutable(char *p, unsigned size);
 };
 
 
@@ -47,21 +47,70 @@ Timer::Timer(VoidFunctionPtr timerHandler, void *callArg, bool doRandom)
     randomize = doRandom;
     handler   = timerHandler;
     arg       = callArg;
+    periodic  = false;
+    armed     = false;
+    due       = 0;
 
     // Schedule the first interrupt from the timer device.
+    Start();
+}
+
+void
+Timer::Start()
+{
+    if (periodic) {
+        return;
+    }
+    Stop();
     interrupt->Schedule(TimerHandler, this, TimeOfNextInterrupt(),
                         TIMER_INT);
+    periodic = armed = true;
+}
+
+void
+Timer::StartOnce(unsigned long ticks)
+{
+    ASSERT(ticks > 0);
+
+    unsigned long when = stats->totalTicks + ticks;
+    if (armed && !periodic && due == when) {
+        return;  // Already set for then.
+    }
+    Stop();
+    interrupt->Schedule(TimerHandler, this, ticks, TIMER_INT);
+    armed = true;
+    due   = when;
+}
+
+void
+Timer::Stop()
+{
+    if (armed) {
+        interrupt->Cancel(TimerHandler, this);
+    }
+    periodic = armed = false;
+}
+
+bool
+Timer::IsPeriodic() const
+{
+    return periodic;
 }
 
 /// Routine to simulate the interrupt generated by the hardware timer device.
 ///
-/// Schedule the next interrupt, and invoke the interrupt handler.
+/// Schedule the next interrupt, if periodic, and invoke the interrupt
+/// handler.
 void
 Timer::TimerExpired()
 {
     // Schedule the next timer device interrupt.
-    interrupt->Schedule(TimerHandler, this, TimeOfNextInterrupt(),
-                        TIMER_INT);
+    armed = false;
+    if (periodic) {
+        interrupt->Schedule(TimerHandler, this, TimeOfNextInterrupt(),
+                            TIMER_INT);
+        armed = true;
+    }
 
     // Invoke the Nachos interrupt handler for this device.
     (*handler)(arg);
@@ -69,11 +118,13 @@ Timer::TimerExpired()
 
 /// Return when the hardware timer device will next cause an interrupt.
 ///
-/// If `randomize` is turned on, make it a (pseudo-)random delay.
+/// If `randomize` is turned on, make it a (pseudo-)random delay.  Not when
+/// the delays are being replayed, though: they would be replaced anyway,
+/// and drawing them would disturb the other users of the generator.
 int
 Timer::TimeOfNextInterrupt()
 {
-    if (randomize) {
+    if (randomize && !interrupt->IsReplaying()) {
         return 1 + SystemDep::Random() % (TIMER_TICKS * 2);
     } else {
         return TIMER_TICKS;
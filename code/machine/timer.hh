@@ -10,6 +10,10 @@
 /// In order to introduce some randomness into time-slicing, if `doRandom` is
 /// set, then the interrupt comes after a random number of ticks.
 ///
+/// The timer starts out periodic.  It can be stopped, and restarted, or set
+/// to interrupt just once at a given time, like the one-shot mode of real
+/// timer chips.
+///
 /// DO NOT CHANGE -- part of the machine emulation
 ///
 /// Copyright (c) 1992-1993 The Regents of the University of California.
@@ -34,6 +38,19 @@ public:
 
     ~Timer() {}
 
+    /// Interrupt every time slice, starting a time slice from now.  Does
+    /// nothing if the timer is already periodic.
+    void Start();
+
+    /// Interrupt once, `ticks` from now, and then stop.
+    void StartOnce(unsigned long ticks);
+
+    /// Stop interrupting.
+    void Stop();
+
+    /// Is the timer interrupting every time slice?
+    bool IsPeriodic() const;
+
     /// Internal routines to the timer emulation -- DO NOT call these.
 
     /// Called internally when the hardware timer generates an interrupt.
@@ -46,6 +63,11 @@ private:
     bool randomize;  ///< Set if we need to use a random timeout delay.
     VoidFunctionPtr handler;  ///< Timer interrupt handler.
     void *arg;  ///< Argument to pass to interrupt handler.
+    bool periodic;  ///< Set if the next interrupt is to be followed by
+                    ///< others.
+    bool armed;  ///< Set if an interrupt is scheduled.
+    unsigned long due;  ///< When the interrupt is scheduled for, if armed
+                        ///< and not periodic.
 
 };
 
@@ -0,0 +1,217 @@
+/// Routines to manage the timer wheel of software alarms.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "alarm.hh"
+#include "system.hh"
+
+#include <stdio.h>
+
+
+static const unsigned SLOT_MASK = ALARM_SLOTS - 1;
+
+/// Number of jiffies covered by the whole wheel.
+static const unsigned long WHEEL_SPAN
+  = 1UL << (ALARM_LEVELS * ALARM_SLOT_BITS);
+
+AlarmEntry::AlarmEntry(VoidFunctionPtr func, void *arg_)
+{
+    ASSERT(func != nullptr);
+
+    handler = func;
+    arg     = arg_;
+    expires = 0;
+    slot    = nullptr;
+    next    = prev = nullptr;
+}
+
+AlarmEntry::~AlarmEntry()
+{
+    ASSERT(slot == nullptr);
+}
+
+bool
+AlarmEntry::IsSet() const
+{
+    return slot != nullptr;
+}
+
+Alarm::Alarm()
+{
+    for (unsigned level = 0; level < ALARM_LEVELS; level++) {
+        for (unsigned i = 0; i < ALARM_SLOTS; i++) {
+            wheel[level][i] = nullptr;
+        }
+    }
+    jiffies = stats->totalTicks / TIMER_TICKS;
+    count   = 0;
+}
+
+/// Arm `entry`.
+///
+/// The expiry time is rounded up to a whole jiffy, and to the next one at
+/// least, because the alarms of the current jiffy have been fired already.
+///
+/// * `entry` must not be set.
+/// * `ticks` is the delay, in ticks.
+void
+Alarm::Set(AlarmEntry *entry, unsigned long ticks)
+{
+    ASSERT(entry != nullptr);
+    ASSERT(entry->slot == nullptr);
+    ASSERT(interrupt->GetLevel() == INT_OFF);
+
+    unsigned long when = stats->totalTicks + ticks;
+    entry->expires = (when + TIMER_TICKS - 1) / TIMER_TICKS;
+    if (entry->expires <= jiffies) {
+        entry->expires = jiffies + 1;
+    }
+
+    DEBUG('i', "Setting alarm to go off at jiffy %lu (tick %lu)\n",
+          entry->expires, when);
+
+    Insert(entry);
+    count++;
+    UpdateTimer();
+}
+
+void
+Alarm::Cancel(AlarmEntry *entry)
+{
+    ASSERT(entry != nullptr);
+    ASSERT(interrupt->GetLevel() == INT_OFF);
+
+    if (entry->slot != nullptr) {
+        Unlink(entry);
+        count--;
+    }
+}
+
+/// Advance the wheel up to the current time, one jiffy at a time.
+///
+/// At every jiffy, if level 0 wraps around, the next slot of level 1 is
+/// cascaded into it, and so on upwards; then the alarms in the slot of the
+/// jiffy are fired.  Handlers may set new alarms.
+void
+Alarm::Tick()
+{
+    ASSERT(interrupt->GetLevel() == INT_OFF);
+
+    unsigned long now = stats->totalTicks / TIMER_TICKS;
+
+    while (jiffies < now) {
+        jiffies++;
+
+        for (unsigned level = 1; level < ALARM_LEVELS; level++) {
+            unsigned shift = (level - 1) * ALARM_SLOT_BITS;
+            if (((jiffies >> shift) & SLOT_MASK) != 0) {
+                break;
+            }
+            Cascade(level, (jiffies >> (shift + ALARM_SLOT_BITS)) & SLOT_MASK);
+        }
+
+        AlarmEntry **slot = &wheel[0][jiffies & SLOT_MASK];
+        while (*slot != nullptr) {
+            AlarmEntry *entry = *slot;
+            ASSERT(entry->expires == jiffies);
+            Unlink(entry);
+            count--;
+            DEBUG('i', "Alarm going off at jiffy %lu\n", jiffies);
+            entry->handler(entry->arg);
+        }
+    }
+}
+
+bool
+Alarm::IsPending() const
+{
+    return count > 0;
+}
+
+/// Level 0 holds the alarms of the next `ALARM_SLOTS` jiffies, one per
+/// slot, and the other levels only cascade at multiples of `ALARM_SLOTS`, so
+/// scanning level 0 up to the next such multiple is enough.
+bool
+Alarm::GetNextJiffy(unsigned long *jiffy) const
+{
+    ASSERT(jiffy != nullptr);
+
+    if (count == 0) {
+        return false;
+    }
+    unsigned long j = jiffies + 1;
+    while (wheel[0][j & SLOT_MASK] == nullptr && (j & SLOT_MASK) != 0) {
+        j++;
+    }
+    *jiffy = j;
+    return true;
+}
+
+void
+Alarm::Print() const
+{
+    printf("Alarms set: %u, at jiffy %lu\n", count, jiffies);
+}
+
+/// Choose the lowest level whose span covers the distance to the expiry
+/// time.  Alarms further away than the whole wheel go to the top level, and
+/// are redistributed there every time their slot comes up until they fit.
+void
+Alarm::Insert(AlarmEntry *entry)
+{
+    ASSERT(entry->expires >= jiffies);
+
+    unsigned long delta = entry->expires - jiffies;
+    unsigned long expires = delta < WHEEL_SPAN
+                            ? entry->expires : jiffies + WHEEL_SPAN - 1;
+
+    unsigned level = 0;
+    while (level < ALARM_LEVELS - 1
+             && delta >= 1UL << ((level + 1) * ALARM_SLOT_BITS)) {
+        level++;
+    }
+    unsigned index = (expires >> (level * ALARM_SLOT_BITS)) & SLOT_MASK;
+
+    AlarmEntry **slot = &wheel[level][index];
+    entry->slot = slot;
+    entry->prev = nullptr;
+    entry->next = *slot;
+    if (*slot != nullptr) {
+        (*slot)->prev = entry;
+    }
+    *slot = entry;
+}
+
+void
+Alarm::Unlink(AlarmEntry *entry)
+{
+    ASSERT(entry->slot != nullptr);
+
+    if (entry->prev == nullptr) {
+        *entry->slot = entry->next;
+    } else {
+        entry->prev->next = entry->next;
+    }
+    if (entry->next != nullptr) {
+        entry->next->prev = entry->prev;
+    }
+    entry->slot = nullptr;
+    entry->next = entry->prev = nullptr;
+}
+
+void
+Alarm::Cascade(unsigned level, unsigned index)
+{
+    AlarmEntry *entry = wheel[level][index];
+    wheel[level][index] = nullptr;
+
+    while (entry != nullptr) {
+        AlarmEntry *next = entry->next;
+        entry->slot = nullptr;
+        Insert(entry);
+        entry = next;
+    }
+}
@@ -0,0 +1,109 @@
+/// Software alarms: run a function, or wake a thread, after some ticks.
+///
+/// Pending alarms are kept in a hierarchical timer wheel, advanced from the
+/// timer device interrupt.  Time is counted in *jiffies*, one per
+/// `TIMER_TICKS`, so an alarm goes off at the first timer interrupt at or
+/// after its expiry time, never earlier.
+///
+/// The wheel has `ALARM_LEVELS` levels of `ALARM_SLOTS` slots each.  Level 0
+/// holds the alarms due within the next `ALARM_SLOTS` jiffies, one slot per
+/// jiffy; each slot of level `k` spans `ALARM_SLOTS^k` jiffies.  Whenever
+/// the lower level wraps around, the next slot of the level above is
+/// *cascaded*: its alarms are redistributed downwards.  Setting and
+/// cancelling an alarm are O(1), and so is advancing the wheel, amortized.
+///
+/// Every method is called with interrupts disabled.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_THREADS_ALARM__HH
+#define NACHOS_THREADS_ALARM__HH
+
+
+#include "lib/utility.hh"
+
+
+const unsigned ALARM_SLOT_BITS = 6;
+const unsigned ALARM_SLOTS     = 1 << ALARM_SLOT_BITS;
+const unsigned ALARM_LEVELS    = 4;
+
+/// A pending alarm.
+///
+/// The caller owns the storage (for a sleeping thread, its own stack), so
+/// arming an alarm does not allocate.  It must not be destroyed while set.
+class AlarmEntry {
+    friend class Alarm;
+public:
+
+    /// Call `func(arg)` when the alarm goes off.
+    AlarmEntry(VoidFunctionPtr func, void *arg);
+
+    ~AlarmEntry();
+
+    /// Is the alarm set and not yet gone off?
+    bool IsSet() const;
+
+private:
+
+    VoidFunctionPtr handler;
+    void *arg;
+
+    /// Jiffy at which the alarm goes off.
+    unsigned long expires;
+
+    /// Links within its slot; `slot` is null while the alarm is not set.
+    AlarmEntry **slot;
+    AlarmEntry *next;
+    AlarmEntry *prev;
+};
+
+class Alarm {
+public:
+
+    Alarm();
+
+    /// Make `entry` go off `ticks` ticks from now.
+    void Set(AlarmEntry *entry, unsigned long ticks);
+
+    /// Disarm `entry`, if it is set.
+    void Cancel(AlarmEntry *entry);
+
+    /// Fire every alarm that is due by now.  Called from the timer
+    /// interrupt handler.
+    void Tick();
+
+    /// Are there alarms set?  While there are, an idle machine must keep
+    /// waiting for timer interrupts instead of halting.
+    bool IsPending() const;
+
+    /// Store in `jiffy` the first jiffy at which an alarm may go off, or
+    /// the wheel needs cascading, so that the timer can be left alone until
+    /// then.  Returns false if no alarm is set.
+    bool GetNextJiffy(unsigned long *jiffy) const;
+
+    void Print() const;
+
+private:
+
+    /// Put `entry` in the slot for its expiry, relative to `jiffies`.
+    void Insert(AlarmEntry *entry);
+
+    /// Unlink `entry` from its slot.
+    void Unlink(AlarmEntry *entry);
+
+    /// Redistribute the alarms in slot `index` of `level` downwards.
+    void Cascade(unsigned level, unsigned index);
+
+    AlarmEntry *wheel[ALARM_LEVELS][ALARM_SLOTS];
+
+    /// Last jiffy whose alarms have been fired.
+    unsigned long jiffies;
+
+    /// Number of alarms set.
+    unsigned count;
+};
+
+
+#endif
@@ -1,21 +1,33 @@
+/// Routines for message passing between threads.
+///
+/// Every operation runs with interrupts disabled, like `Semaphore`: on a
+/// uniprocessor that is enough for atomicity, and it saves the context
+/// switches that a lock and a pair of semaphores per message would cost.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
 #include "channel.hh"
+#include "system.hh"
+
 
-Channel::Channel(const char *debugName)
+Channel::Channel(const char *debugName, unsigned ringCapacity)
 {
     name = debugName;
-    buffer = new int;
-    semReceive = new Semaphore("semReceive", 0);
-    semSend = new Semaphore("semSend", 0);
-    lockReceive = new Lock("lockReceive");
-    lockSend = new Lock("lockSend");
+    capacity = ringCapacity;
+    ring = capacity > 0 ? new int [capacity] : nullptr;
+    head = 0;
+    count = 0;
+    senders = lastSender = nullptr;
+    receivers = lastReceiver = nullptr;
 }
 
 Channel::~Channel()
 {
-    delete semReceive;
-    delete semSend;
-    delete lockReceive;
-    delete lockSend;
+    ASSERT(senders == nullptr && receivers == nullptr);
+    delete [] ring;
 }
 
 const char *
@@ -24,24 +36,304 @@ Channel::GetName() const
     return name;
 }
 
+unsigned
+Channel::GetCapacity() const
+{
+    return capacity;
+}
+
+unsigned
+Channel::GetCount() const
+{
+    return count;
+}
+
 void
 Channel::Send(int message)
 {
-    lockSend->Acquire();
-    *buffer = message;
-    DEBUG('c', "Emisor send %d.\n", message);
-    semSend->V();
-    semReceive->P();
-    lockSend->Release();
+    IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
+
+    DEBUG('c', "Sending %d on channel \"%s\".\n", message, name);
+    if (Put(&message, 1) == 0) {
+        Waiter w;
+        w.messages = &message;
+        w.count = 1;
+        Wait(&w, &senders, &lastSender);
+    }
+
+    interrupt->SetLevel(oldLevel);
 }
 
 void
 Channel::Receive(int *message)
 {
-    lockReceive->Acquire();
-    semSend->P();
-    *message = *buffer;
-    DEBUG('c', "Receptor received %d.\n", *message);
-    semReceive->V();
-    lockReceive->Release();
-}
\ No newline at end of file
+    ASSERT(message != nullptr);
+
+    IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
+
+    if (Get(message, 1) == 0) {
+        Waiter w;
+        w.messages = message;
+        w.count = 1;
+        Wait(&w, &receivers, &lastReceiver);
+    }
+    DEBUG('c', "Received %d on channel \"%s\".\n", *message, name);
+
+    interrupt->SetLevel(oldLevel);
+}
+
+/// Whatever cannot be moved right away waits in a single record, which
+/// receivers drain in place; the messages are only read.
+void
+Channel::SendN(const int *messages, unsigned n)
+{
+    ASSERT(messages != nullptr || n == 0);
+
+    IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
+
+    DEBUG('c', "Sending %u messages on channel \"%s\".\n", n, name);
+    unsigned sent = Put(messages, n);
+    if (sent < n) {
+        Waiter w;
+        w.messages = (int *) messages + sent;
+        w.count = n - sent;
+        Wait(&w, &senders, &lastSender);
+    }
+
+    interrupt->SetLevel(oldLevel);
+}
+
+void
+Channel::ReceiveN(int *messages, unsigned n)
+{
+    ASSERT(messages != nullptr || n == 0);
+
+    IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
+
+    unsigned received = Get(messages, n);
+    if (received < n) {
+        Waiter w;
+        w.messages = messages + received;
+        w.count = n - received;
+        Wait(&w, &receivers, &lastReceiver);
+    }
+    DEBUG('c', "Received %u messages on channel \"%s\".\n", n, name);
+
+    interrupt->SetLevel(oldLevel);
+}
+
+bool
+Channel::TrySend(int message)
+{
+    IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
+    bool sent = Put(&message, 1) == 1;
+    interrupt->SetLevel(oldLevel);
+    return sent;
+}
+
+bool
+Channel::TryReceive(int *message)
+{
+    ASSERT(message != nullptr);
+
+    IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
+    bool received = Get(message, 1) == 1;
+    interrupt->SetLevel(oldLevel);
+    return received;
+}
+
+/// Queue one record on each channel, all sharing the same `done` flag and
+/// pointing at `message`, and sleep until a sender serves one of them.  The
+/// rest are then taken off their queues, unless a sender already skipped
+/// past them.
+unsigned
+Channel::Select(Channel **channels, unsigned n, int *message)
+{
+    ASSERT(channels != nullptr);
+    ASSERT(n > 0 && n <= SELECT_MAX_CHANNELS);
+    ASSERT(message != nullptr);
+
+    IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
+
+    for (unsigned i = 0; i < n; i++) {
+        if (channels[i]->Get(message, 1) == 1) {
+            interrupt->SetLevel(oldLevel);
+            return i;
+        }
+    }
+
+    Waiter waiters[SELECT_MAX_CHANNELS];
+    bool done = false;
+    for (unsigned i = 0; i < n; i++) {
+        Channel *c = channels[i];
+        waiters[i].thread = currentThread;
+        waiters[i].messages = message;
+        waiters[i].count = 1;
+        waiters[i].served = false;
+        waiters[i].done = &done;
+        Append(&waiters[i], &c->receivers, &c->lastReceiver);
+    }
+    DEBUG('c', "Thread \"%s\" selecting on %u channels.\n",
+          currentThread->GetName(), n);
+    while (!done) {
+        currentThread->Sleep();
+    }
+
+    unsigned which = n;
+    for (unsigned i = 0; i < n; i++) {
+        Channel *c = channels[i];
+        if (waiters[i].served) {
+            ASSERT(which == n);
+            which = i;
+        } else {
+            Remove(&waiters[i], &c->receivers, &c->lastReceiver);
+        }
+    }
+    ASSERT(which < n);
+
+    interrupt->SetLevel(oldLevel);
+    return which;
+}
+
+/// Fill the buffers of the receivers waiting, in order, and then the
+/// ring.  Receivers only wait while the ring is empty, so no message can
+/// overtake one already there.
+unsigned
+Channel::Put(const int *messages, unsigned n)
+{
+    unsigned sent = 0;
+    Waiter *r;
+    while (sent < n && (r = First(&receivers, &lastReceiver)) != nullptr) {
+        for (; sent < n && r->count > 0; sent++, r->count--) {
+            *r->messages++ = messages[sent];
+        }
+        if (r->count == 0) {
+            Serve(Pop(&receivers, &lastReceiver));
+        }
+    }
+    for (; sent < n && count < capacity; sent++, count++) {
+        ring[(head + count) % capacity] = messages[sent];
+    }
+    return sent;
+}
+
+/// Take the oldest messages: first from the ring, then straight from the
+/// buffers of the senders waiting, in order.  Then move what senders still
+/// have waiting into the room just made in the ring.  A sender is woken up
+/// once its whole batch has been taken.
+unsigned
+Channel::Get(int *messages, unsigned n)
+{
+    unsigned received = 0;
+    for (; received < n && count > 0; received++, count--) {
+        messages[received] = ring[head];
+        head = (head + 1) % capacity;
+    }
+
+    Waiter *s;
+    while (received < n && (s = First(&senders, &lastSender)) != nullptr) {
+        for (; received < n && s->count > 0; received++, s->count--) {
+            messages[received] = *s->messages++;
+        }
+        if (s->count == 0) {
+            Serve(Pop(&senders, &lastSender));
+        }
+    }
+
+    while (count < capacity && (s = First(&senders, &lastSender)) != nullptr) {
+        for (; count < capacity && s->count > 0; count++, s->count--) {
+            ring[(head + count) % capacity] = *s->messages++;
+        }
+        if (s->count == 0) {
+            Serve(Pop(&senders, &lastSender));
+        }
+    }
+    return received;
+}
+
+/// Queue the current thread as `w`, and sleep until it is served.
+void
+Channel::Wait(Waiter *w, Waiter **first, Waiter **last)
+{
+    w->thread = currentThread;
+    w->served = false;
+    w->done = &w->served;
+    Append(w, first, last);
+
+    DEBUG('c', "Thread \"%s\" waiting on channel \"%s\".\n",
+          currentThread->GetName(), name);
+    while (!w->served) {
+        currentThread->Sleep();
+    }
+}
+
+void
+Channel::Append(Waiter *w, Waiter **first, Waiter **last)
+{
+    w->next = nullptr;
+    if (*first == nullptr) {
+        *first = w;
+    } else {
+        (*last)->next = w;
+    }
+    *last = w;
+}
+
+/// Return the first waiter not served yet elsewhere, or null, dropping
+/// those that were.  It stays queued.
+Channel::Waiter *
+Channel::First(Waiter **first, Waiter **last)
+{
+    while (*first != nullptr && *(*first)->done) {
+        *first = (*first)->next;
+        if (*first == nullptr) {
+            *last = nullptr;
+        }
+    }
+    return *first;
+}
+
+/// Unlink and return the first waiter not served yet elsewhere, or null.
+Channel::Waiter *
+Channel::Pop(Waiter **first, Waiter **last)
+{
+    while (*first != nullptr) {
+        Waiter *w = *first;
+        *first = w->next;
+        if (*first == nullptr) {
+            *last = nullptr;
+        }
+        if (!*w->done) {
+            return w;
+        }
+    }
+    return nullptr;
+}
+
+/// Unlink `w`, if it is still queued.
+void
+Channel::Remove(Waiter *w, Waiter **first, Waiter **last)
+{
+    Waiter *prev = nullptr;
+    for (Waiter *p = *first; p != nullptr; prev = p, p = p->next) {
+        if (p == w) {
+            if (prev == nullptr) {
+                *first = p->next;
+            } else {
+                prev->next = p->next;
+            }
+            if (*last == p) {
+                *last = prev;
+            }
+            return;
+        }
+    }
+}
+
+void
+Channel::Serve(Waiter *w)
+{
+    w->served = true;
+    *w->done = true;
+    scheduler->ReadyToRun(w->thread);
+}
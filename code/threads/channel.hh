@@ -1,29 +1,120 @@
+/// Message passing between threads.
+///
+/// A channel carries `int` messages from any number of senders to any number
+/// of receivers, in FIFO order.  It holds up to `capacity` messages in a
+/// ring; a sender only blocks when the ring is full, and a receiver only
+/// when it is empty.  A channel of capacity 0 is a rendezvous: every sender
+/// waits for a receiver to take its message.
+///
+/// A receiver waiting on an empty channel is handed the next message
+/// directly, and a sender waiting on a full one has its message moved into
+/// the ring as soon as there is room, so neither has to retry once woken
+/// up.  Waiting threads are queued in arrival order.
+///
+/// `SendN` and `ReceiveN` move several messages at once, and block at most
+/// once: a batch that cannot complete waits with a pointer to the rest of
+/// its buffer, and the other side fills or drains as much of it as it can
+/// before waking it up.  `Select` waits for a message on any of several
+/// channels.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
 #ifndef NACHOS_THREADS_CHANNEL__HH
 #define NACHOS_THREADS_CHANNEL__HH
 
+
 #include "lock.hh"
 
+
+/// Most channels a single `Select` may wait on.
+const unsigned SELECT_MAX_CHANNELS = 16;
+
 class Channel {
 public:
 
-    Channel(const char *debugName);
+    /// Initialize a channel holding up to `ringCapacity` messages.
+    Channel(const char *debugName, unsigned ringCapacity = 0);
 
+    /// No thread may be waiting on the channel.
     ~Channel();
 
     const char *GetName() const;
 
+    unsigned GetCapacity() const;
+
+    /// Messages sent and not yet received.
+    unsigned GetCount() const;
+
+    /// Block until `message` is in the ring or taken by a receiver.  On a
+    /// rendezvous channel, until it is taken.
     void Send(int message);
+
+    /// Block until a message is available, and store it in `message`.
     void Receive(int *message);
 
+    /// Send or receive `n` messages, in order, as if by `n` calls to
+    /// `Send` or `Receive`, without other messages of the caller's being
+    /// interleaved.
+    void SendN(const int *messages, unsigned n);
+
+    void ReceiveN(int *messages, unsigned n);
+
+    /// Same as `Send` and `Receive`, but fail, returning false, instead of
+    /// blocking.
+    bool TrySend(int message);
+
+    bool TryReceive(int *message);
+
+    /// Block until a message is available on any of `channels`, and receive
+    /// it.  Returns the index of the channel it came from; when several
+    /// already have a message, the first one listed wins.
+    static unsigned Select(Channel **channels, unsigned n, int *message);
+
 private:
 
+    /// A thread blocked on the channel.  It lives on the stack of that
+    /// thread.
+    ///
+    /// The records of a `Select` share their `done` flag: the first one
+    /// served sets it, and the others are skipped from then on.
+    struct Waiter {
+        Thread *thread;
+        int *messages;   ///< Still to send, or room for those still to be
+                         ///< received.
+        unsigned count;  ///< How many; served once it drops to 0.
+        bool served;
+        bool *done;
+        Waiter *next;
+    };
+
     const char *name;
 
-    int *buffer;
+    /// Ring of messages sent and not yet received.
+    int *ring;
+    unsigned capacity;
+    unsigned head;
+    unsigned count;
+
+    /// Threads waiting to send and to receive, in FIFO order.
+    Waiter *senders;
+    Waiter *lastSender;
+    Waiter *receivers;
+    Waiter *lastReceiver;
 
-    Semaphore *semReceive, *semSend;
+    /// These assume interrupts are disabled.  They move up to `n`
+    /// messages without blocking, and return how many.
+    unsigned Put(const int *messages, unsigned n);
+    unsigned Get(int *messages, unsigned n);
 
-    Lock *lockReceive, *lockSend;
+    void Wait(Waiter *w, Waiter **first, Waiter **last);
+    static void Append(Waiter *w, Waiter **first, Waiter **last);
+    static Waiter *First(Waiter **first, Waiter **last);
+    static Waiter *Pop(Waiter **first, Waiter **last);
+    static void Remove(Waiter *w, Waiter **first, Waiter **last);
+    static void Serve(Waiter *w);
 };
 
+
 #endif
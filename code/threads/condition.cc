@@ -15,22 +15,24 @@
 /// limitation of liability and disclaimer of warranty provisions.
 
 #include "condition.hh"
+#include "system.hh"
 
-/// Dummy functions -- so we can compile our later assignments.
-///
 
 Condition::Condition(const char *debugName, Lock *conditionLock)
 {
+    ASSERT(conditionLock != nullptr);
+
     name = debugName;
-    waiters = 0;
-    sem = new Semaphore(debugName, 0);
     condLock = conditionLock;
+    waiters = lastWaiter = nullptr;
+    profile = lockProfiler != nullptr
+              ? lockProfiler->Register(SYNC_CONDITION, debugName) : nullptr;
     DEBUG('v', "Condition variable <%s> created.\n", debugName);
 }
 
 Condition::~Condition()
 {
-    delete sem;
+    ASSERT(waiters == nullptr);
 }
 
 const char *
@@ -41,14 +43,19 @@ Condition::GetName() const
 
 void
 Condition::Wait()
+{
+    Block(0);
+}
+
+bool
+Condition::Wait(unsigned long ticks)
 {
     ASSERT(condLock->IsHeldByCurrentThread());
-    condLock->Release();
-    waiters++;
-    DEBUG('v', "Thread waiting. Condition variable: %s.\n", this->GetName());
-    sem->P();
-    condLock->Acquire();
-    DEBUG('v', "Thread awaken. Condition variable: %s.\n", this->GetName());
+
+    if (ticks == 0) {
+        return false;
+    }
+    return Block(ticks);
 }
 
 void
@@ -56,10 +63,15 @@ Condition::Signal()
 {
     ASSERT(condLock->IsHeldByCurrentThread());
     DEBUG('v', "Thread send a signal. Condition variable: %s.\n", this->GetName());
-    if (waiters > 0) {
-        sem->V();
-        waiters--;
+
+    IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
+    Waiter *w = waiters;
+    if (w != nullptr) {
+        Unlink(w);
+        w->woken = true;
+        condLock->Enqueue(w->thread);
     }
+    interrupt->SetLevel(oldLevel);
 }
 
 void
@@ -67,8 +79,108 @@ Condition::Broadcast()
 {
     ASSERT(condLock->IsHeldByCurrentThread());
     DEBUG('v', "Thread broadcast on the condition variable %s.\n", this->GetName());
-    while (waiters > 0) {
-        sem->V();
-        waiters--;
+
+    IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
+    while (waiters != nullptr) {
+        Waiter *w = waiters;
+        Unlink(w);
+        w->woken = true;
+        condLock->Enqueue(w->thread);
+    }
+    interrupt->SetLevel(oldLevel);
+}
+
+/// Queue up and release the lock with interrupts disabled, so that a
+/// `Signal` cannot slip in between.  Whoever wakes the thread up, a signal
+/// or the alarm, takes it off the queue.
+///
+/// A signal does not make the thread ready: it moves it onto the wait queue
+/// of the lock, which the signaller holds, so that it only runs once handed
+/// the lock.  Waking every waiter up just to have all but one block again
+/// on the lock would be a waste.  A thread that timed out has to take the
+/// lock on its own.
+bool
+Condition::Block(unsigned long ticks)
+{
+    ASSERT(condLock->IsHeldByCurrentThread());
+
+    IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
+
+    unsigned long start = stats->totalTicks;
+    Waiter w;
+    w.thread    = currentThread;
+    w.condition = this;
+    w.woken     = false;
+    w.timedOut  = false;
+    w.next      = nullptr;
+    if (lastWaiter == nullptr) {
+        waiters = &w;
+    } else {
+        lastWaiter->next = &w;
+    }
+    lastWaiter = &w;
+
+    AlarmEntry timeout(Timeout, &w);
+    if (ticks > 0) {
+        alarms->Set(&timeout, ticks);
     }
+
+    DEBUG('v', "Thread waiting. Condition variable: %s.\n", this->GetName());
+    condLock->Release();
+    while (!w.woken && !w.timedOut) {
+        currentThread->Sleep();
+    }
+    alarms->Cancel(&timeout);
+
+    interrupt->SetLevel(oldLevel);
+
+    if (profile != nullptr) {
+        profile->Acquired(true, stats->totalTicks - start);
+    }
+    if (w.woken) {
+        ASSERT(condLock->IsHeldByCurrentThread());
+        if (condLock->profile != nullptr) {
+            condLock->profile->Acquired(true, 0);  // Waited as `profile`.
+        }
+    } else {
+        condLock->Acquire();
+    }
+    DEBUG('v', "Thread awaken%s. Condition variable: %s.\n",
+          w.timedOut ? " by its timeout" : "", this->GetName());
+    return !w.timedOut;
+}
+
+/// Take `w` off the queue.  It must be in it.
+void
+Condition::Unlink(Waiter *w)
+{
+    Waiter *prev = nullptr;
+    Waiter *p = waiters;
+    while (p != w) {
+        ASSERT(p != nullptr);
+        prev = p;
+        p = p->next;
+    }
+    if (prev == nullptr) {
+        waiters = w->next;
+    } else {
+        prev->next = w->next;
+    }
+    if (lastWaiter == w) {
+        lastWaiter = prev;
+    }
+    w->next = nullptr;
+}
+
+void
+Condition::Timeout(void *waiter)
+{
+    Waiter *w = (Waiter *) waiter;
+    if (w->woken) {
+        return;  // Signalled, but has not run yet.
+    }
+
+    w->condition->Unlink(w);
+    w->timedOut = true;
+    scheduler->ReadyToRun(w->thread);
 }
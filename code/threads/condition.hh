@@ -39,9 +39,9 @@
 /// must be executed in mutual exclusion.
 ///
 /// Nachos' condition variables should work according to the “Mesa” style.
-/// When a `Signal` or `Broadcast` awakens another thread, this is put in the
-/// ready queue.  The woken thread is responsible for acquiring the lock
-/// again.  This has to be implemented in the body of the `Wait` function.
+/// When a `Signal` or `Broadcast` awakens another thread, this is queued up
+/// on the lock, and put in the ready queue once the lock is handed over to
+/// it (“wait morphing”), so that `Wait` returns with the lock held again.
 ///
 /// In contrast, there exists another style of condition variables, the
 /// “Hoare” style: according to it, `Signal` loses control of the lock and
@@ -71,19 +71,42 @@ public:
     void Signal();
     void Broadcast();
 
+    /// Same as `Wait`, but give up once `ticks` ticks have gone by without
+    /// a `Signal`.  Returns false if it timed out; the lock is held again
+    /// either way.  A timeout of 0 fails right away, keeping the lock.
+    bool Wait(unsigned long ticks);
+
 private:
 
+    /// A thread blocked in `Wait`.  It lives on the stack of that thread.
+    struct Waiter {
+        Thread *thread;
+        Condition *condition;
+        bool woken;
+        bool timedOut;
+        Waiter *next;
+    };
+
     const char *name;
 
-    int waiters;
+    Lock *condLock;
+
+    /// Where to account for waits, if profiling.
+    SyncProfile *profile;
 
-    Lock* wLock;
+    /// Threads waiting, in the order they came in, and woken up in that
+    /// order.  Only touched with interrupts disabled, since a timeout
+    /// unlinks its waiter from an interrupt handler.
+    Waiter *waiters;
+    Waiter *lastWaiter;
 
-    Semaphore* sem;
+    /// Wait on the condition, giving up after `ticks` if not 0.
+    bool Block(unsigned long ticks);
 
-    Lock* condLock;
+    void Unlink(Waiter *w);
 
-    // Other needed fields are to be added here.
+    /// Alarm handler of a timed `Wait`.
+    static void Timeout(void *waiter);
 };
 
 
@@ -0,0 +1,37 @@
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "cpu.hh"
+#include "lib/assert.hh"
+
+
+Cpu::Cpu(unsigned cpuId, SchedulingPolicy *cpuPolicy)
+{
+    ASSERT(cpuPolicy != nullptr);
+
+    id           = cpuId;
+    current      = nullptr;
+    idleThread   = nullptr;
+    readyList    = cpuPolicy;
+    numReady     = 0;
+    realTime     = new EdfPolicy;
+    clock        = 0;
+    yieldPending = false;
+}
+
+/// The idle thread is not reclaimed: it may still be running.
+Cpu::~Cpu()
+{
+    if (id == 0 || !readyList->IsShared()) {
+        delete readyList;
+    }
+    delete realTime;
+}
+
+bool
+Cpu::IsIdle() const
+{
+    return current == idleThread;
+}
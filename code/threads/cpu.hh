@@ -0,0 +1,78 @@
+/// Virtual processors, for the simulated multiprocessor.
+///
+/// With `-cpus N`, the kernel runs on `N` virtual CPUs.  Each CPU has its
+/// own running thread, its own ready queue (managed by its own instance of
+/// the scheduling policy, unless the policy is shared; see
+/// `SchedulingPolicy::IsShared`) and, when running user programs, its own
+/// register set and MMU/TLB (see `Machine::SelectCpu`).
+///
+/// The CPUs are simulated by a single host thread, so they run interleaved:
+/// every CPU keeps a local clock, and after every tick (see
+/// `Interrupt::OneTick`) the host switches to the CPU that is furthest
+/// behind, so that all of them advance together.  The global time,
+/// `stats->totalTicks`, is that of the CPU that is furthest behind.  The
+/// interleaving depends only on simulated time, so runs are repeatable.
+///
+/// A CPU with nothing to run switches to its idle thread, which steals work
+/// from the CPU with the longest ready queue.
+///
+/// Kernel code is still protected by disabling interrupts: the host only
+/// switches CPUs at points where interrupts are enabled.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_THREADS_CPU__HH
+#define NACHOS_THREADS_CPU__HH
+
+
+#include "edf_policy.hh"
+
+
+class Thread;
+
+class Cpu {
+public:
+
+    /// Initialize CPU number `cpuId`, with an empty ready queue managed by
+    /// `cpuPolicy`, of which it takes ownership.  A shared policy is owned
+    /// by CPU 0.
+    Cpu(unsigned cpuId, SchedulingPolicy *cpuPolicy);
+
+    ~Cpu();
+
+    /// Is the CPU running its idle thread?
+    bool IsIdle() const;
+
+    unsigned id;
+
+    /// Thread running on this CPU.  Only one CPU is simulated at a time,
+    /// and `currentThread` is `current` of that CPU.
+    Thread *current;
+
+    /// Thread that runs when there is nothing else to do.  Null on a
+    /// uniprocessor, where the CPU idles inside `Thread::Sleep` instead.
+    Thread *idleThread;
+
+    /// Threads that are ready to run on this CPU, and how many.  With a
+    /// shared policy, `readyList` holds those of every CPU, and `numReady`
+    /// counts the ones that last ran on this one.
+    SchedulingPolicy *readyList;
+    unsigned numReady;
+
+    /// Real-time threads admitted on this CPU, and the ready ones.  These
+    /// are not counted in `numReady`, as they cannot be stolen.
+    EdfPolicy *realTime;
+
+    /// Local simulated time.
+    unsigned long clock;
+
+    /// A timer interrupt taken on another CPU asked this one to preempt its
+    /// thread at the next tick.
+    bool yieldPending;
+
+};
+
+
+#endif
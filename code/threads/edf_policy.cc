@@ -0,0 +1,208 @@
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "edf_policy.hh"
+#include "system.hh"
+
+
+unsigned
+RealTimeUtilization(unsigned long period, unsigned long budget)
+{
+    ASSERT(period > 0);
+    return (budget * RT_UTILIZATION_SCALE + period - 1) / period;
+}
+
+EdfPolicy::EdfPolicy()
+{
+    head        = nullptr;
+    utilization = 0;
+}
+
+const char *
+EdfPolicy::GetName() const
+{
+    return "edf";
+}
+
+bool
+EdfPolicy::Admit(unsigned long period, unsigned long budget)
+{
+    unsigned u = RealTimeUtilization(period, budget);
+    if (utilization + u > RT_MAX_UTILIZATION) {
+        return false;
+    }
+    utilization += u;
+    return true;
+}
+
+void
+EdfPolicy::Leave(const Thread *thread)
+{
+    ASSERT(thread->IsRealTime());
+
+    unsigned u = RealTimeUtilization(thread->rtPeriod, thread->rtBudget);
+    ASSERT(utilization >= u);
+    utilization -= u;
+}
+
+void
+EdfPolicy::Start(Thread *thread)
+{
+    thread->rtDeadline  = stats->totalTicks;
+    thread->rtThrottled = false;
+    NextPeriod(thread, false);
+}
+
+unsigned
+EdfPolicy::GetUtilization() const
+{
+    return utilization;
+}
+
+bool
+EdfPolicy::IsEmpty() const
+{
+    return head == nullptr;
+}
+
+/// Coming back from throttling, the thread starts its next period.  Coming
+/// back from blocking, its job is done, and a new one is released now,
+/// unless what is left of the current one would not use more than its
+/// share of the time to its deadline (the wake-up rule of the constant
+/// bandwidth server).  A running thread that yields past its deadline
+/// missed it.
+void
+EdfPolicy::Enqueue(Thread *thread)
+{
+    unsigned long now = stats->totalTicks;
+
+    if (thread->rtThrottled) {
+        thread->rtThrottled = false;
+        NextPeriod(thread, true);
+    } else if (thread != currentThread) {
+        if (thread->rtDeadline <= now
+              || thread->rtRemaining * thread->rtPeriod
+                   > (thread->rtDeadline - now) * thread->rtBudget) {
+            thread->rtDeadline = now;
+            NextPeriod(thread, false);
+        }
+    } else if (thread->rtDeadline <= now) {
+        NextPeriod(thread, true);
+    }
+    Insert(thread);
+}
+
+Thread *
+EdfPolicy::Dequeue()
+{
+    Thread *thread = head;
+    if (thread != nullptr) {
+        head = thread->rtNext;
+        thread->rtNext = nullptr;
+    }
+    return thread;
+}
+
+void
+EdfPolicy::Charge(Thread *thread, unsigned long ticks, bool blocked)
+{
+    thread->rtRemaining = ticks < thread->rtRemaining
+                          ? thread->rtRemaining - ticks : 0;
+}
+
+/// Ready threads whose deadline has come are moved on to their next period
+/// first.  Then `current` is preempted if it is not real-time and there is
+/// a real-time thread ready, if it has used up its budget, or if a ready
+/// thread has an earlier deadline.
+bool
+EdfPolicy::TimerTick(Thread *current)
+{
+    unsigned long now = stats->totalTicks;
+
+    while (head != nullptr && head->rtDeadline <= now) {
+        Thread *thread = Dequeue();
+        NextPeriod(thread, true);
+        Insert(thread);
+    }
+
+    if (!current->IsRealTime()) {
+        return head != nullptr;
+    }
+    if (current->rtRemaining == 0) {
+        return true;  // `Throttle` will take it from here.
+    }
+    if (current->rtDeadline <= now) {
+        NextPeriod(current, true);
+    }
+    return head != nullptr && head->rtDeadline < current->rtDeadline;
+}
+
+bool
+EdfPolicy::Throttle(Thread *thread)
+{
+    ASSERT(thread == currentThread);
+
+    if (thread->rtRemaining > 0) {
+        return false;
+    }
+
+    IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
+
+    unsigned long now = stats->totalTicks;
+    if (thread->rtDeadline <= now) {
+        NextPeriod(thread, true);
+        interrupt->SetLevel(oldLevel);
+        return false;
+    }
+
+    DEBUG('t', "Throttling thread \"%s\" until tick %lu\n",
+          thread->GetName(), thread->rtDeadline);
+    thread->rtThrottled = true;
+    thread->SleepFor(thread->rtDeadline - now);
+
+    interrupt->SetLevel(oldLevel);
+    return true;
+}
+
+void
+EdfPolicy::Apply(void (*func)(Thread *)) const
+{
+    ASSERT(func != nullptr);
+
+    for (Thread *t = head; t != nullptr; t = t->rtNext) {
+        func(t);
+    }
+}
+
+/// Threads with the same deadline are kept in FIFO order.
+void
+EdfPolicy::Insert(Thread *thread)
+{
+    Thread **p = &head;
+    while (*p != nullptr && (*p)->rtDeadline <= thread->rtDeadline) {
+        p = &(*p)->rtNext;
+    }
+    thread->rtNext = *p;
+    *p = thread;
+}
+
+void
+EdfPolicy::NextPeriod(Thread *thread, bool missed)
+{
+    unsigned long now = stats->totalTicks;
+
+    if (missed) {
+        DEBUG('t', "Thread \"%s\" missed its deadline at tick %lu\n",
+              thread->GetName(), thread->rtDeadline);
+        thread->rtMisses++;
+        stats->deadlineMisses++;
+    }
+    do {
+        thread->rtDeadline += thread->rtPeriod;
+    } while (thread->rtDeadline <= now);
+    thread->rtRemaining = thread->rtBudget;
+    thread->rtJobs++;
+    stats->realTimeJobs++;
+}
@@ -0,0 +1,101 @@
+/// Earliest deadline first: the real-time scheduling class.
+///
+/// A thread joins the class by declaring a period and a budget (see
+/// `Scheduler::SetRealTime`): it may run for `budget` ticks every `period`
+/// ticks, and each such job has to be done by the end of its period, its
+/// deadline.  Ready real-time threads always run before the threads of the
+/// normal scheduling policy, in order of deadline.
+///
+/// * Admission: a thread is only let in if the utilization (budget over
+///   period) of the real-time threads of its CPU stays under
+///   `RT_MAX_UTILIZATION`, so that all deadlines can be met, and some time
+///   is left for the other threads.
+/// * Release: a job ends when the thread blocks.  When it becomes ready
+///   again, a new job starts, with a full budget and a deadline one period
+///   away, unless the budget left would fit in the time to the current
+///   deadline at the reserved utilization.
+/// * Enforcement: the timer interrupt charges the running thread against
+///   its budget.  A thread that uses it up is throttled: it sleeps until
+///   its deadline, and then gets a new budget for the next period.
+/// * Misses: a job that is still running or ready at its deadline has
+///   missed it.  The miss is counted in `Statistics`, and the thread moves
+///   on to the next period.
+///
+/// Every CPU has its own instance, and real-time threads stay on the CPU
+/// that admitted them: they are never stolen.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_THREADS_EDFPOLICY__HH
+#define NACHOS_THREADS_EDFPOLICY__HH
+
+
+#include "scheduling_policy.hh"
+
+
+/// Utilizations are in thousandths.
+const unsigned RT_UTILIZATION_SCALE = 1000;
+const unsigned RT_MAX_UTILIZATION   = 900;
+
+class EdfPolicy : public SchedulingPolicy {
+public:
+
+    EdfPolicy();
+
+    const char *GetName() const;
+
+    /// Reserve the utilization of a thread with `period` and `budget`.
+    /// Returns false, and reserves nothing, if it does not fit.
+    bool Admit(unsigned long period, unsigned long budget);
+
+    /// Give back the utilization reserved for `thread`.
+    void Leave(const Thread *thread);
+
+    /// Start the first job of `thread`, which has just been admitted.
+    void Start(Thread *thread);
+
+    unsigned GetUtilization() const;
+
+    bool IsEmpty() const;
+
+    void Enqueue(Thread *thread);
+
+    Thread *Dequeue();
+
+    void Charge(Thread *thread, unsigned long ticks, bool blocked);
+
+    /// Called for every thread, real-time or not, as ready real-time
+    /// threads preempt the others.
+    bool TimerTick(Thread *current);
+
+    /// If `thread` has used up its budget, sleep until its next period.
+    /// Returns whether it did.
+    bool Throttle(Thread *thread);
+
+    void Apply(void (*func)(Thread *)) const;
+
+private:
+
+    /// Insert `thread` in `head`, by deadline.
+    void Insert(Thread *thread);
+
+    /// Move `thread` on to its next period, counting a miss if its job is
+    /// not done.
+    void NextPeriod(Thread *thread, bool missed);
+
+    /// Ready threads, by increasing deadline, linked through
+    /// `Thread::rtNext`.
+    Thread *head;
+
+    /// Sum of the utilizations of the admitted threads.
+    unsigned utilization;
+
+};
+
+/// Utilization of a thread with `period` and `budget`, rounded up.
+unsigned RealTimeUtilization(unsigned long period, unsigned long budget);
+
+
+#endif
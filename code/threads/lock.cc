@@ -26,14 +26,20 @@
 Lock::Lock(const char *debugName)
 {
     name = debugName;
-    sem = new Semaphore(debugName, 1);
-    threadName = "none";
     thread = nullptr;
+    waiters = lastWaiter = nullptr;
+    nextHeld = nullptr;
+    acquisitions = contentions = handoffs = 0;
+    profile = lockProfiler != nullptr
+              ? lockProfiler->Register(SYNC_LOCK, debugName) : nullptr;
+    grantTick = 0;
 }
 
 Lock::~Lock()
 {
-    delete sem;
+    ASSERT(waiters == nullptr);
+    DEBUG('s', "Lock \"%s\": %lu acquisitions, %lu contended, %lu handoffs\n",
+          name, acquisitions, contentions, handoffs);
 }
 
 const char *
@@ -42,34 +48,106 @@ Lock::GetName() const
     return name;
 }
 
+/// A continuación se resuelve el problema de inversión de prioridades
+/// mediante la herencia de prioridades.
+/// En el caso de los semáforos no se puede hacer porque no tenemos
+/// información sobre el hilo que está utilizando los recursos. Es decir, si
+/// un hilo de alta prioridad queda bloqueado mediante sem->P(), no sabemos
+/// cual será el hilo que llame a sem->V() para desbloqueralo.
+///
+/// The inheritance is transitive: if the holder is itself waiting for
+/// another lock, the priority is passed on to that lock's holder, and so
+/// on.  Interrupts stay disabled until the lock is taken, so that the chain
+/// cannot change under our feet.
+///
+/// If the lock is free, it is taken right away.  Interrupts need not be
+/// disabled for that: simulated time only advances, and threads and CPUs
+/// only switch, when they are enabled again, so nothing can run in between.
+/// Otherwise the thread joins the end of the queue and sleeps; `Release`
+/// makes it the holder before waking it up.
 void
 Lock::Acquire()
 {
     ASSERT(!IsHeldByCurrentThread());
 
-    // A continuación se resuelve el problema de inversión de prioridades mediante
-    // la herencia de prioridades.
-    // En el caso de los semáforos no se puede hacer porque no tenemos información
-    // sobre el hilo que está utilizando los recursos. Es decir, si un hilo de alta
-    // prioridad queda bloqueado mediante sem->P(), no sabemos cual será el hilo que
-    // llame a sem->V() para desbloqueralo.
-    if (thread != nullptr)
-        if (thread->GetPriority() < currentThread->GetPriority()) {
-            DEBUG('t', "Thread \"%s\" inherits priority from thread \"%s\"\n", thread->GetName(), currentThread->GetName());
-            thread->InheritPriority(currentThread->GetPriority());
-            scheduler->ChangePriority(thread);      
+    if (profile != nullptr) {
+        for (Lock *held = currentThread->heldLocks; held != nullptr;
+             held = held->nextHeld) {
+            if (held->profile != nullptr) {
+                lockProfiler->Order(held->profile, profile);
+            }
         }
-    sem->P();
-    thread = currentThread;
+    }
+
+    if (thread == nullptr) {
+        acquisitions++;
+        Grant(currentThread);
+        if (profile != nullptr) {
+            profile->Acquired(false, 0);
+        }
+        return;
+    }
+
+    IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
+
+    unsigned long start = stats->totalTicks;
+    Enqueue(currentThread);
+    currentThread->Sleep();
+    ASSERT(thread == currentThread);
+    if (profile != nullptr) {
+        profile->Acquired(true, stats->totalTicks - start);
+    }
+
+    interrupt->SetLevel(oldLevel);
 }
 
+/// The priority inherited through this lock is given up, but not the one
+/// inherited through other locks still held.
+///
+/// If there are waiters, the first one becomes the holder, and inherits
+/// from those left.
 void
 Lock::Release()
 {
     ASSERT(IsHeldByCurrentThread());
-    currentThread->RestorePriority();
+
+    Lock **p = &currentThread->heldLocks;
+    while (*p != this) {
+        ASSERT(*p != nullptr);
+        p = &(*p)->nextHeld;
+    }
+    *p = nextHeld;
+    nextHeld = nullptr;
     thread = nullptr;
-    sem->V();
+    if (profile != nullptr) {
+        profile->Held(stats->totalTicks - grantTick);
+    }
+
+    if (waiters == nullptr) {
+        return;  // Nothing was inherited through this lock.
+    }
+
+    IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
+
+    Thread *next = waiters;
+    waiters = next->nextWaiter;
+    if (waiters == nullptr) {
+        lastWaiter = nullptr;
+    }
+    next->nextWaiter = nullptr;
+    next->waitingOn  = nullptr;
+
+    handoffs++;
+    DEBUG('s', "Lock \"%s\" handed over to thread \"%s\"\n",
+          name, next->GetName());
+    Grant(next);
+    scheduler->ReadyToRun(next);
+
+    if (currentThread->UpdatePriority()) {
+        scheduler->ChangePriority(currentThread);
+    }
+
+    interrupt->SetLevel(oldLevel);
 }
 
 bool
@@ -77,3 +155,71 @@ Lock::IsHeldByCurrentThread() const
 {
     return thread == currentThread;
 }
+
+unsigned long
+Lock::GetAcquisitions() const
+{
+    return acquisitions;
+}
+
+unsigned long
+Lock::GetContentions() const
+{
+    return contentions;
+}
+
+unsigned long
+Lock::GetHandoffs() const
+{
+    return handoffs;
+}
+
+/// A blocked holder is not in any ready list yet, so the scheduler need not
+/// hear about its new priority.
+void
+Lock::Grant(Thread *holder)
+{
+    thread = holder;
+    grantTick = stats->totalTicks;
+    nextHeld = holder->heldLocks;
+    holder->heldLocks = this;
+    if (holder->UpdatePriority() && holder == currentThread) {
+        scheduler->ChangePriority(holder);  // Inherit from the threads
+                                            // still waiting.
+    }
+}
+
+void
+Lock::Enqueue(Thread *waiter)
+{
+    ASSERT(thread != nullptr && waiter != thread);
+    ASSERT(waiter->waitingOn == nullptr);
+
+    acquisitions++;
+    contentions++;
+    waiter->waitingOn  = this;
+    waiter->nextWaiter = nullptr;
+    if (lastWaiter == nullptr) {
+        waiters = waiter;
+    } else {
+        lastWaiter->nextWaiter = waiter;
+    }
+    lastWaiter = waiter;
+    Donate(waiter->GetPriority());
+}
+
+void
+Lock::Donate(int newPriority)
+{
+    for (Lock *lock = this; lock != nullptr && lock->thread != nullptr;
+         lock = lock->thread->waitingOn) {
+        Thread *holder = lock->thread;
+        if (holder->GetPriority() >= newPriority) {
+            break;  // So is everyone further down the chain.
+        }
+        DEBUG('s', "Thread \"%s\" inherits priority %d through lock \"%s\"\n",
+              holder->GetName(), newPriority, lock->GetName());
+        holder->InheritPriority(newPriority);
+        scheduler->ChangePriority(holder);
+    }
+}
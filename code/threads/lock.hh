@@ -30,6 +30,11 @@
 ///
 /// For convenience, nobody but the thread that holds the lock can free it.
 /// There is no operation for reading the state of the lock.
+///
+/// Taking a free lock, and releasing one nobody waits for, is done without
+/// disabling interrupts.  A busy lock is handed over directly to the thread
+/// that has waited the longest, so that the releasing thread cannot take it
+/// back before that one gets to run.
 class Lock {
 public:
 
@@ -53,16 +58,57 @@ public:
     /// Useful for checks in `Release` and in condition variables.
     bool IsHeldByCurrentThread() const;
 
+    /// Times the lock was acquired, how many of those it was busy, and
+    /// times it was handed over on release.
+    unsigned long GetAcquisitions() const;
+
+    unsigned long GetContentions() const;
+
+    unsigned long GetHandoffs() const;
+
 private:
 
     /// For debugging.
     const char *name;
 
-    Semaphore* sem;
+    /// Holder, or null if the lock is free.
+    Thread* thread;
 
-    const char* threadName;
+    /// Threads blocked in `Acquire`, in arrival order, linked through
+    /// `Thread::nextWaiter`.  The holder inherits the priority of the most
+    /// urgent of them.
+    Thread *waiters;
+    Thread *lastWaiter;
 
-    Thread* thread;
+    /// Next lock held by the same thread (see `Thread::heldLocks`).
+    Lock *nextHeld;
+
+    friend class Thread;
+
+    unsigned long acquisitions;
+    unsigned long contentions;
+    unsigned long handoffs;
+
+    /// Where to account for contention, if profiling, and the tick the
+    /// lock was granted at, for the hold time.
+    SyncProfile *profile;
+    unsigned long grantTick;
+
+    /// Make `holder` the holder of the lock.
+    void Grant(Thread *holder);
+
+    /// Queue `waiter` up for the lock, which is busy, and let the holder
+    /// inherit its priority.  Called with interrupts disabled.
+    ///
+    /// Besides `Acquire`, `Condition` uses it to move a signalled thread
+    /// straight onto the lock, without waking it up first.
+    void Enqueue(Thread *waiter);
+
+    friend class Condition;
+
+    /// Raise the priority of the holder to `newPriority`, and of whoever
+    /// holds the lock it is waiting for, and so on along the chain.
+    void Donate(int newPriority);
 };
 
 
@@ -0,0 +1,245 @@
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "lock_profiler.hh"
+#include "lib/assert.hh"
+#include "lib/utility.hh"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+/// An edge of the lock order graph: a lock of class `to` was taken while
+/// one of the class the edge leaves from was held.
+struct LockOrder {
+    SyncProfile *to;
+    bool cycle;  ///< It closed a cycle when first seen.
+    LockOrder *next;
+};
+
+static const char *const KIND_NAMES[NUM_SYNC_KINDS] = {
+    "lock", "semaphore", "condition"
+};
+
+SyncProfile::SyncProfile(SyncKind syncKind, const char *syncName)
+{
+    if (syncName == nullptr) {
+        syncName = "(unnamed)";
+    }
+
+    kind = syncKind;
+    name = new char [strlen(syncName) + 1];
+    strcpy(name, syncName);
+    objects = 0;
+    acquires = contended = 0;
+    waitTicks = maxWaitTicks = holdTicks = 0;
+    after = nullptr;
+    visited = false;
+    next = nullptr;
+}
+
+SyncProfile::~SyncProfile()
+{
+    while (after != nullptr) {
+        LockOrder *e = after;
+        after = e->next;
+        delete e;
+    }
+    delete [] name;
+}
+
+void
+SyncProfile::Acquired(bool wasContended, unsigned long ticks)
+{
+    acquires++;
+    if (wasContended) {
+        contended++;
+        waitTicks += ticks;
+        if (ticks > maxWaitTicks) {
+            maxWaitTicks = ticks;
+        }
+    }
+}
+
+void
+SyncProfile::Held(unsigned long ticks)
+{
+    holdTicks += ticks;
+}
+
+LockProfiler::LockProfiler()
+{
+    profiles = nullptr;
+    numProfiles = 0;
+    cycles = 0;
+}
+
+LockProfiler::~LockProfiler()
+{
+    while (profiles != nullptr) {
+        SyncProfile *p = profiles;
+        profiles = p->next;
+        delete p;
+    }
+}
+
+SyncProfile *
+LockProfiler::Register(SyncKind kind, const char *name)
+{
+    const char *key = name != nullptr ? name : "(unnamed)";
+
+    SyncProfile *p = (SyncProfile *) Find(kind, key);
+    if (p == nullptr) {
+        p = new SyncProfile(kind, key);
+        p->next = profiles;
+        profiles = p;
+        numProfiles++;
+    }
+    p->objects++;
+    return p;
+}
+
+const SyncProfile *
+LockProfiler::Find(SyncKind kind, const char *name) const
+{
+    const char *key = name != nullptr ? name : "(unnamed)";
+
+    for (SyncProfile *p = profiles; p != nullptr; p = p->next) {
+        if (p->kind == kind && strcmp(p->name, key) == 0) {
+            return p;
+        }
+    }
+    return nullptr;
+}
+
+/// Locks of the same class taken one inside the other are not ordered
+/// here: telling them apart would take a finer key than the name.
+void
+LockProfiler::Order(SyncProfile *held, SyncProfile *taken)
+{
+    ASSERT(held != nullptr && taken != nullptr);
+
+    if (held == taken) {
+        return;
+    }
+    for (LockOrder *e = held->after; e != nullptr; e = e->next) {
+        if (e->to == taken) {
+            return;  // Already known.
+        }
+    }
+
+    LockOrder *e = new LockOrder;
+    e->to = taken;
+    e->cycle = false;
+
+    // Taking `taken` after `held` is a cycle if `held` was ever taken,
+    // directly or not, after `taken`.
+    ClearVisited();
+    if (Reaches(taken, held)) {
+        printf("Possible deadlock: %s \"%s\" taken while holding \"%s\", "
+               "which has been taken after it before.\n",
+               KIND_NAMES[taken->kind], taken->name, held->name);
+        e->cycle = true;
+        cycles++;
+    }
+
+    e->next = held->after;
+    held->after = e;
+}
+
+unsigned
+LockProfiler::GetCycles() const
+{
+    return cycles;
+}
+
+/// Depth first search.
+bool
+LockProfiler::Reaches(SyncProfile *from, SyncProfile *to)
+{
+    if (from == to) {
+        return true;
+    }
+    from->visited = true;
+    for (LockOrder *e = from->after; e != nullptr; e = e->next) {
+        if (!e->to->visited && Reaches(e->to, to)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void
+LockProfiler::ClearVisited()
+{
+    for (SyncProfile *p = profiles; p != nullptr; p = p->next) {
+        p->visited = false;
+    }
+}
+
+static int
+CompareWait(const void *a, const void *b)
+{
+    const SyncProfile *p = *(const SyncProfile * const *) a;
+    const SyncProfile *q = *(const SyncProfile * const *) b;
+    if (p->waitTicks != q->waitTicks) {
+        return p->waitTicks < q->waitTicks ? 1 : -1;
+    }
+    return strcmp(p->name, q->name);
+}
+
+const SyncProfile *
+LockProfiler::GetTop(SyncKind kind) const
+{
+    const SyncProfile *top = nullptr;
+    for (const SyncProfile *p = profiles; p != nullptr; p = p->next) {
+        if (p->kind == kind && p->acquires > 0
+              && (top == nullptr || CompareWait(&p, &top) < 0)) {
+            top = p;
+        }
+    }
+    return top;
+}
+
+void
+LockProfiler::Print()
+{
+    SyncProfile **sorted = new SyncProfile * [numProfiles];
+    unsigned n = 0;
+    for (SyncProfile *p = profiles; p != nullptr; p = p->next) {
+        if (p->acquires > 0) {
+            sorted[n++] = p;
+        }
+    }
+    qsort(sorted, n, sizeof *sorted, CompareWait);
+
+    printf("Synchronization profile, by total wait:\n");
+    printf("%-9s  %-20s  %7s  %9s  %9s  %10s  %8s  %10s\n",
+           "kind", "name", "objects", "acquires", "contended",
+           "wait ticks", "max wait", "hold ticks");
+    for (unsigned i = 0; i < n; i++) {
+        SyncProfile *p = sorted[i];
+        printf("%-9s  %-20s  %7u  %9lu  %9lu  %10lu  %8lu  ",
+               KIND_NAMES[p->kind], p->name, p->objects, p->acquires,
+               p->contended, p->waitTicks, p->maxWaitTicks);
+        if (p->kind == SYNC_LOCK) {
+            printf("%10lu\n", p->holdTicks);
+        } else {
+            printf("%10s\n", "-");
+        }
+    }
+    delete [] sorted;
+
+    printf("Lock order cycles: %u.\n", cycles);
+    for (SyncProfile *p = profiles; p != nullptr; p = p->next) {
+        for (LockOrder *e = p->after; e != nullptr; e = e->next) {
+            if (e->cycle) {
+                printf("    \"%s\" taken while holding \"%s\", "
+                       "and the other way around.\n", e->to->name, p->name);
+            }
+        }
+    }
+}
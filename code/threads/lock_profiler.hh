@@ -0,0 +1,117 @@
+/// Contention profile of the synchronization objects, and the order in
+/// which locks are taken.
+///
+/// Profiling is optional: it is turned on with `-lp`, which creates
+/// `lockProfiler`.  Locks, semaphores and condition variables created from
+/// then on are accounted under their kind and name, so that every object of
+/// a kind with the same name adds up to one `SyncProfile`.  The profile is
+/// printed at halt, sorted by total wait time.
+///
+/// Every time a thread takes a lock while holding others, the order between
+/// their classes (kind and name) is added to a graph.  An order that closes
+/// a cycle means two threads could deadlock, even if they did not this
+/// time; it is reported right away, and again at halt.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_THREADS_LOCKPROFILER__HH
+#define NACHOS_THREADS_LOCKPROFILER__HH
+
+
+enum SyncKind {
+    SYNC_LOCK,
+    SYNC_SEMAPHORE,
+    SYNC_CONDITION,
+    NUM_SYNC_KINDS
+};
+
+struct LockOrder;
+
+/// Statistics of a class of synchronization objects.  The counters are
+/// public to make it easier to update.
+///
+/// For a lock or semaphore, an acquire is an `Acquire` or `P`, contended if
+/// it had to wait.  For a condition variable, it is a `Wait`, which always
+/// waits.  Only locks have a hold time.
+class SyncProfile {
+public:
+
+    SyncProfile(SyncKind syncKind, const char *syncName);
+
+    ~SyncProfile();
+
+    /// Account for an acquire that waited `ticks` ticks, if `contended`.
+    void Acquired(bool contended, unsigned long ticks);
+
+    /// Account for a lock held for `ticks` ticks.
+    void Held(unsigned long ticks);
+
+    SyncKind kind;
+    char *name;
+
+    unsigned objects;
+    unsigned long acquires;
+    unsigned long contended;
+    unsigned long waitTicks;
+    unsigned long maxWaitTicks;
+    unsigned long holdTicks;
+
+private:
+
+    friend class LockProfiler;
+
+    /// Classes of locks taken while holding one of this class.
+    LockOrder *after;
+
+    /// For searching the lock order graph.
+    bool visited;
+
+    SyncProfile *next;
+};
+
+class LockProfiler {
+public:
+
+    LockProfiler();
+
+    ~LockProfiler();
+
+    /// Profile to account a new object of `kind` named `name` in.
+    SyncProfile *Register(SyncKind kind, const char *name);
+
+    /// A lock of class `taken` is being acquired while one of class `held`
+    /// is held.
+    void Order(SyncProfile *held, SyncProfile *taken);
+
+    /// Profile of the objects of `kind` named `name`, or null if there are
+    /// none.
+    const SyncProfile *Find(SyncKind kind, const char *name) const;
+
+    /// Profile of `kind` that `Print` would rank first, or null if no
+    /// object of `kind` was acquired.
+    const SyncProfile *GetTop(SyncKind kind) const;
+
+    /// Number of lock orders found to close a cycle.
+    unsigned GetCycles() const;
+
+    /// Print the profile, sorted by total wait time, and the lock orders
+    /// that closed a cycle.
+    void Print();
+
+private:
+
+    SyncProfile *profiles;
+    unsigned numProfiles;
+
+    unsigned cycles;
+
+    /// Is `to` reachable from `from` in the lock order graph?
+    bool Reaches(SyncProfile *from, SyncProfile *to);
+
+    void ClearVisited();
+};
+
+
+#endif
@@ -0,0 +1,169 @@
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "lottery_policy.hh"
+#include "system.hh"
+
+
+static const unsigned INITIAL_CAPACITY = 16;
+
+/// Pass advance for a tick run with a single ticket, as in `StridePolicy`.
+static const unsigned long long STRIDE1 = 1 << 20;
+
+/// Lead in pass that halves a thread's weight in a draw: a quantum's worth
+/// at the default tickets.  The weight stops shrinking after
+/// `MAX_HALVINGS`, so that every thread keeps some chance of winning.
+static const unsigned long long LEAD_PER_HALVING
+  = STRIDE1 / DEFAULT_TICKETS * TIMER_TICKS;
+static const unsigned MAX_HALVINGS = 8;
+
+LotteryPolicy::LotteryPolicy()
+{
+    capacity   = INITIAL_CAPACITY;
+    ready      = new Thread *[capacity];
+    count      = 0;
+    globalPass = 0;
+}
+
+LotteryPolicy::~LotteryPolicy()
+{
+    delete [] ready;
+}
+
+const char *
+LotteryPolicy::GetName() const
+{
+    return "lottery";
+}
+
+/// Like under stride scheduling, a thread coming back from blocking does
+/// not get to claim the share it did not use meanwhile: it is put no
+/// further behind than the ready threads were at the last draw.  A
+/// preempted thread keeps its pass, as it did not give up its share.
+void
+LotteryPolicy::Enqueue(Thread *thread)
+{
+    if (thread->rejoining && thread->pass < globalPass) {
+        thread->pass = globalPass;
+    }
+    thread->rejoining = false;
+
+    if (count == capacity) {
+        Thread **old = ready;
+        capacity *= 2;
+        ready = new Thread *[capacity];
+        for (unsigned i = 0; i < count; i++) {
+            ready[i] = old[i];
+        }
+        delete [] old;
+    }
+    ready[count++] = thread;
+}
+
+/// Draw a ticket among the ready threads, and take its holder out.
+Thread *
+LotteryPolicy::Dequeue()
+{
+    if (count == 0) {
+        return nullptr;
+    }
+
+    unsigned long long minPass = MinPass(nullptr);
+    unsigned long winner = SystemDep::Random() % TotalWeight(minPass);
+    unsigned i = 0;
+    while (winner >= Weight(ready[i], minPass)) {
+        winner -= Weight(ready[i], minPass);
+        i++;
+    }
+
+    Thread *thread = ready[i];
+    ready[i] = ready[--count];
+    if (minPass > globalPass) {
+        globalPass = minPass;
+    }
+    return thread;
+}
+
+void
+LotteryPolicy::Charge(Thread *thread, unsigned long ticks, bool blocked)
+{
+    thread->pass += STRIDE1 / thread->GetTickets() * ticks;
+    if (blocked) {
+        thread->rejoining = true;
+    }
+}
+
+/// Hold a draw among `current` and the ready threads; `current` is
+/// preempted if it loses.  `Dequeue` then draws again among the ready
+/// threads only, which picks each of them with the right probability.
+bool
+LotteryPolicy::TimerTick(Thread *current)
+{
+    if (count == 0) {
+        return false;
+    }
+
+    unsigned long long minPass = MinPass(current);
+    unsigned long own = Weight(current, minPass);
+
+    return SystemDep::Random() % (TotalWeight(minPass) + own) >= own;
+}
+
+bool
+LotteryPolicy::NeedsTimer() const
+{
+    return true;
+}
+
+/// Tickets are a share of the whole machine, so the threads of every CPU
+/// compete in one draw.
+bool
+LotteryPolicy::IsShared() const
+{
+    return true;
+}
+
+void
+LotteryPolicy::Apply(void (*func)(Thread *)) const
+{
+    ASSERT(func != nullptr);
+
+    for (unsigned i = 0; i < count; i++) {
+        func(ready[i]);
+    }
+}
+
+unsigned long
+LotteryPolicy::Weight(const Thread *thread, unsigned long long minPass)
+{
+    unsigned long long halvings = (thread->pass - minPass) / LEAD_PER_HALVING;
+    if (halvings > MAX_HALVINGS) {
+        halvings = MAX_HALVINGS;
+    }
+    return ((unsigned long) thread->GetTickets() << MAX_HALVINGS) >> halvings;
+}
+
+unsigned long long
+LotteryPolicy::MinPass(const Thread *current) const
+{
+    unsigned long long minPass = current != nullptr ? current->pass
+                                                    : ready[0]->pass;
+    for (unsigned i = 0; i < count; i++) {
+        if (ready[i]->pass < minPass) {
+            minPass = ready[i]->pass;
+        }
+    }
+    return minPass;
+}
+
+unsigned long
+LotteryPolicy::TotalWeight(unsigned long long minPass) const
+{
+    unsigned long total = 0;
+    for (unsigned i = 0; i < count; i++) {
+        total += Weight(ready[i], minPass);
+    }
+    return total;
+}
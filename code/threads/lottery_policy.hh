@@ -0,0 +1,77 @@
+/// Lottery scheduling: randomized proportional share.
+///
+/// Every thread holds some tickets (see `Thread::SetTickets`).  Whenever a
+/// thread has to be chosen, a ticket is drawn at random and its holder
+/// runs, so that, on average, every thread gets a share of the CPU
+/// proportional to its tickets.
+///
+/// At every timer interrupt the running thread takes part in a draw
+/// against the ready ones, and keeps the CPU if it wins.  The random
+/// number generator is the one seeded by `-rs`, so runs are repeatable.
+///
+/// On a multiprocessor, all CPUs draw among the same ready threads.  Plain
+/// draws would then be biased: a thread running on another CPU cannot win
+/// again, so heavy threads get less than their share and light ones more.
+/// To correct it, every thread keeps a pass as under stride scheduling,
+/// and its tickets count half as much in a draw for every quantum (at the
+/// default tickets) it is ahead of the thread furthest behind.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_THREADS_LOTTERYPOLICY__HH
+#define NACHOS_THREADS_LOTTERYPOLICY__HH
+
+
+#include "scheduling_policy.hh"
+
+
+class LotteryPolicy : public SchedulingPolicy {
+public:
+
+    LotteryPolicy();
+
+    ~LotteryPolicy();
+
+    const char *GetName() const;
+
+    void Enqueue(Thread *thread);
+
+    Thread *Dequeue();
+
+    void Charge(Thread *thread, unsigned long ticks, bool blocked);
+
+    bool TimerTick(Thread *current);
+
+    bool NeedsTimer() const;
+
+    bool IsShared() const;
+
+    void Apply(void (*func)(Thread *)) const;
+
+private:
+
+    /// Tickets `thread` takes part in a draw with, given the lowest pass
+    /// among those drawing.
+    static unsigned long Weight(const Thread *thread,
+                                unsigned long long minPass);
+
+    /// Lowest pass among the ready threads and `current`, if any.
+    unsigned long long MinPass(const Thread *current) const;
+
+    /// Sum of the weights of every ready thread.
+    unsigned long TotalWeight(unsigned long long minPass) const;
+
+    /// Ready threads, in no particular order.
+    Thread **ready;
+    unsigned count;
+    unsigned capacity;
+
+    /// Lowest pass among the ready threads at the last dispatch.
+    unsigned long long globalPass;
+
+};
+
+
+#endif
@@ -11,7 +11,10 @@
 /// =====
 ///
 ///     nachos [-d <debugflags>] [-do <debugopts>] 
-///            [-rs <random seed #>] [-z] [-tt|-tN] 
+///            [-rs <random seed #>] [-sp <policy>] [-pool <size>]
+///            [-cpus <num cpus>] [-lp] [-nohz]
+///            [-record <log file>] [-replay <log file>]
+///            [-z] [-tt|-tN] 
 ///            [-m <num phys pages>]
 ///            [-s] [-x <nachos file>] [-tc <consoleIn> <consoleOut>] 
 ///            [-f] [-cp <unix file> <nachos file>] [-pr <nachos file>]
@@ -25,6 +28,20 @@
 /// * `-do` -- enables options that modify the behavior when printing
 ///            debugging messages.
 /// * `-rs` -- causes `Yield` to occur at random (but repeatable) spots.
+/// * `-sp` -- selects the scheduling policy: `priority` (the default),
+///            `mlfq`, `stride` or `lottery` (see `scheduling_policy.hh`).
+/// * `-pool` -- how many finished threads and stacks to keep for reuse
+///            (see `thread_pool.hh`); 0 disables recycling.
+/// * `-cpus` -- number of virtual CPUs to simulate (see `cpu.hh`).
+/// * `-lp` -- profiles lock contention and checks the lock order, with a
+///            report at halt (see `lock_profiler.hh`).
+/// * `-nohz` -- runs the timer only while it has work to do: while threads
+///            compete for a CPU, or an alarm is set (see `UpdateTimer` in
+///            `system.cc`).
+/// * `-record` -- logs every interrupt scheduled, and the console input, to
+///            a file, for `-replay` to repeat them in a later run (see
+///            `interrupt_log.hh`).  The log also keeps the `-rs`, `-nohz`,
+///            `-sp` and `-cpus` options, which a replay takes from it.
 /// * `-z`  -- prints version and copyright information, and exits.
 /// * `-m`  -- size of emulated physical memory (in pages)
 ///
@@ -41,6 +58,8 @@
 /// * `-s`  -- causes user programs to be executed in single-step mode.
 /// * `-x`  -- runs a user program.
 /// * `-tc` -- tests the console.
+/// * `-tfx` -- tests the futex table, on two address spaces loaded from the
+///            given program.
 ///
 /// *FILESYS* options
 /// -----------------
@@ -86,6 +105,7 @@ void Print(const char *file);
 void PerformanceTest(void);
 void StartProcess(const char *file);
 void ConsoleTest(const char *in, const char *out);
+void FutexTest(const char *file);
 
 static inline void
 PrintVersion()
@@ -151,6 +171,10 @@ main(int argc, char **argv)
             interrupt->Halt();  // Once we start the console, then Nachos
                                 // will loop forever waiting for console
                                 // input.
+        } else if (!strcmp(*argv, "-tfx")) {  // Test the futex table.
+            ASSERT(argc > 1);
+            FutexTest(*(argv + 1));
+            interrupt->Halt();
         }
 #endif
 #ifdef FILESYS
@@ -0,0 +1,135 @@
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "mlfq_policy.hh"
+#include "system.hh"
+
+
+/// Ticks between two priority boosts.
+static const unsigned long MLFQ_BOOST_PERIOD = 50 * TIMER_TICKS;
+
+/// Level that new and boosted threads are put in.
+static const unsigned MLFQ_TOP_LEVEL = NUM_QUEUES - 1;
+
+MlfqPolicy::MlfqPolicy()
+{
+    readyList  = new ReadyQueue;
+    boostEpoch = 1;  // Threads start with epoch 0, so they get boosted to
+                     // the top level the first time they become ready.
+    lastBoost  = 0;
+}
+
+MlfqPolicy::~MlfqPolicy()
+{
+    delete readyList;
+}
+
+const char *
+MlfqPolicy::GetName() const
+{
+    return "mlfq";
+}
+
+void
+MlfqPolicy::Enqueue(Thread *thread)
+{
+    if (thread->boostEpoch != boostEpoch) {
+        thread->boostEpoch  = boostEpoch;
+        thread->quantumUsed = 0;
+        thread->SetPriority(MLFQ_TOP_LEVEL);
+    }
+    readyList->Append(thread);
+}
+
+Thread *
+MlfqPolicy::Dequeue()
+{
+    return readyList->Pop();
+}
+
+void
+MlfqPolicy::PriorityChanged(Thread *thread)
+{
+    if (readyList->Has(thread)) {
+        readyList->Remove(thread);
+        readyList->Append(thread);
+    }
+}
+
+void
+MlfqPolicy::Charge(Thread *thread, unsigned long ticks, bool blocked)
+{
+    if (blocked) {
+        thread->quantumUsed = 0;
+    } else {
+        thread->quantumUsed += ticks;
+    }
+}
+
+/// The running thread is only preempted once it has used up the quantum of
+/// its level, and it is demoted at the same time.  Even then, it keeps the
+/// CPU if every ready thread is at a lower level.
+bool
+MlfqPolicy::TimerTick(Thread *current)
+{
+    if (stats->totalTicks - lastBoost >= MLFQ_BOOST_PERIOD) {
+        Boost(current);
+    }
+
+    if (current->quantumUsed < Quantum(current->GetPriority())) {
+        return false;
+    }
+
+    current->quantumUsed = 0;
+    if (current->GetOldPriority() > 0) {
+        current->SetPriority(current->GetOldPriority() - 1);
+        DEBUG('t', "Demoting thread \"%s\" to level %d\n",
+              current->GetName(), current->GetOldPriority());
+    }
+    return readyList->TopLevel() >= current->GetPriority();
+}
+
+bool
+MlfqPolicy::NeedsTimer() const
+{
+    return true;
+}
+
+void
+MlfqPolicy::Apply(void (*func)(Thread *)) const
+{
+    readyList->Apply(func);
+}
+
+unsigned long
+MlfqPolicy::Quantum(unsigned level) const
+{
+    ASSERT(level < NUM_QUEUES);
+    return TIMER_TICKS * (NUM_QUEUES - level);
+}
+
+/// Move every ready thread, and `current`, to the top level now.  Blocked
+/// threads are moved lazily, by `Enqueue`, when they see that `boostEpoch`
+/// has changed.
+void
+MlfqPolicy::Boost(Thread *current)
+{
+    DEBUG('t', "Boosting all threads to the top level\n");
+
+    boostEpoch++;
+    lastBoost = stats->totalTicks;
+
+    ReadyQueue *old = readyList;
+    readyList = new ReadyQueue;
+    Thread *t;
+    while ((t = old->Pop()) != nullptr) {
+        Enqueue(t);
+    }
+    delete old;
+
+    current->boostEpoch  = boostEpoch;
+    current->quantumUsed = 0;
+    current->SetPriority(MLFQ_TOP_LEVEL);
+}
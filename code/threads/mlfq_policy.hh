@@ -0,0 +1,70 @@
+/// Multilevel feedback queue scheduling.
+///
+/// Priorities are assigned by the policy, from the behavior of threads:
+///
+/// * new threads start at the top level;
+/// * a thread that uses up the quantum of its level is demoted one level;
+/// * a thread that blocks (on the console, the disk, a synchronization
+///   variable...) before using up its quantum keeps its level, and starts a
+///   fresh quantum when it runs again;
+/// * every `MLFQ_BOOST_PERIOD` ticks, every thread is moved back to the top
+///   level, so that CPU-bound threads do not starve.
+///
+/// Quanta grow towards the lower levels: CPU-bound threads end up there,
+/// and switching them less often costs less.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_THREADS_MLFQPOLICY__HH
+#define NACHOS_THREADS_MLFQPOLICY__HH
+
+
+#include "scheduling_policy.hh"
+#include "ready_queue.hh"
+
+
+class MlfqPolicy : public SchedulingPolicy {
+public:
+
+    MlfqPolicy();
+
+    ~MlfqPolicy();
+
+    const char *GetName() const;
+
+    void Enqueue(Thread *thread);
+
+    Thread *Dequeue();
+
+    void PriorityChanged(Thread *thread);
+
+    void Charge(Thread *thread, unsigned long ticks, bool blocked);
+
+    bool TimerTick(Thread *current);
+
+    bool NeedsTimer() const;
+
+    void Apply(void (*func)(Thread *)) const;
+
+private:
+
+    /// Length of the time slice of a level, in ticks.
+    unsigned long Quantum(unsigned level) const;
+
+    /// Move every thread back to the top level.
+    void Boost(Thread *current);
+
+    ReadyQueue *readyList;
+
+    /// Number of boosts so far, and tick of the last one.  Threads that are
+    /// blocked during a boost notice it when they next become ready, by
+    /// comparing with their own epoch.
+    unsigned boostEpoch;
+    unsigned long lastBoost;
+
+};
+
+
+#endif
@@ -0,0 +1,57 @@
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "priority_policy.hh"
+#include "thread.hh"
+
+
+PriorityPolicy::PriorityPolicy()
+{
+    readyList = new ReadyQueue;
+}
+
+PriorityPolicy::~PriorityPolicy()
+{
+    delete readyList;
+}
+
+const char *
+PriorityPolicy::GetName() const
+{
+    return "priority";
+}
+
+void
+PriorityPolicy::Enqueue(Thread *thread)
+{
+    readyList->Append(thread);
+}
+
+Thread *
+PriorityPolicy::Dequeue()
+{
+    return readyList->Pop();
+}
+
+/// Re-queue a ready thread whose priority has changed, so that it is
+/// dispatched at its new level.
+///
+/// Threads that are not in the ready list (running or blocked) are left
+/// alone; they will be queued at the right level the next time they are
+/// enqueued.
+void
+PriorityPolicy::PriorityChanged(Thread *thread)
+{
+    if (readyList->Has(thread)) {
+        readyList->Remove(thread);
+        readyList->Append(thread);
+    }
+}
+
+void
+PriorityPolicy::Apply(void (*func)(Thread *)) const
+{
+    readyList->Apply(func);
+}
@@ -0,0 +1,43 @@
+/// Strict priority scheduling.
+///
+/// The thread with the highest priority always runs; threads of the same
+/// priority are served in FIFO order, and take turns at every timer
+/// interrupt (if the timer is on).
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_THREADS_PRIORITYPOLICY__HH
+#define NACHOS_THREADS_PRIORITYPOLICY__HH
+
+
+#include "scheduling_policy.hh"
+#include "ready_queue.hh"
+
+
+class PriorityPolicy : public SchedulingPolicy {
+public:
+
+    PriorityPolicy();
+
+    ~PriorityPolicy();
+
+    const char *GetName() const;
+
+    void Enqueue(Thread *thread);
+
+    Thread *Dequeue();
+
+    void PriorityChanged(Thread *thread);
+
+    void Apply(void (*func)(Thread *)) const;
+
+private:
+
+    ReadyQueue *readyList;
+
+};
+
+
+#endif
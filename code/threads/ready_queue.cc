@@ -0,0 +1,163 @@
+/// Routines to manage the multilevel ready queue.
+///
+/// These routines assume that interrupts are already disabled, as the rest
+/// of the scheduler does.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "ready_queue.hh"
+#include "thread.hh"
+
+
+static inline unsigned
+LevelBit(unsigned level)
+{
+    return 1U << (NUM_QUEUES - 1 - level);
+}
+
+ReadyQueue::ReadyQueue()
+{
+    for (unsigned i = 0; i < NUM_QUEUES; i++) {
+        head[i] = tail[i] = nullptr;
+    }
+    occupied = 0;
+    count    = 0;
+}
+
+/// Put `thread` at the end of its level.
+///
+/// * `thread` is the thread to enqueue; it must not be in any ready queue.
+void
+ReadyQueue::Append(Thread *thread)
+{
+    ASSERT(thread != nullptr);
+    ASSERT(thread->readyQueue == nullptr);
+
+    unsigned level = thread->GetPriority();
+    ASSERT(level < NUM_QUEUES);
+
+    thread->readyQueue = this;
+    thread->readyLevel = level;
+    thread->readyNext  = nullptr;
+    thread->readyPrev  = tail[level];
+    if (tail[level] == nullptr) {
+        head[level] = thread;
+        occupied |= LevelBit(level);
+    } else {
+        tail[level]->readyNext = thread;
+    }
+    tail[level] = thread;
+    count++;
+}
+
+/// Put `thread` at the front of its level.
+///
+/// * `thread` is the thread to enqueue; it must not be in any ready queue.
+void
+ReadyQueue::Prepend(Thread *thread)
+{
+    ASSERT(thread != nullptr);
+    ASSERT(thread->readyQueue == nullptr);
+
+    unsigned level = thread->GetPriority();
+    ASSERT(level < NUM_QUEUES);
+
+    thread->readyQueue = this;
+    thread->readyLevel = level;
+    thread->readyPrev  = nullptr;
+    thread->readyNext  = head[level];
+    if (head[level] == nullptr) {
+        tail[level] = thread;
+        occupied |= LevelBit(level);
+    } else {
+        head[level]->readyPrev = thread;
+    }
+    head[level] = thread;
+    count++;
+}
+
+/// Return the first thread of the most urgent level, after unlinking it.
+Thread *
+ReadyQueue::Pop()
+{
+    if (occupied == 0) {
+        return nullptr;
+    }
+    Thread *thread = head[TopLevel()];
+    Remove(thread);
+    return thread;
+}
+
+/// Unlink `thread` from its level.
+///
+/// The level used is the one the thread was enqueued with, which may differ
+/// from its current priority if it has been donated one in the meantime.
+void
+ReadyQueue::Remove(Thread *thread)
+{
+    ASSERT(thread != nullptr);
+    ASSERT(thread->readyQueue == this);
+
+    unsigned level = thread->readyLevel;
+
+    if (thread->readyPrev == nullptr) {
+        head[level] = thread->readyNext;
+    } else {
+        thread->readyPrev->readyNext = thread->readyNext;
+    }
+    if (thread->readyNext == nullptr) {
+        tail[level] = thread->readyPrev;
+    } else {
+        thread->readyNext->readyPrev = thread->readyPrev;
+    }
+    if (head[level] == nullptr) {
+        occupied &= ~LevelBit(level);
+    }
+
+    thread->readyQueue = nullptr;
+    thread->readyNext  = thread->readyPrev = nullptr;
+    count--;
+}
+
+bool
+ReadyQueue::Has(const Thread *thread) const
+{
+    ASSERT(thread != nullptr);
+    return thread->readyQueue == this;
+}
+
+bool
+ReadyQueue::IsEmpty() const
+{
+    return occupied == 0;
+}
+
+unsigned
+ReadyQueue::Count() const
+{
+    return count;
+}
+
+int
+ReadyQueue::TopLevel() const
+{
+    if (occupied == 0) {
+        return -1;
+    }
+    return NUM_QUEUES - __builtin_ffs(occupied);
+}
+
+void
+ReadyQueue::Apply(void (*func)(Thread *)) const
+{
+    ASSERT(func != nullptr);
+
+    for (int level = NUM_QUEUES - 1; level >= 0; level--) {
+        for (Thread *t = head[level]; t != nullptr; t = t->readyNext) {
+            func(t);
+        }
+    }
+}
@@ -0,0 +1,75 @@
+/// Multilevel queue of threads that are ready to run.
+///
+/// There is one FIFO queue per priority level.  A bitmap records which
+/// levels are occupied, so the highest non-empty level is found with a
+/// single find-first-set instruction instead of a scan.  The queues are
+/// intrusive: the links live inside `Thread`, so no list element has to be
+/// allocated, and a thread can be unlinked from the middle of its queue in
+/// constant time (which is what priority donation needs).
+///
+/// All operations are O(1), except for `Apply`.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_THREADS_READYQUEUE__HH
+#define NACHOS_THREADS_READYQUEUE__HH
+
+
+class Thread;
+
+/// Number of priority levels.  Level `NUM_QUEUES - 1` is the most urgent.
+const unsigned NUM_QUEUES = 10;
+
+class ReadyQueue {
+public:
+
+    /// Initialize all levels to empty.
+    ReadyQueue();
+
+    /// Put `thread` at the tail of the level given by its priority.
+    void Append(Thread *thread);
+
+    /// Put `thread` at the head of the level given by its priority.
+    void Prepend(Thread *thread);
+
+    /// Take the first thread off the highest non-empty level.
+    ///
+    /// Returns null if there is no thread in any level.
+    Thread *Pop();
+
+    /// Unlink `thread` from whichever level it was put in.
+    ///
+    /// The thread must be in this queue.
+    void Remove(Thread *thread);
+
+    /// Is `thread` in this queue?
+    bool Has(const Thread *thread) const;
+
+    bool IsEmpty() const;
+
+    /// Number of threads in all levels.
+    unsigned Count() const;
+
+    /// Highest non-empty level, or -1 if the queue is empty.
+    int TopLevel() const;
+
+    /// Apply `func` to every thread, from the most urgent level down.
+    void Apply(void (*func)(Thread *)) const;
+
+private:
+
+    /// First and last thread of every level, null if the level is empty.
+    Thread *head[NUM_QUEUES];
+    Thread *tail[NUM_QUEUES];
+
+    /// Bit `NUM_QUEUES - 1 - level` is set iff `level` is not empty, so
+    /// that the lowest set bit corresponds to the most urgent level.
+    unsigned occupied;
+
+    unsigned count;
+};
+
+
+#endif
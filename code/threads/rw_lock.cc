@@ -0,0 +1,239 @@
+/// Routines for reader-writer locks.
+///
+/// The state is kept under an ordinary `Lock`, and threads wait on two
+/// condition variables: one for readers and one for writers (and the
+/// upgrading reader).
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "rw_lock.hh"
+#include "system.hh"
+
+
+RWLock::RWLock(const char *debugName)
+{
+    name           = debugName;
+    lock           = new Lock(debugName);
+    readersOk      = new Condition(debugName, lock);
+    writersOk      = new Condition(debugName, lock);
+    readers        = nullptr;
+    freeReaders    = nullptr;
+    numReaders     = 0;
+    writer         = nullptr;
+    writerReads    = 0;
+    waitingWriters = 0;
+    upgrader       = nullptr;
+}
+
+RWLock::~RWLock()
+{
+    ASSERT(readers == nullptr && writer == nullptr);
+    ASSERT(waitingWriters == 0 && upgrader == nullptr);
+
+    while (freeReaders != nullptr) {
+        Reader *next = freeReaders->next;
+        delete freeReaders;
+        freeReaders = next;
+    }
+    delete readersOk;
+    delete writersOk;
+    delete lock;
+}
+
+const char *
+RWLock::GetName() const
+{
+    return name;
+}
+
+void
+RWLock::AcquireRead()
+{
+    lock->Acquire();
+
+    Reader *reader;
+    if (writer == currentThread) {
+        writerReads++;
+    } else if ((reader = FindReader(currentThread)) != nullptr) {
+        reader->depth++;
+    } else {
+        while (writer != nullptr || waitingWriters > 0 || upgrader != nullptr) {
+            readersOk->Wait();
+        }
+        AddReader(currentThread, 1);
+    }
+
+    lock->Release();
+}
+
+void
+RWLock::ReleaseRead()
+{
+    lock->Acquire();
+
+    if (writer == currentThread) {
+        ASSERT(writerReads > 0);
+        writerReads--;
+    } else {
+        Reader *reader = FindReader(currentThread);
+        ASSERT(reader != nullptr);
+        if (--reader->depth == 0) {
+            RemoveReader(reader);
+            if (numReaders == 0) {
+                LastReaderLeft();
+            }
+        }
+    }
+
+    lock->Release();
+}
+
+void
+RWLock::AcquireWrite()
+{
+    lock->Acquire();
+
+    ASSERT(writer != currentThread && FindReader(currentThread) == nullptr);
+
+    waitingWriters++;
+    while (writer != nullptr || numReaders > 0 || upgrader != nullptr) {
+        writersOk->Wait();
+    }
+    waitingWriters--;
+    writer = currentThread;
+
+    lock->Release();
+}
+
+/// Other writers go first; if there are none, every waiting reader goes.
+void
+RWLock::ReleaseWrite()
+{
+    lock->Acquire();
+
+    ASSERT(writer == currentThread && writerReads == 0);
+
+    writer = nullptr;
+    if (waitingWriters > 0) {
+        writersOk->Signal();
+    } else {
+        readersOk->Broadcast();
+    }
+
+    lock->Release();
+}
+
+/// The upgrading reader stops counting as a reader right away, and goes
+/// ahead of the waiting writers.
+bool
+RWLock::Upgrade()
+{
+    lock->Acquire();
+
+    Reader *reader = FindReader(currentThread);
+    ASSERT(reader != nullptr && reader->depth == 1);
+
+    if (upgrader != nullptr) {
+        lock->Release();
+        return false;
+    }
+
+    RemoveReader(reader);
+    upgrader = currentThread;
+    while (numReaders > 0) {
+        writersOk->Wait();
+    }
+    upgrader = nullptr;
+    writer = currentThread;
+
+    lock->Release();
+    return true;
+}
+
+/// Nested reads of the writer carry over.  Waiting readers may join in,
+/// unless writers are waiting too.
+void
+RWLock::Downgrade()
+{
+    lock->Acquire();
+
+    ASSERT(writer == currentThread);
+
+    writer = nullptr;
+    AddReader(currentThread, 1 + writerReads);
+    writerReads = 0;
+    if (waitingWriters == 0) {
+        readersOk->Broadcast();
+    }
+
+    lock->Release();
+}
+
+bool
+RWLock::IsReadHeldByCurrentThread() const
+{
+    return writer == currentThread ? writerReads > 0
+                                   : FindReader(currentThread) != nullptr;
+}
+
+bool
+RWLock::IsWriteHeldByCurrentThread() const
+{
+    return writer == currentThread;
+}
+
+RWLock::Reader *
+RWLock::FindReader(const Thread *thread) const
+{
+    for (Reader *r = readers; r != nullptr; r = r->next) {
+        if (r->thread == thread) {
+            return r;
+        }
+    }
+    return nullptr;
+}
+
+void
+RWLock::AddReader(Thread *thread, unsigned depth)
+{
+    Reader *reader = freeReaders;
+    if (reader != nullptr) {
+        freeReaders = reader->next;
+    } else {
+        reader = new Reader;
+    }
+    reader->thread = thread;
+    reader->depth  = depth;
+    reader->next   = readers;
+    readers = reader;
+    numReaders++;
+}
+
+void
+RWLock::RemoveReader(Reader *reader)
+{
+    Reader **p = &readers;
+    while (*p != reader) {
+        ASSERT(*p != nullptr);
+        p = &(*p)->next;
+    }
+    *p = reader->next;
+    reader->next = freeReaders;
+    freeReaders = reader;
+    numReaders--;
+}
+
+/// An upgrading reader has to be woken up for sure, so every writer is;
+/// otherwise one writer is enough.
+void
+RWLock::LastReaderLeft()
+{
+    if (upgrader != nullptr) {
+        writersOk->Broadcast();
+    } else if (waitingWriters > 0) {
+        writersOk->Signal();
+    }
+}
@@ -0,0 +1,106 @@
+/// Reader-writer lock, a synchronization primitive
+///
+/// Any number of threads may hold the lock for reading at the same time,
+/// but only one for writing, and then nobody else.
+///
+/// * Writers have preference: once a writer is waiting, new readers wait
+///   until it is done, so that a steady stream of readers cannot starve it.
+/// * Reading is recursive: a thread that holds the lock, for reading or for
+///   writing, may acquire it again for reading, even if writers wait.  Every
+///   `AcquireRead` needs its own `ReleaseRead`.
+/// * A reader may become the writer (`Upgrade`) without letting other
+///   writers in between, and the writer may become a reader (`Downgrade`)
+///   without letting other writers in.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_THREADS_RWLOCK__HH
+#define NACHOS_THREADS_RWLOCK__HH
+
+
+#include "condition.hh"
+
+
+class RWLock {
+public:
+
+    /// Constructor: set up the lock as free.
+    RWLock(const char *debugName);
+
+    /// Nobody may hold or be waiting for the lock.
+    ~RWLock();
+
+    /// For debugging.
+    const char *GetName() const;
+
+    void AcquireRead();
+    void ReleaseRead();
+
+    /// The current thread must not hold the lock.
+    void AcquireWrite();
+    void ReleaseWrite();
+
+    /// Turn the read hold of the current thread into a write hold, waiting
+    /// for the other readers to leave.  Reads must not be nested.
+    ///
+    /// Returns false, still holding the lock for reading, if another reader
+    /// is upgrading already: waiting for it would deadlock.  Then the only
+    /// way to write is to release the lock and acquire it for writing.
+    bool Upgrade();
+
+    /// Turn the write hold of the current thread into a read hold.
+    void Downgrade();
+
+    bool IsReadHeldByCurrentThread() const;
+
+    bool IsWriteHeldByCurrentThread() const;
+
+private:
+
+    /// A thread holding the lock for reading, and how many times.
+    struct Reader {
+        Thread *thread;
+        unsigned depth;
+        Reader *next;
+    };
+
+    Reader *FindReader(const Thread *thread) const;
+
+    void AddReader(Thread *thread, unsigned depth);
+
+    void RemoveReader(Reader *reader);
+
+    /// Wake whoever may go on now that the last reader has left.
+    void LastReaderLeft();
+
+    /// For debugging.
+    const char *name;
+
+    /// Protects the fields below.
+    Lock *lock;
+
+    Condition *readersOk;
+    Condition *writersOk;
+
+    /// Threads holding the lock for reading, and how many; entries no
+    /// longer in use are kept in `freeReaders`, to avoid allocating.
+    Reader *readers;
+    Reader *freeReaders;
+    unsigned numReaders;
+
+    /// Thread holding the lock for writing, if any, and how many times it
+    /// acquired it for reading as well.
+    Thread *writer;
+    unsigned writerReads;
+
+    unsigned waitingWriters;
+
+    /// Reader waiting in `Upgrade`, if any.
+    Thread *upgrader;
+
+};
+
+
+#endif
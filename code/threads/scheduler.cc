@@ -9,8 +9,9 @@
 /// needed to wait for a lock, and the lock was busy, we would end up calling
 /// `FindNextToRun`, and that would put us in an infinite loop.
 ///
-/// Very simple implementation -- no priorities, straight FIFO.  Might need
-/// to be improved in later assignments.
+/// The choice of the next thread to run is delegated to a
+/// `SchedulingPolicy`; see `scheduling_policy.hh`.  On a simulated
+/// multiprocessor, every CPU has its own ready list; see `cpu.hh`.
 ///
 /// Copyright (c) 1992-1993 The Regents of the University of California.
 ///               2016-2021 Docentes de la Universidad Nacional de Rosario.
@@ -21,24 +22,89 @@
 #include "scheduler.hh"
 #include "system.hh"
 
+#include <limits.h>
 #include <stdio.h>
 
+
 /// Initialize the list of ready but not running threads to empty.
-Scheduler::Scheduler()
+///
+/// * `schedPolicy` decides which thread runs next; the scheduler takes
+///   ownership of it.
+Scheduler::Scheduler(SchedulingPolicy *schedPolicy)
 {
-    readyList = new List<Thread *>*[NUM_QUEUES];
-    for (unsigned i = 0; i < NUM_QUEUES; i++) {
-        readyList[i] = new List<Thread *>;
-    }
+    numCpus = 0;
+    AddCpu(schedPolicy);
+    currentCpu = cpus[0];
 }
 
 /// De-allocate the list of ready threads.
 Scheduler::~Scheduler()
 {
-    for (unsigned i = 0; i < NUM_QUEUES; i++) {
-        delete readyList[i];
+    // CPU 0 goes last, as it owns a shared policy.
+    for (unsigned i = numCpus; i > 0; i--) {
+        delete cpus[i - 1];
+    }
+}
+
+/// Body of the idle thread of every CPU, on a multiprocessor.
+///
+/// Run whatever is ready on this CPU, or else steal from another one; if
+/// there is nothing anywhere, let the other CPUs run.
+static void
+IdleLoop(void *arg)
+{
+    Cpu *cpu = (Cpu *) arg;
+
+    interrupt->SetLevel(INT_OFF);
+    for (;;) {
+        ASSERT(currentCpu == cpu);
+
+        Thread *next = scheduler->FindNextToRun();
+        if (next == nullptr) {
+            next = scheduler->Steal();
+        }
+        if (next != nullptr) {
+            scheduler->Run(next);  // Returns when the CPU runs out of work.
+        } else {
+            scheduler->IdleCpu();
+        }
+    }
+}
+
+/// Must be called after `currentThread` is set, because the first time it
+/// is called for a second CPU the simulation becomes a multiprocessor one.
+void
+Scheduler::AddCpu(SchedulingPolicy *cpuPolicy)
+{
+    ASSERT(numCpus < MAX_CPUS);
+
+    Cpu *cpu = new Cpu(numCpus, cpuPolicy);
+    cpus[numCpus++] = cpu;
+    stats->numCpus = numCpus;
+    if (numCpus == 1) {
+        return;
+    }
+
+    for (unsigned i = 0; i < numCpus; i++) {
+        if (cpus[i]->idleThread != nullptr) {
+            continue;
+        }
+        char *name = new char [16];
+        sprintf(name, "idle %u", i);
+        Thread *idle = new Thread(name, 0, 0);
+        idle->cpu = cpus[i];
+        idle->StackAllocate(IdleLoop, cpus[i]);
+        cpus[i]->idleThread = idle;
+        if (cpus[i]->current == nullptr) {
+            cpus[i]->current = idle;
+        }
     }
-    delete[] readyList;
+}
+
+unsigned
+Scheduler::GetNumCpus() const
+{
+    return numCpus;
 }
 
 /// Mark a thread as ready, but not running.
@@ -52,26 +118,77 @@ Scheduler::ReadyToRun(Thread *thread)
 
     DEBUG('t', "Putting thread %s on ready list\n", thread->GetName());
 
+    if (thread == currentThread && thread->status == RUNNING) {
+        Charge(thread);  // It is yielding; its usage may decide where it
+                         // goes.  (A blocked thread woken up while the
+                         // machine idles was charged when it blocked.)
+        thread->accounting.Yielded(stats->totalTicks);
+    } else if (thread->status == BLOCKED) {
+        thread->accounting.WokenUp(stats->totalTicks);
+    } else {
+        thread->accounting.since = stats->totalTicks;  // Just forked.
+    }
     thread->SetStatus(READY);
-    int priority = thread->GetPriority();
-    readyList[priority]->Append(thread);
+
+    // Threads go back to the CPU they last ran on, if any.
+    if (thread->cpu == nullptr) {
+        thread->cpu = currentCpu;
+    }
+    PolicyOf(thread)->Enqueue(thread);
+    if (!thread->IsRealTime()) {
+        thread->cpu->numReady++;
+    }
+    UpdateTimer();
 }
 
 /// Return the next thread to be scheduled onto the CPU.
 ///
-/// If there are no ready threads, return null.
+/// Ready real-time threads go first.  If there are no ready threads, return
+/// null.
 ///
 /// Side effect: thread is removed from the ready list.
 Thread *
 Scheduler::FindNextToRun()
 {
-    unsigned i = 9;
-    while (readyList[i]->IsEmpty()) {
-        if (i == 0)
-            return nullptr;
-        i--;
+    Thread *thread = currentCpu->realTime->Dequeue();
+    if (thread != nullptr) {
+        return thread;
+    }
+
+    // With a shared policy, the thread may have last run on another CPU.
+    thread = currentCpu->readyList->Dequeue();
+    if (thread != nullptr) {
+        thread->cpu->numReady--;
+    }
+    return thread;
+}
+
+Thread *
+Scheduler::Steal()
+{
+    Cpu *victim = nullptr;
+    for (unsigned i = 0; i < numCpus; i++) {
+        if (cpus[i] != currentCpu && cpus[i]->numReady > 0
+              && (victim == nullptr || cpus[i]->numReady > victim->numReady)) {
+            victim = cpus[i];
+        }
+    }
+    if (victim == nullptr) {
+        return nullptr;
     }
-    return readyList[i]->Pop();
+
+    Thread *thread = victim->readyList->Dequeue();
+    ASSERT(thread != nullptr);
+    thread->cpu->numReady--;
+    DEBUG('t', "CPU %u steals thread \"%s\" from CPU %u\n",
+          currentCpu->id, thread->GetName(), victim->id);
+    return thread;
+}
+
+Thread *
+Scheduler::GetIdleThread() const
+{
+    return currentCpu->idleThread;
 }
 
 /// Dispatch the CPU to `nextThread`.
@@ -80,7 +197,8 @@ Scheduler::FindNextToRun()
 /// by calling the machine dependent context switch routine, `SWITCH`.
 ///
 /// Note: we assume the state of the previously running thread has already
-/// been changed from running to blocked or ready (depending).
+/// been changed from running to blocked or ready (depending), and that it
+/// has been charged for its CPU time.
 ///
 /// Side effect: the global variable `currentThread` becomes `nextThread`.
 ///
@@ -103,8 +221,22 @@ Scheduler::Run(Thread *nextThread)
     oldThread->CheckOverflow();  // Check if the old thread had an undetected
                                  // stack overflow.
 
+    nextThread->dispatchTick = stats->totalTicks;
+    nextThread->accounting.Dispatched(stats->totalTicks);
+
+    if (oldThread == currentCpu->idleThread
+          && currentCpu->clock < stats->totalTicks) {
+        currentCpu->clock = stats->totalTicks;  // Catch up after idling.
+    }
+    if (nextThread->cpu != currentCpu && nextThread->cpu != nullptr) {
+        stats->cpuMigrations[currentCpu->id]++;
+    }
+    nextThread->cpu = currentCpu;
+    currentCpu->current = nextThread;
+
     currentThread = nextThread;  // Switch to the next thread.
     currentThread->SetStatus(RUNNING);  // `nextThread` is now running.
+    stats->numContextSwitches++;
 
     DEBUG('t', "Switching from thread \"%s\" to thread \"%s\"\n",
           oldThread->GetName(), nextThread->GetName());
@@ -132,6 +264,7 @@ Scheduler::Run(Thread *nextThread)
         // If there is an address space to restore, do it.
         currentThread->RestoreUserState();
         currentThread->space->RestoreState();
+        currentThread->space->RestartAtomicSequence();
     }
 #endif
 }
@@ -150,19 +283,305 @@ ThreadPrint(Thread *t)
 void
 Scheduler::Print()
 {
-    printf("Ready list contents:\n");
-    for (unsigned i = 9; i >= 0; i--) {
-        if (readyList[i]->IsEmpty())
-            printf("Queue %u is empty\n", i);
-        else
-            readyList[i]->Apply(ThreadPrint);
+    for (unsigned i = 0; i < numCpus; i++) {
+        if (numCpus > 1) {
+            printf("CPU %u: ", i);
+        }
+        printf("Ready list contents:\n");
+        cpus[i]->realTime->Apply(ThreadPrint);
+        if (i == 0 || !cpus[i]->readyList->IsShared()) {
+            cpus[i]->readyList->Apply(ThreadPrint);
+        }
+        printf("\n");
     }
 }
 
+/// Let the policy re-queue `thread`, if it is ready, now that its priority
+/// has changed.
+///
+/// * `thread` is the thread whose priority changed.
 void
 Scheduler::ChangePriority(Thread *thread)
 {
-    int oldPriority = thread->GetOldPriority();
-    readyList[oldPriority]->Remove(thread);
-    ReadyToRun(thread);
+    ASSERT(thread != nullptr);
+    PolicyOf(thread)->PriorityChanged(thread);
+}
+
+/// Called from the timer interrupt handler, with interrupts disabled.
+///
+/// The real-time class is always consulted, as it enforces budgets and
+/// deadlines; the policy of the normal threads only if `timeSlice`.
+///
+/// On a multiprocessor, the threads running on the other CPUs are also
+/// accounted for, and those CPUs are told to preempt them if their policy
+/// says so.
+bool
+Scheduler::TimerTick(bool timeSlice)
+{
+    bool preempt = false;
+    for (unsigned i = 0; i < numCpus; i++) {
+        Cpu *cpu = cpus[i];
+        if (cpu->IsIdle() || cpu->current->status != RUNNING) {
+            continue;  // Nothing running; the last thread may have blocked
+                       // with the machine waiting in `Interrupt::Idle`.
+        }
+        Charge(cpu->current);
+        bool expired = cpu->realTime->TimerTick(cpu->current);
+        if (!expired && timeSlice && !cpu->current->IsRealTime()) {
+            expired = cpu->readyList->TimerTick(cpu->current);
+        }
+        if (expired) {
+            if (cpu == currentCpu) {
+                preempt = true;
+            } else {
+                cpu->yieldPending = true;
+            }
+        }
+    }
+    return preempt;
+}
+
+bool
+Scheduler::NeedsTimer() const
+{
+    return cpus[0]->readyList->NeedsTimer();
+}
+
+bool
+Scheduler::NeedsTick(bool timeSlice) const
+{
+    for (unsigned i = 0; i < numCpus; i++) {
+        const Cpu *cpu = cpus[i];
+        if ((timeSlice && cpu->numReady > 0)
+              || cpu->realTime->GetUtilization() > 0
+              || !cpu->realTime->IsEmpty()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+const char *
+Scheduler::GetPolicyName() const
+{
+    return cpus[0]->readyList->GetName();
+}
+
+void
+Scheduler::Charge(Thread *thread)
+{
+    ASSERT(thread != nullptr);
+
+    unsigned long now = stats->totalTicks;
+    unsigned long ticks = now - thread->dispatchTick;
+    thread->accounting.runningTicks += ticks;
+    thread->dispatchTick = now;
+    if (thread->status == BLOCKED) {
+        thread->accounting.Blocked(now);
+    }
+    PolicyOf(thread)->Charge(thread, ticks, thread->status == BLOCKED);
+}
+
+/// Advance the clock of the current CPU, and return the clock of the
+/// running CPU that is furthest behind, which is the global time.  Idle
+/// CPUs do not hold time back.
+unsigned long
+Scheduler::Step(unsigned long ticks, bool user)
+{
+    if (numCpus == 1) {
+        return stats->totalTicks + ticks;
+    }
+
+    if (!currentCpu->IsIdle()) {
+        currentCpu->clock += ticks;
+        if (user) {
+            stats->cpuUserTicks[currentCpu->id] += ticks;
+        } else {
+            stats->cpuSystemTicks[currentCpu->id] += ticks;
+        }
+    }
+
+    unsigned long now = ULONG_MAX;
+    for (unsigned i = 0; i < numCpus; i++) {
+        if (!cpus[i]->IsIdle() && cpus[i]->clock < now) {
+            now = cpus[i]->clock;
+        }
+    }
+    return now != ULONG_MAX && now > stats->totalTicks ? now
+                                                       : stats->totalTicks;
+}
+
+bool
+Scheduler::TakePendingYield()
+{
+    if (!currentCpu->yieldPending) {
+        return false;
+    }
+    currentCpu->yieldPending = false;
+    return !currentCpu->IsIdle();
+}
+
+/// Called with interrupts disabled.
+void
+Scheduler::Rotate()
+{
+    if (numCpus == 1) {
+        return;
+    }
+
+    Cpu *next = PickCpu(nullptr);
+    if (next != nullptr && next != currentCpu) {
+        SwitchCpu(next);
+    }
+}
+
+/// If every CPU is idle, wait for an interrupt, as `Thread::Sleep` does on
+/// a uniprocessor.
+///
+/// Called with interrupts disabled.
+void
+Scheduler::IdleCpu()
+{
+    ASSERT(currentCpu->IsIdle());
+
+    Cpu *next = PickCpu(currentCpu);
+    if (next != nullptr) {
+        SwitchCpu(next);
+    } else {
+        interrupt->Idle();
+    }
+}
+
+/// Admit `thread` in the real-time class, with `period` and `budget` in
+/// ticks, or take it out of it if `period` is 0.
+///
+/// The thread stays on its CPU if it fits there; otherwise it moves to the
+/// first one it fits on.  Returns false if it does not fit anywhere; then
+/// it is left as it was.
+///
+/// * `thread` must be the current thread, or not yet forked.
+bool
+Scheduler::SetRealTime(Thread *thread, unsigned long period,
+                       unsigned long budget)
+{
+    ASSERT(thread != nullptr);
+    ASSERT(thread == currentThread || thread->status == JUST_CREATED);
+    ASSERT(period == 0 || (budget > 0 && budget <= period));
+
+    IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
+
+    Cpu *home = thread->cpu != nullptr ? thread->cpu : currentCpu;
+    if (thread->IsRealTime()) {
+        home->realTime->Leave(thread);
+    }
+
+    Cpu *target = nullptr;
+    for (unsigned i = 0; period != 0 && i < numCpus; i++) {
+        Cpu *cpu = cpus[(home->id + i) % numCpus];
+        if (cpu->realTime->Admit(period, budget)) {
+            target = cpu;
+            break;
+        }
+    }
+
+    bool admitted = period == 0 || target != nullptr;
+    if (!admitted) {
+        if (thread->IsRealTime()) {
+            home->realTime->Admit(thread->rtPeriod, thread->rtBudget);
+        }
+    } else if (period == 0) {
+        thread->rtPeriod = thread->rtBudget = 0;
+        DEBUG('t', "Thread \"%s\" leaves the real-time class\n",
+              thread->GetName());
+    } else {
+        thread->rtPeriod = period;
+        thread->rtBudget = budget;
+        thread->cpu      = target;
+        target->realTime->Start(thread);
+        DEBUG('t', "Thread \"%s\" admitted on CPU %u, period %lu, budget %lu\n",
+              thread->GetName(), target->id, period, budget);
+    }
+    UpdateTimer();
+
+    interrupt->SetLevel(oldLevel);
+    return admitted;
+}
+
+bool
+Scheduler::Throttle(Thread *thread)
+{
+    ASSERT(thread != nullptr);
+    return thread->IsRealTime() && thread->cpu->realTime->Throttle(thread);
+}
+
+SchedulingPolicy *
+Scheduler::PolicyOf(const Thread *thread) const
+{
+    Cpu *cpu = thread->cpu != nullptr ? thread->cpu : currentCpu;
+    return thread->IsRealTime() ? cpu->realTime : cpu->readyList;
+}
+
+Cpu *
+Scheduler::PickCpu(const Cpu *except) const
+{
+    bool work = false;
+    for (unsigned i = 0; i < numCpus; i++) {
+        if (cpus[i]->numReady > 0) {
+            work = true;
+        }
+    }
+
+    // An idle CPU that can find work goes first, so that ready threads do
+    // not wait for a busy CPU; otherwise, the busy CPU furthest behind.
+    Cpu *best = nullptr;
+    for (unsigned i = 0; i < numCpus; i++) {
+        Cpu *cpu = cpus[i];
+        if (cpu == except) {
+            continue;
+        }
+        if (cpu->IsIdle()) {
+            if (work || !cpu->realTime->IsEmpty()) {
+                return cpu;
+            }
+        } else if (best == nullptr || cpu->clock < best->clock) {
+            best = cpu;
+        }
+    }
+    return best;
+}
+
+void
+Scheduler::SwitchCpu(Cpu *next)
+{
+    ASSERT(next != nullptr && next != currentCpu);
+    ASSERT(interrupt->GetLevel() == INT_OFF);
+
+    Thread *oldThread = currentThread;
+
+    DEBUG('t', "Switching from CPU %u to CPU %u\n", currentCpu->id, next->id);
+
+    currentCpu    = next;
+    currentThread = next->current;
+#ifdef USER_PROGRAM
+    if (machine != nullptr) {
+        machine->SelectCpu(next->id);
+    }
+#endif
+
+    SWITCH(oldThread, currentThread);
+
+    // Back on the CPU that was left; whoever switched to it has already
+    // selected it.
+
+    if (threadToBeDestroyed != nullptr) {
+        delete threadToBeDestroyed;
+        threadToBeDestroyed = nullptr;
+    }
+
+#ifdef USER_PROGRAM
+    // Threads on the other CPUs may have run in the meantime.
+    if (machine != nullptr && currentThread->space != nullptr) {
+        currentThread->space->RestartAtomicSequence();
+    }
+#endif
 }
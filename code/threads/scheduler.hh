@@ -12,9 +12,9 @@
 
 
 #include "thread.hh"
-#include "lib/list.hh"
-
-const unsigned NUM_QUEUES = 10;
+#include "scheduling_policy.hh"
+#include "cpu.hh"
+#include "machine/statistics.hh"
 
 /// The following class defines the scheduler/dispatcher abstraction --
 /// the data structures and operations needed to keep track of which
@@ -22,30 +22,102 @@ const unsigned NUM_QUEUES = 10;
 class Scheduler {
 public:
 
-    /// Initialize list of ready threads.
-    Scheduler();
+    /// Initialize list of ready threads, to be managed by `schedPolicy`.
+    Scheduler(SchedulingPolicy *schedPolicy);
 
     /// De-allocate ready list.
     ~Scheduler();
 
+    /// Add another virtual CPU, whose ready list is managed by `cpuPolicy`.
+    /// See `cpu.hh`.
+    void AddCpu(SchedulingPolicy *cpuPolicy);
+
+    unsigned GetNumCpus() const;
+
     /// Thread can be dispatched.
     void ReadyToRun(Thread *thread);
 
     /// Dequeue first thread on the ready list, if any, and return thread.
     Thread *FindNextToRun();
 
+    /// Dequeue the first thread of the longest ready list of another CPU,
+    /// if any, and return it.
+    Thread *Steal();
+
+    /// Idle thread of the current CPU; null on a uniprocessor.
+    Thread *GetIdleThread() const;
+
     /// Cause `nextThread` to start running.
     void Run(Thread *nextThread);
 
     // Print contents of ready list.
     void Print();
 
+    /// Let the policy know that the priority of `thread` has changed.
     void ChangePriority(Thread *thread);
 
+    /// Account for a timer interrupt.  Returns whether the running thread
+    /// should be preempted.  Normal threads are only time sliced if
+    /// `timeSlice`.
+    bool TimerTick(bool timeSlice);
+
+    /// Does the policy need the timer device to preempt threads, even when
+    /// random yields were not requested?
+    bool NeedsTimer() const;
+
+    /// Would a timer interrupt now have anything to do?  Only if some
+    /// thread is waiting for a CPU and `timeSlice` is set, or there are
+    /// real-time threads, whose deadlines must be kept track of.
+    bool NeedsTick(bool timeSlice) const;
+
+    const char *GetPolicyName() const;
+
+    /// Charge the running `thread` for the CPU time used since it was
+    /// dispatched or last charged.  Must be called whenever it stops
+    /// running.  If it is blocking, it starts to count as blocked.
+    void Charge(Thread *thread);
+
+    /// Put `thread` in the real-time class, or take it out; see
+    /// `edf_policy.hh`.  Returns whether it was admitted.
+    bool SetRealTime(Thread *thread, unsigned long period,
+                     unsigned long budget);
+
+    /// Throttle `thread` if it is real-time and has used up its budget.
+    /// Returns whether it did.
+    bool Throttle(Thread *thread);
+
+    /// Multiprocessor simulation; these are called from
+    /// `Interrupt::OneTick` and do nothing on a uniprocessor.
+
+    /// The current CPU has run for `ticks`, of user code if `user`.
+    /// Returns the new global time.
+    unsigned long Step(unsigned long ticks, bool user);
+
+    /// Should the current CPU preempt its thread because of a timer
+    /// interrupt taken on another CPU?
+    bool TakePendingYield();
+
+    /// Let the CPU that is furthest behind run.
+    void Rotate();
+
+    /// Called by the idle thread when it has found nothing to do.
+    void IdleCpu();
+
 private:
 
-    // Queue of threads that are ready to run, but not running.
-    List<Thread*> **readyList;
+    /// Ready list that `thread` is, or would be, in.
+    SchedulingPolicy *PolicyOf(const Thread *thread) const;
+
+    /// CPU that should run next, other than `except`: the one furthest
+    /// behind among those running a thread, or that could find one.
+    Cpu *PickCpu(const Cpu *except) const;
+
+    /// Hand the host over to `next`.  Returns once this CPU is picked
+    /// again.
+    void SwitchCpu(Cpu *next);
+
+    Cpu *cpus[MAX_CPUS];
+    unsigned numCpus;
 
 };
 
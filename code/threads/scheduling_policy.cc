@@ -0,0 +1,32 @@
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "scheduling_policy.hh"
+#include "priority_policy.hh"
+#include "mlfq_policy.hh"
+#include "stride_policy.hh"
+#include "lottery_policy.hh"
+
+#include <string.h>
+
+
+SchedulingPolicy *
+NewSchedulingPolicy(const char *name)
+{
+    if (name == nullptr) {
+        return nullptr;
+    }
+
+    if (!strcmp(name, "priority")) {
+        return new PriorityPolicy;
+    } else if (!strcmp(name, "mlfq")) {
+        return new MlfqPolicy;
+    } else if (!strcmp(name, "stride")) {
+        return new StridePolicy;
+    } else if (!strcmp(name, "lottery")) {
+        return new LotteryPolicy;
+    }
+    return nullptr;
+}
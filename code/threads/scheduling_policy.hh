@@ -0,0 +1,75 @@
+/// Interface between the dispatcher and the scheduling policies.
+///
+/// `Scheduler` does the mechanics of dispatching (switching contexts,
+/// charging threads for the CPU time they used), and delegates to a
+/// `SchedulingPolicy` the decision of which ready thread runs next and
+/// whether the running thread should be preempted at a timer interrupt.
+///
+/// The policy is chosen at boot, with the `-sp` flag.  The available ones
+/// are:
+///
+/// * `priority` -- strict priorities, FIFO within a level (the default).
+/// * `mlfq` -- multilevel feedback queue.
+/// * `stride` -- deterministic proportional share, by tickets.
+/// * `lottery` -- randomized proportional share, by tickets.
+///
+/// Real-time threads are scheduled apart, ahead of these; see
+/// `edf_policy.hh`.
+///
+/// Every method is called with interrupts disabled.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_THREADS_SCHEDULINGPOLICY__HH
+#define NACHOS_THREADS_SCHEDULINGPOLICY__HH
+
+
+class Thread;
+
+class SchedulingPolicy {
+public:
+
+    virtual ~SchedulingPolicy() {}
+
+    virtual const char *GetName() const = 0;
+
+    /// Add `thread`, which has just become ready, to the ready set.
+    virtual void Enqueue(Thread *thread) = 0;
+
+    /// Take the thread that should run next off the ready set.
+    ///
+    /// Returns null if there are no ready threads.
+    virtual Thread *Dequeue() = 0;
+
+    /// The priority of `thread` has changed (for example, because of
+    /// priority inheritance).  It may or may not be in the ready set.
+    virtual void PriorityChanged(Thread *thread) {}
+
+    /// `thread` has used the CPU for `ticks` ticks since it was last
+    /// charged.  `blocked` tells whether it is giving up the CPU to wait
+    /// for some event.
+    virtual void Charge(Thread *thread, unsigned long ticks, bool blocked) {}
+
+    /// Called at every timer interrupt, after `current` has been charged.
+    /// Returns whether `current` should be preempted.
+    virtual bool TimerTick(Thread *current) { return true; }
+
+    /// Does the policy rely on timer interrupts to work?
+    virtual bool NeedsTimer() const { return false; }
+
+    /// Should every CPU share this instance, and so a single ready set,
+    /// instead of having one of its own?
+    virtual bool IsShared() const { return false; }
+
+    /// Apply `func` to every ready thread.
+    virtual void Apply(void (*func)(Thread *)) const = 0;
+
+};
+
+/// Build the policy called `name`, or return null if there is none.
+SchedulingPolicy *NewSchedulingPolicy(const char *name);
+
+
+#endif
@@ -34,6 +34,8 @@ Semaphore::Semaphore(const char *debugName, int initialValue)
     name  = debugName;
     value = initialValue;
     queue = new List<Thread *>;
+    profile = lockProfiler != nullptr
+              ? lockProfiler->Register(SYNC_SEMAPHORE, debugName) : nullptr;
 }
 
 /// De-allocate semaphore, when no longer needed.
@@ -63,11 +65,16 @@ Semaphore::P()
     IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
       // Disable interrupts.
 
+    bool contended = value == 0;
+    unsigned long start = stats->totalTicks;
     while (value == 0) {  // Semaphore not available.
         queue->Append(currentThread);  // So go to sleep.
         currentThread->Sleep();
     }
     value--;  // Semaphore available, consume its value.
+    if (profile != nullptr) {
+        profile->Acquired(contended, stats->totalTicks - start);
+    }
 
     DEBUG('s', "Semaphore P() done.\n");
     interrupt->SetLevel(oldLevel);  // Re-enable interrupts.
@@ -24,6 +24,9 @@
 #include "lib/list.hh"
 
 
+class SyncProfile;
+
+
 /// This class defines a “semaphore”, which has a positive integer as its
 /// value.
 ///
@@ -66,6 +69,9 @@ private:
     /// Queue of threads waiting on `P` because the value is zero.
     List<Thread *> *queue;
 
+    /// Where to account for contention, if profiling.
+    SyncProfile *profile;
+
 };
 
 
@@ -0,0 +1,151 @@
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "stride_policy.hh"
+#include "system.hh"
+
+
+/// Stride of a thread with a single ticket.  Large, so that the integer
+/// division by the number of tickets loses little precision.
+static const unsigned long long STRIDE1 = 1 << 20;
+
+static const unsigned INITIAL_CAPACITY = 16;
+
+static inline unsigned long long
+Stride(const Thread *thread)
+{
+    return STRIDE1 / thread->GetTickets();
+}
+
+StridePolicy::StridePolicy()
+{
+    capacity   = INITIAL_CAPACITY;
+    heap       = new Thread *[capacity];
+    count      = 0;
+    globalPass = 0;
+}
+
+StridePolicy::~StridePolicy()
+{
+    delete [] heap;
+}
+
+const char *
+StridePolicy::GetName() const
+{
+    return "stride";
+}
+
+void
+StridePolicy::Enqueue(Thread *thread)
+{
+    if (thread->pass < globalPass) {
+        thread->pass = globalPass;
+    }
+
+    if (count == capacity) {
+        Thread **old = heap;
+        capacity *= 2;
+        heap = new Thread *[capacity];
+        for (unsigned i = 0; i < count; i++) {
+            heap[i] = old[i];
+        }
+        delete [] old;
+    }
+    heap[count] = thread;
+    SiftUp(count++);
+}
+
+Thread *
+StridePolicy::Dequeue()
+{
+    if (count == 0) {
+        return nullptr;
+    }
+
+    Thread *thread = heap[0];
+    heap[0] = heap[--count];
+    SiftDown(0);
+    globalPass = thread->pass;
+    return thread;
+}
+
+void
+StridePolicy::Charge(Thread *thread, unsigned long ticks, bool blocked)
+{
+    thread->pass += Stride(thread) * ticks;
+}
+
+/// Preempt the running thread as soon as some ready thread is not ahead of
+/// it.
+bool
+StridePolicy::TimerTick(Thread *current)
+{
+    return count > 0 && heap[0]->pass <= current->pass;
+}
+
+bool
+StridePolicy::NeedsTimer() const
+{
+    return true;
+}
+
+/// Tickets are a share of the whole machine, so the threads of every CPU
+/// compete in one pass order.
+bool
+StridePolicy::IsShared() const
+{
+    return true;
+}
+
+void
+StridePolicy::Apply(void (*func)(Thread *)) const
+{
+    ASSERT(func != nullptr);
+
+    for (unsigned i = 0; i < count; i++) {
+        func(heap[i]);
+    }
+}
+
+void
+StridePolicy::SiftUp(unsigned i)
+{
+    Thread *thread = heap[i];
+    while (i > 0) {
+        unsigned parent = (i - 1) / 2;
+        if (heap[parent]->pass <= thread->pass) {
+            break;
+        }
+        heap[i] = heap[parent];
+        i = parent;
+    }
+    heap[i] = thread;
+}
+
+void
+StridePolicy::SiftDown(unsigned i)
+{
+    if (count == 0) {
+        return;
+    }
+
+    Thread *thread = heap[i];
+    for (;;) {
+        unsigned child = 2 * i + 1;
+        if (child >= count) {
+            break;
+        }
+        if (child + 1 < count && heap[child + 1]->pass < heap[child]->pass) {
+            child++;
+        }
+        if (thread->pass <= heap[child]->pass) {
+            break;
+        }
+        heap[i] = heap[child];
+        i = child;
+    }
+    heap[i] = thread;
+}
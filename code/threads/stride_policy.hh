@@ -0,0 +1,68 @@
+/// Stride scheduling: deterministic proportional share.
+///
+/// Every thread holds some tickets (see `Thread::SetTickets`), and has a
+/// stride inversely proportional to them.  Each thread also has a pass
+/// value, which advances by its stride for every tick it runs; the ready
+/// thread with the lowest pass runs next.  Over time, every thread gets a
+/// share of the CPU proportional to its tickets, with an error that does
+/// not grow with the number of quanta.
+///
+/// A thread that becomes ready again after blocking does not get to claim
+/// the share it did not use meanwhile: its pass is moved up to the global
+/// pass (that of the last thread dispatched).
+///
+/// The ready threads are kept in a binary min-heap, ordered by pass.  On a
+/// multiprocessor, all CPUs share the heap and the global pass.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_THREADS_STRIDEPOLICY__HH
+#define NACHOS_THREADS_STRIDEPOLICY__HH
+
+
+#include "scheduling_policy.hh"
+
+
+class StridePolicy : public SchedulingPolicy {
+public:
+
+    StridePolicy();
+
+    ~StridePolicy();
+
+    const char *GetName() const;
+
+    void Enqueue(Thread *thread);
+
+    Thread *Dequeue();
+
+    void Charge(Thread *thread, unsigned long ticks, bool blocked);
+
+    bool TimerTick(Thread *current);
+
+    bool NeedsTimer() const;
+
+    bool IsShared() const;
+
+    void Apply(void (*func)(Thread *)) const;
+
+private:
+
+    void SiftUp(unsigned i);
+
+    void SiftDown(unsigned i);
+
+    /// Heap of ready threads; `heap[0]` has the lowest pass.
+    Thread **heap;
+    unsigned count;
+    unsigned capacity;
+
+    /// Pass of the last thread dispatched.
+    unsigned long long globalPass;
+
+};
+
+
+#endif
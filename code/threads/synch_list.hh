@@ -3,6 +3,9 @@
 /// Implemented by surrounding the `List` abstraction with synchronization
 /// routines.
 ///
+/// A list may be given a capacity, so that producers running ahead of their
+/// consumers are held back instead of piling up items without limit.
+///
 /// Copyright (c) 1992-1993 The Regents of the University of California.
 ///               2016-2021 Docentes de la Universidad Nacional de Rosario.
 /// All rights reserved.  See `copyright.h` for copyright notice and
@@ -13,6 +16,7 @@
 
 
 #include "condition.hh"
+#include "system.hh"
 #include "lib/list.hh"
 
 
@@ -22,24 +26,40 @@
 /// 1. Threads trying to remove an item from a list will wait until the list
 ///    has an element on it.
 /// 2. One thread at a time can access list data structures.
+/// 3. If the list is bounded, threads trying to append an item will wait
+///    until the list has room for it.
 template <class Item>
 class SynchList {
 public:
 
-    /// Initialize a synchronized list.
-    SynchList();
+    /// Initialize a synchronized list, holding at most `maxItems` items, or
+    /// unbounded if 0.
+    SynchList(unsigned maxItems = 0);
 
     // De-allocate a synchronized list.
     ~SynchList();
 
     /// Append item to the end of the list, and wake up any thread waiting in
-    /// remove.
+    /// remove.  Wait first if the list is full.
     void Append(Item item);
 
     /// Remove the first item from the front of the list, waiting if the list
     /// is empty.
     Item Pop();
 
+    /// Same as `Pop`, but give up once `ticks` ticks have gone by and the
+    /// list is still empty.  Returns whether an item was removed.
+    bool Pop(Item *item, unsigned long ticks);
+
+    /// Remove up to `max` items from the front of the list, in order, with a
+    /// single acquisition of the lock.  Wait only if the list is empty.
+    ///
+    /// Returns the number of items removed.
+    unsigned PopBatch(Item *items, unsigned max);
+
+    /// Number of items in the list.
+    unsigned GetCount();
+
     /// Apply function to every item in the list.
     void Apply(void (*func)(Item));
 
@@ -54,6 +74,16 @@ private:
     // Wait in `Pop` if the list is empty.
     Condition *listEmpty;
 
+    // Wait in `Append` if the list is full.
+    Condition *listFull;
+
+    // Items in the list, and the most it may hold, or 0.
+    unsigned count;
+    unsigned capacity;
+
+    // Take the first item; the list must not be empty.
+    Item Take();
+
 };
 
 /// Allocate and initialize the data structures needed for a synchronized
@@ -61,12 +91,15 @@ private:
 ///
 /// Elements can now be added to the list.
 template <class Item>
-SynchList<Item>::SynchList()
+SynchList<Item>::SynchList(unsigned maxItems)
 {
     list      = new List<Item>;
     lock      = new Lock("list lock");
     listEmpty = new Condition("list empty cond", lock);
     // original // listEmpty = new Condition("list empty cond");
+    listFull  = new Condition("list full cond", lock);
+    count     = 0;
+    capacity  = maxItems;
 }
 
 /// De-allocate the data structures created for synchronizing a list.
@@ -76,6 +109,7 @@ SynchList<Item>::~SynchList()
     delete list;
     delete lock;
     delete listEmpty;
+    delete listFull;
 }
 
 /// Append an “item” to the end of the list.  Wake up anyone waiting for an
@@ -87,7 +121,11 @@ void
 SynchList<Item>::Append(Item item)
 {
     lock->Acquire();      // Enforce mutual exclusive access to the list.
+    while (capacity > 0 && count == capacity) {
+        listFull->Wait();  // Wait until there is room.
+    }
     list->Append(item);
+    count++;
     listEmpty->Signal();  // Wake up a waiter, if any.
     // original // listEmpty->Signal(lock);    // wake up a waiter, if any
     lock->Release();
@@ -108,12 +146,88 @@ SynchList<Item>::Pop()
         listEmpty->Wait();  // Wait until list is not empty.
     }
     // Original: //listEmpty->Wait(lock);  // Wait until list is not empty.
-    item = list->Pop();
+    item = Take();
     //ASSERT(item != nullptr);
     lock->Release();
     return item;
 }
 
+/// Remove an “item” from the beginning of the list, waiting for at most
+/// `ticks` ticks if the list is empty.
+///
+/// * `item` is where to store the removed item.
+template <class Item>
+bool
+SynchList<Item>::Pop(Item *item, unsigned long ticks)
+{
+    ASSERT(item != nullptr);
+
+    unsigned long deadline = stats->totalTicks + ticks;
+
+    lock->Acquire();
+    while (list->IsEmpty()) {
+        // Time may have gone by without an item for us, if someone else
+        // took it first.
+        if (stats->totalTicks >= deadline
+              || !listEmpty->Wait(deadline - stats->totalTicks)) {
+            if (list->IsEmpty()) {
+                lock->Release();
+                return false;
+            }
+        }
+    }
+    *item = Take();
+    lock->Release();
+    return true;
+}
+
+/// Remove up to `max` “items” from the beginning of the list.  Wait if the
+/// list is empty.
+///
+/// * `items` is where to store the removed items.
+template <class Item>
+unsigned
+SynchList<Item>::PopBatch(Item *items, unsigned max)
+{
+    ASSERT(items != nullptr);
+    ASSERT(max > 0);
+
+    lock->Acquire();
+    while (list->IsEmpty()) {
+        listEmpty->Wait();
+    }
+    unsigned n = 0;
+    while (n < max && !list->IsEmpty()) {
+        items[n++] = Take();
+    }
+    lock->Release();
+    return n;
+}
+
+template <class Item>
+unsigned
+SynchList<Item>::GetCount()
+{
+    lock->Acquire();
+    unsigned n = count;
+    lock->Release();
+    return n;
+}
+
+/// Remove the first item, and make room for an appending thread, if one is
+/// waiting.  The lock must be held.
+template <class Item>
+Item
+SynchList<Item>::Take()
+{
+    Item item = list->Pop();
+    count--;
+    if (capacity > 0) {
+        listFull->Signal();
+    }
+    return item;
+}
+
 /// Apply function to every item on the list.
 ///
 /// Obey mutual exclusion constraints.
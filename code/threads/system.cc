@@ -7,12 +7,14 @@
 
 
 #include "system.hh"
+#include "machine/interrupt_log.hh"
 
 #ifdef USER_PROGRAM
 #include "userprog/debugger.hh"
 #include "userprog/exception.hh"
 #endif
 
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -24,10 +26,14 @@
 Thread *currentThread;        ///< The thread we are running now.
 Thread *threadToBeDestroyed;  ///< The thread that just finished.
 Scheduler *scheduler;         ///< The ready list.
+Cpu *currentCpu;              ///< The CPU being simulated.
 Interrupt *interrupt;         ///< Interrupt status.
 Statistics *stats;            ///< Performance metrics.
 Timer *timer;                 ///< The hardware timer device, for invoking
                               ///< context switches.
+Alarm *alarms;                ///< Software alarms, driven by `timer`.
+ThreadPool *threadPool;       ///< Spare thread objects and stacks.
+LockProfiler *lockProfiler;   ///< Lock contention, if profiling.
 
 #ifdef FILESYS_NEEDED
 //#ifdef FILESYS_STUB
@@ -43,6 +49,7 @@ SynchDisk *synchDisk;
 Machine *machine;  ///< User program memory and registers.
 SynchConsole *synchConsole;
 Table <Thread*> *threadsTable;
+FutexTable *futexTable;
 
 #ifdef USE_SWAP
 Coremap *memCoreMap;
@@ -56,6 +63,15 @@ Bitmap *memBitMap;
 // External definition, to allow us to take a pointer to this function.
 extern void Cleanup();
 
+/// Whether timer interrupts may time-slice the normal threads.  The timer
+/// always runs, to drive `alarms` and the real-time class, but it only
+/// time-slices when asked to with `-rs` or when the scheduling policy
+/// relies on it.
+static bool preemptive;
+
+/// Whether the timer only runs when it has work to do (`-nohz`).
+static bool tickless;
+
 /// Interrupt handler for the timer device.
 ///
 /// The timer device is set up to interrupt the CPU periodically (once every
@@ -68,14 +84,49 @@ extern void Cleanup();
 /// done, it will appear as if the interrupted thread called Yield at the
 /// point it is was interrupted.
 ///
+/// Alarms that are due go off first, so that the threads they wake up are
+/// already competing for the CPU.
+///
 /// * `dummy` is because every interrupt handler takes one argument, whether
 ///   it needs it or not.
 static void
 TimerInterruptHandler(void *dummy)
 {
-    if (interrupt->GetStatus() != IDLE_MODE) {
+    alarms->Tick();
+    if (interrupt->GetStatus() != IDLE_MODE
+          && scheduler->TimerTick(preemptive)) {
         interrupt->YieldOnReturn();
     }
+    UpdateTimer();
+}
+
+/// In tickless mode, the timer interrupts every time slice only while
+/// there is some thread to switch to (or real-time threads to keep track
+/// of).  Otherwise it is set to interrupt once, when the next alarm is due,
+/// or stopped if there are none, so that an idle machine skips straight to
+/// the next device interrupt.
+///
+/// Called whenever a thread becomes ready or an alarm is set, and after
+/// every timer interrupt, with interrupts disabled.  Nothing else turns the
+/// timer off, so after the other threads block, a lone thread may still
+/// take one more interrupt.
+void
+UpdateTimer()
+{
+    if (!tickless || timer == nullptr) {
+        return;
+    }
+
+    unsigned long jiffy;
+    if (scheduler->NeedsTick(preemptive)) {
+        timer->Start();
+    } else if (alarms->GetNextJiffy(&jiffy)) {
+        unsigned long when = jiffy * TIMER_TICKS;
+        timer->StartOnce(when > stats->totalTicks
+                         ? when - stats->totalTicks : 1);
+    } else {
+        timer->Stop();
+    }
 }
 
 static bool
@@ -111,6 +162,61 @@ ParseDebugOpts(char *s, DebugOpts *out)
     return true;
 }
 
+/// Complain that `option`, given on the command line, does not match
+/// `settings`, read from the interrupt log being replayed, and exit.
+static void
+LogMismatch(const char *option, const LogSettings *settings)
+{
+    ASSERT(option != nullptr);
+    ASSERT(settings != nullptr);
+
+    fprintf(stderr, "Option %s does not match the interrupt log, recorded"
+            " with", option);
+    if (settings->randomYield) {
+        fprintf(stderr, " -rs %u", settings->seed);
+    }
+    if (settings->tickless) {
+        fprintf(stderr, " -nohz");
+    }
+    fprintf(stderr, " -sp %s -cpus %u.\n", settings->policy,
+            settings->numCpus);
+    exit(1);
+}
+
+/// When replaying an interrupt log, take the options kept in it from
+/// `settings`, unless they were given on the command line; then they must
+/// match.  `schedPolicy` is null and `numCpus` zero if not given.
+static void
+TakeLogSettings(const LogSettings *settings, bool *randomYield,
+                unsigned *seed, const char **schedPolicy, unsigned *numCpus)
+{
+    ASSERT(settings != nullptr);
+
+    if (*randomYield
+          && (!settings->randomYield || *seed != settings->seed)) {
+        LogMismatch("-rs", settings);
+    }
+    if (tickless && !settings->tickless) {
+        LogMismatch("-nohz", settings);
+    }
+    if (*schedPolicy != nullptr && strcmp(*schedPolicy, settings->policy)) {
+        LogMismatch("-sp", settings);
+    }
+    if (*numCpus != 0 && *numCpus != settings->numCpus) {
+        LogMismatch("-cpus", settings);
+    }
+    if (settings->numCpus < 1 || settings->numCpus > MAX_CPUS) {
+        fprintf(stderr, "The interrupt log is corrupt.\n");
+        exit(1);
+    }
+
+    *randomYield = settings->randomYield;
+    *seed        = settings->seed;
+    tickless     = settings->tickless;
+    *schedPolicy = settings->policy;
+    *numCpus     = settings->numCpus;
+}
+
 /// Initialize Nachos global data structures.
 ///
 /// Interpret command line arguments in order to determine flags for the
@@ -132,6 +238,13 @@ Initialize(int argc, char **argv)
     const char *debugFlags = "";
     DebugOpts debugOpts;
     bool randomYield = false;
+    unsigned seed = 0;
+    const char *schedPolicy = nullptr;  // Priority, unless given.
+    unsigned threadPoolSize = DEFAULT_THREAD_POOL_SIZE;
+    unsigned numCpus = 0;  // One, unless given.
+    bool profileLocks = false;
+    const char *logFile = nullptr;
+    bool replayLog = false;
 
 #ifdef USER_PROGRAM
     bool debugUserProg = false;  // Single step user program.
@@ -157,10 +270,31 @@ Initialize(int argc, char **argv)
             argCount = 2;
         } else if (!strcmp(*argv, "-rs")) {
             ASSERT(argc > 1);
-            SystemDep::RandomInit(atoi(*(argv + 1)));
-              // Initialize pseudo-random number generator.
+            seed = atoi(*(argv + 1));
             randomYield = true;
             argCount = 2;
+        } else if (!strcmp(*argv, "-sp")) {
+            ASSERT(argc > 1);
+            schedPolicy = *(argv + 1);
+            argCount = 2;
+        } else if (!strcmp(*argv, "-pool")) {
+            ASSERT(argc > 1);
+            threadPoolSize = atoi(*(argv + 1));
+            argCount = 2;
+        } else if (!strcmp(*argv, "-cpus")) {
+            ASSERT(argc > 1);
+            numCpus = atoi(*(argv + 1));
+            ASSERT(numCpus >= 1 && numCpus <= MAX_CPUS);
+            argCount = 2;
+        } else if (!strcmp(*argv, "-lp")) {
+            profileLocks = true;
+        } else if (!strcmp(*argv, "-nohz")) {
+            tickless = true;
+        } else if (!strcmp(*argv, "-record") || !strcmp(*argv, "-replay")) {
+            ASSERT(argc > 1);
+            replayLog = !strcmp(*argv, "-replay");
+            logFile = *(argv + 1);
+            argCount = 2;
         }
 #ifdef USER_PROGRAM
         if (!strcmp(*argv, "-s")) {
@@ -183,12 +317,45 @@ Initialize(int argc, char **argv)
     debug.SetFlags(debugFlags);  // Initialize `DEBUG` messages.
     debug.SetOpts(debugOpts);    // Set debugging behavior.
     stats = new Statistics;      // Collect statistics.
+    lockProfiler = profileLocks ? new LockProfiler : nullptr;
+      // Before any lock is created.
     interrupt = new Interrupt;   // Start up interrupt handling.
-    scheduler = new Scheduler;   // Initialize the ready queue.
-    if (randomYield) {           // Start the timer (if needed).
-        timer = new Timer(TimerInterruptHandler, 0, randomYield);
+    LogSettings settings;
+    if (logFile != nullptr && replayLog) {
+        // Before any device schedules interrupts.
+        interrupt->SetLog(new InterruptLog(logFile, true, &settings));
+        TakeLogSettings(&settings, &randomYield, &seed, &schedPolicy,
+                        &numCpus);
+    }
+    if (schedPolicy == nullptr) {
+        schedPolicy = "priority";
     }
+    if (numCpus == 0) {
+        numCpus = 1;
+    }
+    if (logFile != nullptr && !replayLog) {
+        settings.randomYield = randomYield;
+        settings.seed        = seed;
+        settings.tickless    = tickless;
+        settings.numCpus     = numCpus;
+        snprintf(settings.policy, sizeof settings.policy, "%s", schedPolicy);
+        interrupt->SetLog(new InterruptLog(logFile, false, &settings));
+    }
+    if (randomYield) {
+        SystemDep::RandomInit(seed);
+          // Initialize pseudo-random number generator.
+    }
+    SchedulingPolicy *policy = NewSchedulingPolicy(schedPolicy);
+    if (policy == nullptr) {
+        fprintf(stderr, "Unknown scheduling policy \"%s\".\n", schedPolicy);
+        exit(1);
+    }
+    scheduler = new Scheduler(policy);  // Initialize the ready queue.
+    preemptive = randomYield || scheduler->NeedsTimer();
+    alarms = new Alarm;
+    timer = new Timer(TimerInterruptHandler, 0, randomYield);
 
+    threadPool = new ThreadPool(threadPoolSize);
     threadToBeDestroyed = nullptr;
 
     // We did not explicitly allocate the current thread we are running in.
@@ -196,6 +363,12 @@ Initialize(int argc, char **argv)
     // object to save its state.
     currentThread = new Thread("main", 0, 9);
     currentThread->SetStatus(RUNNING);
+    currentCpu->current = currentThread;
+    for (unsigned i = 1; i < numCpus; i++) {
+        SchedulingPolicy *cpuPolicy = policy->IsShared()
+          ? policy : NewSchedulingPolicy(schedPolicy);
+        scheduler->AddCpu(cpuPolicy);
+    }
 
     interrupt->Enable();
     SystemDep::CallOnUserAbort(Cleanup);  // If user hits ctl-C...
@@ -203,10 +376,12 @@ Initialize(int argc, char **argv)
 #ifdef USER_PROGRAM
     Debugger *d = debugUserProg ? new Debugger : nullptr;
     
-    machine = new Machine(d, numPhysicalPages);  // This must come first.
+    machine = new Machine(d, numPhysicalPages, numCpus);  // This must come
+                                                          // first.
     SetExceptionHandlers();
 
     synchConsole = new SynchConsole(nullptr, nullptr);
+    futexTable = new FutexTable;
 
     //threadsTable->Add(currentThread);
 
@@ -237,6 +412,7 @@ Cleanup()
     delete machine;
     delete synchConsole;
     delete threadsTable;
+    delete futexTable;
     
     #ifdef USE_SWAP
     delete memCoreMap;
@@ -255,6 +431,7 @@ Cleanup()
 #endif
 
     delete timer;
+    delete alarms;
     delete scheduler;
     delete interrupt;
 
@@ -264,6 +441,8 @@ Cleanup()
     Thread *t = currentThread;
     currentThread = NULL;
     delete t; 
+    delete threadPool;
+    delete lockProfiler;
 
     exit(0);
 }
@@ -9,8 +9,11 @@
 #define NACHOS_THREADS_SYSTEM__HH
 
 
+#include "alarm.hh"
 #include "thread.hh"
 #include "scheduler.hh"
+#include "thread_pool.hh"
+#include "lock_profiler.hh"
 #include "lib/utility.hh"
 #include "lib/bitmap.hh"
 #include "lib/coremap.hh"
@@ -27,20 +30,29 @@ extern void Initialize(int argc, char **argv);
 // Cleanup, called when Nachos is done.
 extern void Cleanup();
 
+// Program the timer for the next time it has work to do, with `-nohz`.
+extern void UpdateTimer();
+
 
 extern Thread *currentThread;        ///< The thread holding the CPU.
 extern Thread *threadToBeDestroyed;  ///< The thread that just finished.
 extern Scheduler *scheduler;         ///< The ready list.
+extern Cpu *currentCpu;              ///< The CPU being simulated.
 extern Interrupt *interrupt;         ///< Interrupt status.
 extern Statistics *stats;            ///< Performance metrics.
 extern Timer *timer;                 ///< The hardware alarm clock.
+extern Alarm *alarms;                ///< Software alarms.
+extern ThreadPool *threadPool;       ///< Spare threads and stacks.
+extern LockProfiler *lockProfiler;   ///< Lock contention, if profiling.
 
 #ifdef USER_PROGRAM
 #include "machine/machine.hh"
 #include "machine/synch_console.hh"
+#include "userprog/futex_table.hh"
 extern Machine *machine;  // User program memory and registers.
 extern SynchConsole *synchConsole;
 extern Table <Thread*> *threadsTable;
+extern FutexTable *futexTable;  // Threads blocked in `FutexWait`.
 
 #ifdef USE_SWAP
 extern Coremap *memCoreMap;
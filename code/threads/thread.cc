@@ -21,6 +21,9 @@
 #include "switch.h"
 #include "system.hh"
 #include "channel.hh"
+#include "cpu.hh"
+#include "lock.hh"
+#include "ready_queue.hh"
 
 #include <inttypes.h>
 #include <stdio.h>
@@ -50,9 +53,28 @@ Thread::Thread(const char *threadName, int join)
     status   = JUST_CREATED;
     allowJoin = join;
     if (allowJoin)
-        channel = new Channel(threadName);
+        channel = new Channel(threadName, 1);
     priority = 4;
     oldPriority = priority;
+    readyQueue = nullptr;
+    readyNext = readyPrev = nullptr;
+    readyLevel = 0;
+    dispatchTick = 0;
+    cpu = nullptr;
+    quantumUsed = 0;
+    boostEpoch = 0;
+    tickets = DEFAULT_TICKETS;
+    pass = 0;
+    rejoining = true;
+    heldLocks = nullptr;
+    waitingOn = nullptr;
+    nextWaiter = nullptr;
+    rtPeriod = rtBudget = rtDeadline = rtRemaining = 0;
+    rtThrottled = false;
+    rtNext = nullptr;
+    rtJobs = rtMisses = 0;
+    accounting.since = stats->totalTicks;
+    Register();
 
 #ifdef USER_PROGRAM
     space    = nullptr;
@@ -76,9 +98,28 @@ Thread::Thread(const char *threadName, int join, const unsigned int threadPriori
     status   = JUST_CREATED;
     allowJoin = join;
     if (allowJoin)
-        channel = new Channel(threadName);
+        channel = new Channel(threadName, 1);
     priority = threadPriority;
     oldPriority = priority;
+    readyQueue = nullptr;
+    readyNext = readyPrev = nullptr;
+    readyLevel = 0;
+    dispatchTick = 0;
+    cpu = nullptr;
+    quantumUsed = 0;
+    boostEpoch = 0;
+    tickets = DEFAULT_TICKETS;
+    pass = 0;
+    rejoining = true;
+    heldLocks = nullptr;
+    waitingOn = nullptr;
+    nextWaiter = nullptr;
+    rtPeriod = rtBudget = rtDeadline = rtRemaining = 0;
+    rtThrottled = false;
+    rtNext = nullptr;
+    rtJobs = rtMisses = 0;
+    accounting.since = stats->totalTicks;
+    Register();
 
 #ifdef USER_PROGRAM
     space    = nullptr;
@@ -105,12 +146,13 @@ Thread::~Thread()
 {
     ASSERT(this != currentThread);
 
+    Unregister();
+
     if (allowJoin)
         delete channel;
         
     if (stack != nullptr) {
-        SystemDep::DeallocBoundedArray((char *) stack,
-                                       STACK_SIZE * sizeof *stack);
+        threadPool->FreeStack(stack);
     }
 #ifdef USER_PROGRAM
     // destruir tabla de openfiles.
@@ -127,6 +169,51 @@ Thread::~Thread()
 #endif
 }
 
+/// Every thread alive, most recent first.
+static Thread *allThreads = nullptr;
+
+/// Totals of the threads that have been destroyed.
+static ThreadStats goneStats;
+static unsigned long goneCount = 0;
+
+void
+Thread::Register()
+{
+    allPrev = nullptr;
+    allNext = allThreads;
+    if (allThreads != nullptr) {
+        allThreads->allPrev = this;
+    }
+    allThreads = this;
+}
+
+void
+Thread::Unregister()
+{
+    if (allPrev == nullptr) {
+        allThreads = allNext;
+    } else {
+        allPrev->allNext = allNext;
+    }
+    if (allNext != nullptr) {
+        allNext->allPrev = allPrev;
+    }
+    goneStats.Add(&accounting);
+    goneCount++;
+}
+
+void *
+Thread::operator new(size_t size)
+{
+    return threadPool->AllocateThread(size);
+}
+
+void
+Thread::operator delete(void *thread)
+{
+    threadPool->FreeThread(thread);
+}
+
 /// Invoke `(*func)(arg)`, allowing caller and callee to execute
 /// concurrently.
 ///
@@ -159,29 +246,30 @@ Thread::Fork(VoidFunctionPtr func, void *arg)
     interrupt->SetLevel(oldLevel);
 }
 
-void 
-Thread::Join() 
+/// Block until the thread finishes, then reclaim it.
+///
+/// A joinable thread leaves its exit status in its own channel, which has
+/// room for it, so it never waits for its joiner; it is only destroyed here,
+/// once joined.  `this` must not be used after `Join` returns.
+void
+Thread::Join()
 {
-    ASSERT(this != currentThread);
-    ASSERT(allowJoin);
-
-    DEBUG('t', "Joining thread \"%s\".\n", name);
-
-    int* buffer = new int;
-    channel->Receive(buffer);
-    DEBUG('t', "Thread joined \"%s\".\n", name);
+    int exitStatus;
+    Join(&exitStatus);
 }
 
-void 
-Thread::Join(int* statusOut) 
+void
+Thread::Join(int *statusOut)
 {
     ASSERT(this != currentThread);
     ASSERT(allowJoin);
+    ASSERT(statusOut != nullptr);
 
     DEBUG('t', "Joining thread \"%s\".\n", name);
 
     channel->Receive(statusOut);
     DEBUG('t', "Thread \"%s\" joined with status \"%d\".\n", name, *statusOut);
+    delete this;
 }
 
 /// Check a thread's stack to see if it has overrun the space that has been
@@ -241,11 +329,115 @@ Thread::InheritPriority(int newPriority)
     priority = newPriority;
 }
 
+int
+Thread::InheritedPriority() const
+{
+    int inherited = -1;
+    for (Lock *lock = heldLocks; lock != nullptr; lock = lock->nextHeld) {
+        for (Thread *t = lock->waiters; t != nullptr; t = t->nextWaiter) {
+            if (t->priority > inherited) {
+                inherited = t->priority;
+            }
+        }
+    }
+    return inherited;
+}
+
+bool
+Thread::UpdatePriority()
+{
+    int inherited = InheritedPriority();
+    int newPriority = inherited > oldPriority ? inherited : oldPriority;
+    if (newPriority == priority) {
+        return false;
+    }
+    priority = newPriority;
+    return true;
+}
+
 void
-Thread::RestorePriority()
+Thread::SetPriority(int newPriority)
 {
-    if (priority != oldPriority)
-        priority = oldPriority;
+    ASSERT(newPriority >= 0 && (unsigned) newPriority < NUM_QUEUES);
+
+    oldPriority = newPriority;
+    UpdatePriority();
+}
+
+unsigned
+Thread::GetTickets() const
+{
+    return tickets;
+}
+
+void
+Thread::SetTickets(unsigned newTickets)
+{
+    ASSERT(newTickets > 0 && newTickets <= MAX_TICKETS);
+    tickets = newTickets;
+}
+
+unsigned long
+Thread::GetCpuTicks() const
+{
+    if (status == RUNNING) {
+        return accounting.runningTicks + stats->totalTicks - dispatchTick;
+    }
+    return accounting.runningTicks;
+}
+
+void
+Thread::GetStats(ThreadStats *out) const
+{
+    ASSERT(out != nullptr);
+
+    *out = accounting;
+    out->runningTicks = GetCpuTicks();
+    unsigned long now = stats->totalTicks;
+    if (status == READY) {
+        out->readyTicks += now - accounting.since;
+    } else if (status == BLOCKED) {
+        out->blockedTicks += now - accounting.since;
+    }
+}
+
+bool
+Thread::IsRealTime() const
+{
+    return rtPeriod != 0;
+}
+
+unsigned long
+Thread::GetRealTimeJobs() const
+{
+    return rtJobs;
+}
+
+unsigned long
+Thread::GetDeadlineMisses() const
+{
+    return rtMisses;
+}
+
+/// Idle threads are left out, as their time is not spent on anything.
+void
+Thread::PrintAllStats()
+{
+    char what[64];
+    printf("Thread scheduling statistics:\n");
+    for (Thread *t = allThreads; t != nullptr; t = t->allNext) {
+        if (t->cpu != nullptr && t == t->cpu->idleThread) {
+            continue;
+        }
+        ThreadStats st;
+        t->GetStats(&st);
+        snprintf(what, sizeof what, "Thread \"%s\"", t->GetName());
+        st.Print(what);
+    }
+    if (goneCount > 0) {
+        snprintf(what, sizeof what, "Finished threads (%lu)", goneCount);
+        goneStats.Print(what);
+    }
 }
 
 
@@ -256,7 +448,8 @@ Thread::RestorePriority()
 /// execution stack, because we are still running in the thread and we are
 /// still on the stack!  Instead, we set `threadToBeDestroyed`, so that
 /// `Scheduler::Run` will call the destructor, once we are running in the
-/// context of a different thread.
+/// context of a different thread.  A joinable thread is destroyed by
+/// `Join` instead, which cannot return before we are off the CPU.
 ///
 /// NOTE: we disable interrupts, so that we do not get a time slice between
 /// setting `threadToBeDestroyed`, and going to sleep.
@@ -268,10 +461,15 @@ Thread::Finish()
 
     DEBUG('t', "Finishing thread \"%s\"\n", GetName());
 
-    if (allowJoin)
-        channel->Send(1); // Father returned from Join
-    
-    threadToBeDestroyed = currentThread;
+    if (IsRealTime()) {
+        scheduler->SetRealTime(this, 0, 0);  // Give back its utilization.
+    }
+
+    if (allowJoin) {
+        channel->Send(1);  // The joiner destroys the thread.
+    } else {
+        threadToBeDestroyed = currentThread;
+    }
     #ifdef USER_PROGRAM
     if (threadsTable->Count() == 1) 
         interrupt->Halt();    
@@ -288,10 +486,15 @@ Thread::Finish(int st)
 
     DEBUG('t', "Finishing thread \"%s\" with status %d\n", GetName(), st);
 
-    if (allowJoin)
-        channel->Send(st); // Father returned from Join
-    
-    threadToBeDestroyed = currentThread;
+    if (IsRealTime()) {
+        scheduler->SetRealTime(this, 0, 0);  // Give back its utilization.
+    }
+
+    if (allowJoin) {
+        channel->Send(st);  // The joiner destroys the thread.
+    } else {
+        threadToBeDestroyed = currentThread;
+    }
     #ifdef USER_PROGRAM
     if (threadsTable->Count() == 1) 
         interrupt->Halt();    
@@ -333,6 +536,16 @@ Thread::Yield()
     interrupt->SetLevel(oldLevel);
 }
 
+void
+Thread::Preempt()
+{
+    accounting.preempted = true;
+    if (!scheduler->Throttle(this)) {
+        Yield();
+    }
+    accounting.preempted = false;  // In case there was no one to yield to.
+}
+
 /// Relinquish the CPU, because the current thread is blocked waiting on a
 /// synchronization variable (`Semaphore`, `Lock`, or `Condition`).
 /// Eventually, some thread will wake this thread up, and put it back on the
@@ -357,13 +570,51 @@ Thread::Sleep()
 
     Thread *nextThread;
     status = BLOCKED;
+    scheduler->Charge(this);  // Before idling, which is not CPU time.
     while ((nextThread = scheduler->FindNextToRun()) == nullptr) {
+        nextThread = scheduler->GetIdleThread();
+        if (nextThread != nullptr) {
+            break;  // On a multiprocessor, the idle thread takes over.
+        }
         interrupt->Idle();  // No one to run, wait for an interrupt.
     }
 
     scheduler->Run(nextThread);  // Returns when we have been signalled.
 }
 
+/// Alarm handler that makes a thread sleeping in `SleepFor` ready again.
+static void
+WakeUp(void *thread)
+{
+    scheduler->ReadyToRun((Thread *) thread);
+}
+
+/// Relinquish the CPU until `ticks` ticks have gone by.
+///
+/// The alarm lives on this thread's own stack, which stays put while it
+/// sleeps.  The delay is rounded up to the next timer interrupt (see
+/// `alarm.hh`).  A delay of 0 is just a `Yield`.
+void
+Thread::SleepFor(unsigned long ticks)
+{
+    ASSERT(this == currentThread);
+
+    if (ticks == 0) {
+        Yield();
+        return;
+    }
+
+    IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
+
+    DEBUG('t', "Thread \"%s\" sleeping for %lu ticks\n", GetName(), ticks);
+
+    AlarmEntry entry(WakeUp, this);
+    alarms->Set(&entry, ticks);
+    Sleep();
+
+    interrupt->SetLevel(oldLevel);
+}
+
 /// ThreadFinish, InterruptEnable
 ///
 /// Dummy functions because C++ does not allow a pointer to a member
@@ -396,8 +647,7 @@ Thread::StackAllocate(VoidFunctionPtr func, void *arg)
 {
     ASSERT(func != nullptr);
 
-    stack = (uintptr_t *)
-              SystemDep::AllocBoundedArray(STACK_SIZE * sizeof *stack);
+    stack = threadPool->AllocateStack();
 
     // Stacks in x86 work from high addresses to low addresses.
     stackTop = stack + STACK_SIZE - 4;  // -4 to be on the safe side!
@@ -39,6 +39,7 @@
 #define NACHOS_THREADS_THREAD__HH
 
 
+#include "thread_stats.hh"
 #include "lib/utility.hh"
 
 #ifdef USER_PROGRAM
@@ -52,6 +53,9 @@
 #include <stdint.h>
 
 class Channel;
+class Lock;
+class ReadyQueue;
+class Cpu;
 
 /// CPU register state to be saved on context switch.
 ///
@@ -66,6 +70,11 @@ const unsigned MACHINE_STATE_SIZE = 17;
 /// WATCH OUT IF THIS IS NOT BIG ENOUGH!!!!!
 const unsigned STACK_SIZE = 4 * 1024;
 
+/// Tickets held by a thread unless changed with `Thread::SetTickets`, and
+/// the most it may hold.
+const unsigned DEFAULT_TICKETS = 100;
+const unsigned MAX_TICKETS = 10000;
+
 
 /// Thread state.
 enum ThreadStatus {
@@ -111,12 +120,17 @@ public:
     /// called.
     ~Thread();
 
+    /// Thread control blocks are recycled through `threadPool`.
+    static void *operator new(size_t size);
+
+    static void operator delete(void *thread);
+
     /// Basic thread operations.
 
     /// Make thread run `(*func)(arg)`.
     void Fork(VoidFunctionPtr func, void *arg);
     
-    // Current thread blocks until thread finishes
+    // Current thread blocks until thread finishes, and then destroys it.
     void Join();
 
     void Join(int* statusOut);
@@ -124,9 +138,17 @@ public:
     /// Relinquish the CPU if any other thread is runnable.
     void Yield();
 
+    /// Same as `Yield`, but on behalf of the timer: the switch is accounted
+    /// as involuntary.  A real-time thread out of budget sleeps until its
+    /// next period instead.
+    void Preempt();
+
     /// Put the thread to sleep and relinquish the processor.
     void Sleep();
 
+    /// Block for (at least) `ticks` ticks, without using the CPU.
+    void SleepFor(unsigned long ticks);
+
     /// The thread is done executing.
     void Finish();
 
@@ -147,7 +169,41 @@ public:
 
     void InheritPriority(int newPriority);
 
-    void RestorePriority();
+    /// Recompute the effective priority after the set of locks held, or of
+    /// their waiters, has changed: the base priority, raised to that of the
+    /// most urgent thread waiting on any of the locks held.
+    ///
+    /// Returns whether it changed.
+    bool UpdatePriority();
+
+    /// Change the base priority of the thread.  An inherited priority, if
+    /// higher, stays in effect until it is restored.
+    void SetPriority(int newPriority);
+
+    /// Tickets held, for the proportional share scheduling policies.
+    unsigned GetTickets() const;
+
+    void SetTickets(unsigned newTickets);
+
+    /// CPU time used by the thread so far, in ticks.
+    unsigned long GetCpuTicks() const;
+
+    /// Scheduling statistics so far, including the time in the current
+    /// state.
+    void GetStats(ThreadStats *out) const;
+
+    /// Print the scheduling statistics of every thread alive, and the
+    /// totals of those that are gone.
+    static void PrintAllStats();
+
+    /// Is the thread in the real-time scheduling class?  See
+    /// `Scheduler::SetRealTime`.
+    bool IsRealTime() const;
+
+    /// Real-time jobs released so far, and how many missed their deadline.
+    unsigned long GetRealTimeJobs() const;
+
+    unsigned long GetDeadlineMisses() const;
 
 private:
     // Some of the private data for this class is listed above.
@@ -164,11 +220,84 @@ private:
 
     int allowJoin;
 
+    /// Holds the exit status of a joinable thread until it is joined.
     Channel *channel;
 
     int priority;
     int oldPriority;
 
+    /// Intrusive links for the scheduler's ready queue.  Only `ReadyQueue`
+    /// touches these; `readyQueue` is null while the thread is not in one.
+    ReadyQueue *readyQueue;
+    Thread *readyNext;
+    Thread *readyPrev;
+    unsigned readyLevel;
+
+    friend class ReadyQueue;
+
+    /// Tick at which the thread was last dispatched or charged.
+    unsigned long dispatchTick;
+
+    /// Scheduling statistics, kept by the scheduler.  The CPU time used so
+    /// far is `accounting.runningTicks`.
+    ThreadStats accounting;
+
+    /// Links in the list of every thread alive, for `PrintAllStats`.
+    Thread *allNext;
+    Thread *allPrev;
+
+    void Register();
+    void Unregister();
+
+    /// CPU the thread is running on, is queued on, or last ran on.
+    Cpu *cpu;
+
+    friend class Scheduler;
+
+    /// MLFQ bookkeeping: ticks of the current quantum already used, and the
+    /// last priority boost seen.
+    unsigned long quantumUsed;
+    unsigned boostEpoch;
+
+    friend class MlfqPolicy;
+
+    /// Share of the CPU, for the proportional share policies, and virtual
+    /// time for the stride policy (the lottery keeps it too, to compensate
+    /// threads that fell behind).  `rejoining` tells the lottery that the
+    /// thread is new or has blocked, so it has no lag to claim.
+    unsigned tickets;
+    unsigned long long pass;
+    bool rejoining;
+
+    friend class StridePolicy;
+    friend class LotteryPolicy;
+
+    /// Real-time parameters, zero unless in the real-time class, and the
+    /// state of the current job: its deadline and the budget left.
+    /// `rtThrottled` is set while sleeping off an overrun.
+    unsigned long rtPeriod;
+    unsigned long rtBudget;
+    unsigned long rtDeadline;
+    unsigned long rtRemaining;
+    bool rtThrottled;
+    Thread *rtNext;
+    unsigned long rtJobs;
+    unsigned long rtMisses;
+
+    friend class EdfPolicy;
+
+    /// Priority inheritance bookkeeping: the locks held, linked through
+    /// `Lock::nextHeld`, and the lock the thread is waiting for, if any,
+    /// with the next thread waiting for the same lock.
+    Lock *heldLocks;
+    Lock *waitingOn;
+    Thread *nextWaiter;
+
+    friend class Lock;
+
+    /// Highest priority among the waiters of the locks held, or -1.
+    int InheritedPriority() const;
+
     /// Allocate a stack for thread.  Used internally by `Fork`.
     void StackAllocate(VoidFunctionPtr func, void *arg);
 
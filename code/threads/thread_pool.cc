@@ -0,0 +1,98 @@
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "thread_pool.hh"
+#include "thread.hh"
+#include "machine/system_dep.hh"
+
+#include <new>
+#include <stdio.h>
+
+
+ThreadPool::ThreadPool(unsigned highWaterMark)
+{
+    highWater  = highWaterMark;
+    threads    = new void *[highWater + 1];  // `+ 1` so that a mark of 0 is
+                                             // not a zero-sized array.
+    stacks     = new uintptr_t *[highWater + 1];
+    numThreads = 0;
+    numStacks  = 0;
+
+    threadsReused = threadsAllocated = 0;
+    stacksReused  = stacksAllocated  = 0;
+}
+
+ThreadPool::~ThreadPool()
+{
+    for (unsigned i = 0; i < numThreads; i++) {
+        ::operator delete(threads[i]);
+    }
+    for (unsigned i = 0; i < numStacks; i++) {
+        SystemDep::DeallocBoundedArray((char *) stacks[i],
+                                       STACK_SIZE * sizeof *stacks[i]);
+    }
+    delete [] threads;
+    delete [] stacks;
+}
+
+void *
+ThreadPool::AllocateThread(size_t size)
+{
+    ASSERT(size == sizeof (Thread));
+
+    threadsAllocated++;
+    if (numThreads > 0) {
+        threadsReused++;
+        return threads[--numThreads];
+    }
+    return ::operator new(size);
+}
+
+void
+ThreadPool::FreeThread(void *thread)
+{
+    if (thread == nullptr) {
+        return;
+    }
+
+    if (numThreads < highWater) {
+        threads[numThreads++] = thread;
+    } else {
+        ::operator delete(thread);
+    }
+}
+
+uintptr_t *
+ThreadPool::AllocateStack()
+{
+    stacksAllocated++;
+    if (numStacks > 0) {
+        stacksReused++;
+        return stacks[--numStacks];
+    }
+    return (uintptr_t *) SystemDep::AllocBoundedArray(STACK_SIZE
+                                                      * sizeof (uintptr_t));
+}
+
+void
+ThreadPool::FreeStack(uintptr_t *stack)
+{
+    ASSERT(stack != nullptr);
+
+    if (numStacks < highWater) {
+        stacks[numStacks++] = stack;
+    } else {
+        SystemDep::DeallocBoundedArray((char *) stack,
+                                       STACK_SIZE * sizeof *stack);
+    }
+}
+
+void
+ThreadPool::Print() const
+{
+    printf("Thread pool (high-water mark %u): threads %lu/%lu reused, "
+           "stacks %lu/%lu reused.\n", highWater,
+           threadsReused, threadsAllocated, stacksReused, stacksAllocated);
+}
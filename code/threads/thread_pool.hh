@@ -0,0 +1,75 @@
+/// Recycling pool for thread control blocks and their stacks.
+///
+/// Creating a thread costs an allocation for the `Thread` object and a much
+/// larger one for its stack, which comes with guard pages around it (see
+/// `SystemDep::AllocBoundedArray`); destroying it costs the same again.
+/// Workloads that fork and finish many short-lived threads (for instance,
+/// user programs doing `Exec` and `Exit` in a loop) pay that on every
+/// spawn.
+///
+/// Instead, `Thread` objects and stacks that are released are kept here,
+/// up to a high-water mark of each, and handed out again on the next
+/// allocation.  Stacks keep their guard pages while pooled.  The mark is
+/// set with the `-pool` flag; 0 disables recycling.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_THREADS_THREADPOOL__HH
+#define NACHOS_THREADS_THREADPOOL__HH
+
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+/// Default number of spare thread objects and stacks kept.
+const unsigned DEFAULT_THREAD_POOL_SIZE = 32;
+
+class ThreadPool {
+public:
+
+    /// Keep at most `highWaterMark` spare threads, and as many stacks.
+    ThreadPool(unsigned highWaterMark);
+
+    /// Free every spare thread and stack.
+    ~ThreadPool();
+
+    /// Memory for a `Thread` object of `size` bytes.
+    void *AllocateThread(size_t size);
+
+    /// Give back the memory of a destroyed `Thread`.
+    void FreeThread(void *thread);
+
+    /// A stack of `STACK_SIZE` words, with guard pages around it.
+    uintptr_t *AllocateStack();
+
+    /// Give back the stack of a thread that is being destroyed.
+    void FreeStack(uintptr_t *stack);
+
+    /// Print how many allocations were served from the pool.
+    void Print() const;
+
+    /// Number of allocations served from the pool, and the total, of
+    /// threads and of stacks.
+    unsigned long threadsReused;
+    unsigned long threadsAllocated;
+    unsigned long stacksReused;
+    unsigned long stacksAllocated;
+
+private:
+
+    unsigned highWater;
+
+    /// Spare thread objects and stacks; only the first `numThreads` and
+    /// `numStacks` entries are valid.
+    void **threads;
+    unsigned numThreads;
+    uintptr_t **stacks;
+    unsigned numStacks;
+
+};
+
+
+#endif
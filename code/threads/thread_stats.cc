@@ -0,0 +1,104 @@
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "thread_stats.hh"
+
+#include <stdio.h>
+
+
+ThreadStats::ThreadStats()
+{
+    runningTicks = readyTicks = blockedTicks = 0;
+    voluntarySwitches = involuntarySwitches = 0;
+    for (unsigned i = 0; i < READY_WAIT_BUCKETS; i++) {
+        readyWaits[i] = 0;
+    }
+    since = 0;
+    preempted = false;
+}
+
+/// The thread was running and has been put back in the ready queue.
+void
+ThreadStats::Yielded(unsigned long now)
+{
+    if (preempted) {
+        involuntarySwitches++;
+        preempted = false;
+    } else {
+        voluntarySwitches++;
+    }
+    since = now;
+}
+
+/// The thread was running and is now waiting for some event.
+void
+ThreadStats::Blocked(unsigned long now)
+{
+    if (preempted) {
+        involuntarySwitches++;  // Throttled by the real-time class.
+    } else {
+        voluntarySwitches++;
+    }
+    since = now;
+}
+
+/// The thread was blocked and is now ready.
+void
+ThreadStats::WokenUp(unsigned long now)
+{
+    blockedTicks += now - since;
+    since = now;
+}
+
+/// The thread was ready and now runs.
+void
+ThreadStats::Dispatched(unsigned long now)
+{
+    unsigned long wait = now - since;
+    readyTicks += wait;
+
+    unsigned bucket = 0;
+    while (bucket < READY_WAIT_BUCKETS - 1
+             && wait >= READY_WAIT_BASE << bucket) {
+        bucket++;
+    }
+    readyWaits[bucket]++;
+}
+
+void
+ThreadStats::Add(const ThreadStats *other)
+{
+    runningTicks        += other->runningTicks;
+    readyTicks          += other->readyTicks;
+    blockedTicks        += other->blockedTicks;
+    voluntarySwitches   += other->voluntarySwitches;
+    involuntarySwitches += other->involuntarySwitches;
+    for (unsigned i = 0; i < READY_WAIT_BUCKETS; i++) {
+        readyWaits[i] += other->readyWaits[i];
+    }
+}
+
+/// Only the non-empty buckets of the histogram are printed, labelled with
+/// their upper bound.
+void
+ThreadStats::Print(const char *what) const
+{
+    printf("%s: running %lu, ready %lu, blocked %lu ticks; "
+           "switches: voluntary %lu, involuntary %lu\n",
+           what, runningTicks, readyTicks, blockedTicks,
+           voluntarySwitches, involuntarySwitches);
+    printf("    ready waits:");
+    for (unsigned i = 0; i < READY_WAIT_BUCKETS; i++) {
+        if (readyWaits[i] == 0) {
+            continue;
+        }
+        if (i < READY_WAIT_BUCKETS - 1) {
+            printf(" <%lu: %lu", READY_WAIT_BASE << i, readyWaits[i]);
+        } else {
+            printf(" >=%lu: %lu", READY_WAIT_BASE << (i - 1), readyWaits[i]);
+        }
+    }
+    printf("\n");
+}
@@ -0,0 +1,69 @@
+/// Scheduling statistics kept for every thread.
+///
+/// Time is split between running, ready (waiting in a ready queue) and
+/// blocked (waiting for some event).  Each time a thread leaves the CPU, the
+/// switch is counted as voluntary (it yielded or blocked) or involuntary
+/// (the timer preempted it), and each time it is dispatched, the time it
+/// waited in the ready queue goes into a histogram.
+///
+/// The scheduler updates these as threads change state; they are printed at
+/// halt, and user programs can read theirs with the `GetSchedStats` system
+/// call.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_THREADS_THREADSTATS__HH
+#define NACHOS_THREADS_THREADSTATS__HH
+
+
+/// Bucket `i` of the ready wait histogram counts the waits shorter than
+/// `READY_WAIT_BASE << i` ticks that do not fit in a previous bucket.  The
+/// last bucket counts all longer waits.  User programs see the same
+/// histogram, so this must match `SCHED_WAIT_BUCKETS` in `syscall.h`.
+const unsigned READY_WAIT_BUCKETS = 12;
+const unsigned long READY_WAIT_BASE = 10;
+
+/// The fields in this class are public to make it easier to update.
+class ThreadStats {
+public:
+
+    /// Time spent in each state, in ticks.
+    unsigned long runningTicks;
+    unsigned long readyTicks;
+    unsigned long blockedTicks;
+
+    /// Times the thread gave up the CPU, by itself or not.
+    unsigned long voluntarySwitches;
+    unsigned long involuntarySwitches;
+
+    /// Histogram of the time spent in the ready queue before every
+    /// dispatch.
+    unsigned long readyWaits[READY_WAIT_BUCKETS];
+
+    /// Tick at which the thread entered its current state, if it is ready
+    /// or blocked.
+    unsigned long since;
+
+    /// Whether the thread is giving up the CPU because it was preempted.
+    bool preempted;
+
+    /// Initialize everything to zero.
+    ThreadStats();
+
+    /// State changes, at time `now`.
+    void Yielded(unsigned long now);
+    void Blocked(unsigned long now);
+    void WokenUp(unsigned long now);
+    void Dispatched(unsigned long now);
+
+    /// Add the counts of `other` to these.
+    void Add(const ThreadStats *other);
+
+    /// Print the statistics, as those of `what`.
+    void Print(const char *what) const;
+};
+
+
+#endif
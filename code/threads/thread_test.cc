@@ -16,6 +16,19 @@
 #include "thread_test_simple.hh"
 #include "thread_test_garden_sem.hh"
 #include "thread_test_channels.hh"
+#include "thread_test_storm.hh"
+#include "thread_test_shares.hh"
+#include "thread_test_spawn.hh"
+#include "thread_test_alarm.hh"
+#include "thread_test_inversion.hh"
+#include "thread_test_edf.hh"
+#include "thread_test_handoff.hh"
+#include "thread_test_rwlock.hh"
+#include "thread_test_pipe.hh"
+#include "thread_test_queue.hh"
+#include "thread_test_herd.hh"
+#include "thread_test_lockprof.hh"
+#include "thread_test_interrupts.hh"
 
 #include "lib/utility.hh"
 
@@ -35,7 +48,20 @@ static const Test TESTS[] = {
     { &ThreadTestGarden,   "garden",   "Ornamental garden" },
     { &ThreadTestProdCons, "prodcons", "Producer/Consumer" },
     { &ThreadTestGardenSem, "gardensem", "Ornamental garden with semaphores"},
-    { &ThreadTestChannels, "channels", "Receive and send messages"}
+    { &ThreadTestChannels, "channels", "Receive and send messages"},
+    { &ThreadTestStorm,    "storm",    "Dispatcher thread storm benchmark"},
+    { &ThreadTestShares,   "shares",   "Proportional share benchmark"},
+    { &ThreadTestSpawn,    "spawn",    "Fork/exit storm benchmark"},
+    { &ThreadTestAlarm,    "alarm",    "Timed sleep on the alarm wheel"},
+    { &ThreadTestInversion, "inversion", "Nested priority inversion benchmark"},
+    { &ThreadTestEdf,      "edf",      "Real-time threads against CPU hogs"},
+    { &ThreadTestHandoff,  "handoff",  "Lock convoy benchmark"},
+    { &ThreadTestRWLock,   "rwlock",   "Reader-writer locks"},
+    { &ThreadTestPipe,     "pipe",     "Channel throughput benchmark"},
+    { &ThreadTestQueue,    "queue",    "Bounded work queue"},
+    { &ThreadTestHerd,     "herd",     "Condition broadcast benchmark"},
+    { &ThreadTestLockProf, "lockprof", "Lock contention profile"},
+    { &ThreadTestInterrupts, "interrupts", "Pending interrupt benchmark"}
 };
 static const unsigned NUM_TESTS = sizeof TESTS / sizeof TESTS[0];
 
@@ -0,0 +1,67 @@
+/// Timed sleep: threads sleep for delays that land on every level of the
+/// alarm timer wheel, and check that they do not wake up early.  They are
+/// also expected not to be charged CPU time while asleep.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "thread_test_alarm.hh"
+#include "system.hh"
+
+#include <stdio.h>
+
+
+static const unsigned ALARM_THREADS = 6;
+static const unsigned long ALARM_DELAYS[ALARM_THREADS] = {
+    50, 300, 1000, 7000, 30000, 500000
+};
+static const unsigned ALARM_ROUNDS = 3;
+
+static unsigned long lateness[ALARM_THREADS];
+static unsigned long cpuTicks[ALARM_THREADS];
+
+static void
+AlarmThread(void *arg)
+{
+    unsigned *n = (unsigned *) arg;
+    unsigned long delay = ALARM_DELAYS[*n];
+
+    for (unsigned i = 0; i < ALARM_ROUNDS; i++) {
+        unsigned long start = stats->totalTicks;
+        currentThread->SleepFor(delay);
+        unsigned long slept = stats->totalTicks - start;
+        ASSERT(slept >= delay);
+        lateness[*n] += slept - delay;
+    }
+    cpuTicks[*n] = currentThread->GetCpuTicks();
+}
+
+void
+ThreadTestAlarm()
+{
+    Thread *threads[ALARM_THREADS];
+    unsigned ids[ALARM_THREADS];
+    char names[ALARM_THREADS][16];
+
+    unsigned long start = stats->totalTicks;
+    for (unsigned i = 0; i < ALARM_THREADS; i++) {
+        ids[i] = i;
+        sprintf(names[i], "sleeper %u", i);
+        threads[i] = new Thread(names[i], 1);
+        threads[i]->Fork(AlarmThread, &ids[i]);
+    }
+    for (unsigned i = 0; i < ALARM_THREADS; i++) {
+        threads[i]->Join();
+    }
+
+    for (unsigned i = 0; i < ALARM_THREADS; i++) {
+        printf("Sleeper %u: %u sleeps of %lu ticks, %lu ticks late on "
+               "average, %lu CPU ticks used.\n",
+               i, ALARM_ROUNDS, ALARM_DELAYS[i], lateness[i] / ALARM_ROUNDS,
+               cpuTicks[i]);
+    }
+    printf("Elapsed: %lu ticks, of which %lu idle.\n",
+           stats->totalTicks - start, stats->idleTicks);
+}
@@ -4,6 +4,7 @@
 int NUM_MSGS = 10;
 int NUM_RECEPTOR = 5;
 int NUM_EMISOR = 5;
+int CHANNEL_CAPACITY = 4;
 Channel *channel;
 
 static void 
@@ -21,18 +22,18 @@ static void
 receptor(void *n_)
 {
     unsigned *n = (unsigned *)n_;
-    int *buf = new int;
+    int buf;
     for (int i = 0; i < NUM_MSGS; i++)
     {
-        channel->Receive(buf);
-        printf("Receptor %u received %d\n", *n, *buf);
+        channel->Receive(&buf);
+        printf("Receptor %u received %d\n", *n, buf);
     }
 }
 
 void 
 ThreadTestChannels()
 {
-    channel = new Channel("canal de mensajes");
+    channel = new Channel("canal de mensajes", CHANNEL_CAPACITY);
     char **namesE = new char *[NUM_EMISOR];
     unsigned *valuesE = new unsigned[NUM_EMISOR];
     List<Thread *> *threads;
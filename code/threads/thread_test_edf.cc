@@ -0,0 +1,146 @@
+/// Real-time class: periodic threads against CPU hogs.
+///
+/// Two periodic real-time threads do some work every period, within their
+/// budget, while CPU-bound threads of the highest normal priority compete
+/// with them; they must not miss a deadline.  A third real-time thread
+/// does more work than its budget allows: it must be throttled, and its
+/// jobs counted as missed, without taking time from the others.  Admission
+/// is checked too: a thread that does not fit next to those must be
+/// refused, unless there is another CPU to put it on.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "thread_test_edf.hh"
+#include "system.hh"
+
+#include <stdio.h>
+
+
+typedef struct {
+    const char *name;
+    unsigned long period;
+    unsigned long budget;
+    unsigned long work;
+} EdfTask;
+
+static const unsigned EDF_TASKS = 3;
+static const EdfTask TASKS[EDF_TASKS] = {
+    { "rt fast",    1000, 300, 200 },
+    { "rt slow",    2000, 400, 300 },
+    { "rt overrun", 1000, 100, 300 }
+};
+static const unsigned EDF_JOBS = 10;
+
+static const unsigned EDF_HOGS = 2;
+static const unsigned HOG_PRIORITY = 9;
+
+static unsigned long endTick;
+static unsigned long jobs[EDF_TASKS];
+static unsigned long misses[EDF_TASKS];
+static unsigned long hogTicks[EDF_HOGS];
+
+/// Use the CPU for `ticks` ticks of its own.
+static void
+Work(unsigned long ticks)
+{
+    unsigned long start = currentThread->GetCpuTicks();
+    while (currentThread->GetCpuTicks() - start < ticks) {
+        IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
+        interrupt->SetLevel(oldLevel);
+    }
+}
+
+static void
+RealTimeThread(void *arg)
+{
+    const EdfTask *task = (const EdfTask *) arg;
+
+    unsigned long release = stats->totalTicks;
+    for (unsigned i = 0; i < EDF_JOBS; i++) {
+        Work(task->work);
+        release += task->period;
+        if (stats->totalTicks < release) {
+            currentThread->SleepFor(release - stats->totalTicks);
+        }
+    }
+
+    unsigned n = task - TASKS;
+    jobs[n]   = currentThread->GetRealTimeJobs();
+    misses[n] = currentThread->GetDeadlineMisses();
+}
+
+static void
+HogThread(void *arg)
+{
+    unsigned *n = (unsigned *) arg;
+
+    while (stats->totalTicks < endTick) {
+        IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
+        interrupt->SetLevel(oldLevel);
+    }
+    hogTicks[*n] = currentThread->GetCpuTicks();
+}
+
+void
+ThreadTestEdf()
+{
+    Thread *tasks[EDF_TASKS];
+    Thread *hogs[EDF_HOGS];
+    static unsigned ids[EDF_HOGS];
+    static char names[EDF_HOGS][16];
+
+    unsigned long start = stats->totalTicks;
+    endTick = start + 2 * EDF_JOBS * TASKS[1].period;
+
+    for (unsigned i = 0; i < EDF_TASKS; i++) {
+        tasks[i] = new Thread(TASKS[i].name, 1);
+        bool admitted = scheduler->SetRealTime(tasks[i], TASKS[i].period,
+                                               TASKS[i].budget);
+        ASSERT(admitted);
+    }
+
+    // Utilization 0.6, on top of 0.6 already reserved.
+    Thread *greedy = new Thread("rt greedy", 1);
+    bool admitted = scheduler->SetRealTime(greedy, 1000, 600);
+    printf("Greedy real-time thread %s.\n",
+           admitted ? "admitted on another CPU" : "refused");
+    ASSERT(admitted == (scheduler->GetNumCpus() > 1));
+    if (admitted) {
+        scheduler->SetRealTime(greedy, 0, 0);
+    }
+    delete greedy;
+
+    for (unsigned i = 0; i < EDF_HOGS; i++) {
+        ids[i] = i;
+        sprintf(names[i], "hog %u", i);
+        hogs[i] = new Thread(names[i], 1, HOG_PRIORITY);
+        hogs[i]->Fork(HogThread, &ids[i]);
+    }
+    for (unsigned i = 0; i < EDF_TASKS; i++) {
+        tasks[i]->Fork(RealTimeThread, (void *) &TASKS[i]);
+    }
+
+    for (unsigned i = 0; i < EDF_TASKS; i++) {
+        tasks[i]->Join();
+    }
+    for (unsigned i = 0; i < EDF_HOGS; i++) {
+        hogs[i]->Join();
+    }
+
+    for (unsigned i = 0; i < EDF_TASKS; i++) {
+        printf("Thread \"%s\": period %lu, budget %lu, work %lu; "
+               "%lu jobs, %lu deadline misses.\n",
+               TASKS[i].name, TASKS[i].period, TASKS[i].budget,
+               TASKS[i].work, jobs[i], misses[i]);
+    }
+    for (unsigned i = 0; i < EDF_HOGS; i++) {
+        printf("Hog %u: %lu CPU ticks.\n", i, hogTicks[i]);
+    }
+    printf("Elapsed: %lu ticks.\n", stats->totalTicks - start);
+
+    ASSERT(misses[0] == 0 && misses[1] == 0);
+    ASSERT(misses[2] > 0);
+}
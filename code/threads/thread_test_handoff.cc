@@ -0,0 +1,86 @@
+/// Lock convoys: threads take turns on a busy lock.
+///
+/// Several threads keep taking the same lock, and give up the CPU while
+/// holding it, as if waiting for I/O, so that the others pile up on it.
+/// A lock that lets the releasing thread take it right back starves them;
+/// handing it over in order makes them take turns.  Report the order in
+/// which they got the lock, and the counters kept by the lock.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "thread_test_handoff.hh"
+#include "system.hh"
+#include "lock.hh"
+
+#include <stdio.h>
+
+
+static const unsigned HANDOFF_THREADS = 4;
+static const unsigned HANDOFF_ROUNDS  = 25;
+
+static Lock *lock;
+static unsigned owners[HANDOFF_THREADS * HANDOFF_ROUNDS];
+static unsigned numOwners;
+static bool busy;
+
+static void
+HandoffThread(void *arg)
+{
+    unsigned *n = (unsigned *) arg;
+
+    for (unsigned i = 0; i < HANDOFF_ROUNDS; i++) {
+        lock->Acquire();
+        ASSERT(!busy);
+        busy = true;
+        owners[numOwners++] = *n;
+        currentThread->Yield();
+        busy = false;
+        lock->Release();
+    }
+}
+
+void
+ThreadTestHandoff()
+{
+    Thread *threads[HANDOFF_THREADS];
+    static unsigned ids[HANDOFF_THREADS];
+    static char names[HANDOFF_THREADS][16];
+
+    lock = new Lock("handoff");
+    numOwners = 0;
+    for (unsigned i = 0; i < HANDOFF_THREADS; i++) {
+        ids[i] = i;
+        sprintf(names[i], "handoff %u", i);
+        threads[i] = new Thread(names[i], 1);
+        threads[i]->Fork(HandoffThread, &ids[i]);
+    }
+    for (unsigned i = 0; i < HANDOFF_THREADS; i++) {
+        threads[i]->Join();
+    }
+
+    // Longest run of turns in a row taken by the same thread.
+    unsigned longest = 1, run = 1;
+    for (unsigned i = 1; i < numOwners; i++) {
+        run = owners[i] == owners[i - 1] ? run + 1 : 1;
+        if (run > longest) {
+            longest = run;
+        }
+    }
+
+    printf("Order of turns:");
+    for (unsigned i = 0; i < numOwners; i++) {
+        printf(" %u", owners[i]);
+    }
+    printf("\n");
+    printf("Longest run of one thread: %u turns.\n", longest);
+    printf("Lock: %lu acquisitions, %lu contended, %lu handoffs.\n",
+           lock->GetAcquisitions(), lock->GetContentions(),
+           lock->GetHandoffs());
+
+    ASSERT(numOwners == HANDOFF_THREADS * HANDOFF_ROUNDS);
+    ASSERT(lock->GetAcquisitions() == numOwners);
+    delete lock;
+}
@@ -0,0 +1,109 @@
+/// Thundering herd: many threads waiting on one condition, woken up by
+/// `Broadcast`.
+///
+/// Every round, the main thread bumps a generation counter and broadcasts,
+/// holding the lock, and the waiters each take note under the lock and go
+/// back to waiting; the last one tells the main thread.  If a broadcast
+/// made every waiter ready, all but one would run only to block on the lock
+/// again; moved onto the lock instead, each runs once per round, when
+/// handed the lock.  Report the context switches per round: at best, one
+/// per waiter and one back to the main thread.
+///
+/// Then check that a timed `Wait` with no `Signal` gives up, and returns
+/// with the lock held.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "thread_test_herd.hh"
+#include "system.hh"
+#include "condition.hh"
+
+#include <stdio.h>
+
+
+static const unsigned HERD_WAITERS = 8;
+static const unsigned HERD_ROUNDS  = 20;
+
+static const unsigned long HERD_TIMEOUT = 300;
+
+static Lock *lock;
+static Condition *changed;
+static Condition *allWoken;
+static unsigned generation;
+static unsigned wakeups;
+
+static void
+Waiter(void *dummy)
+{
+    unsigned seen = 0;
+
+    lock->Acquire();
+    while (seen < HERD_ROUNDS) {
+        while (generation == seen) {
+            changed->Wait();
+        }
+        seen = generation;
+        if (++wakeups == generation * HERD_WAITERS) {
+            allWoken->Signal();
+        }
+    }
+    lock->Release();
+}
+
+void
+ThreadTestHerd()
+{
+    static char names[HERD_WAITERS][16];
+    Thread *waiters[HERD_WAITERS];
+
+    lock = new Lock("herd");
+    changed = new Condition("herd changed", lock);
+    allWoken = new Condition("herd all woken", lock);
+    generation = 0;
+    wakeups = 0;
+    for (unsigned i = 0; i < HERD_WAITERS; i++) {
+        sprintf(names[i], "waiter %u", i);
+        waiters[i] = new Thread(names[i], 1);
+        waiters[i]->Fork(Waiter, nullptr);
+    }
+    // Let them all start waiting.
+    while (lock->GetAcquisitions() < HERD_WAITERS) {
+        currentThread->Yield();
+    }
+
+    unsigned long startSwitches = stats->numContextSwitches;
+    for (unsigned round = 1; round <= HERD_ROUNDS; round++) {
+        lock->Acquire();
+        generation = round;
+        changed->Broadcast();
+        while (wakeups < round * HERD_WAITERS) {
+            allWoken->Wait();
+        }
+        lock->Release();
+    }
+    unsigned long switches = stats->numContextSwitches - startSwitches;
+
+    for (unsigned i = 0; i < HERD_WAITERS; i++) {
+        waiters[i]->Join();
+    }
+    printf("%u waiters, %u broadcasts: %.1f context switches per round.\n",
+           HERD_WAITERS, HERD_ROUNDS, (double) switches / HERD_ROUNDS);
+    ASSERT(wakeups == HERD_WAITERS * HERD_ROUNDS);
+
+    lock->Acquire();
+    unsigned long start = stats->totalTicks;
+    bool signalled = changed->Wait(HERD_TIMEOUT);
+    unsigned long waited = stats->totalTicks - start;
+    ASSERT(lock->IsHeldByCurrentThread());
+    lock->Release();
+    printf("Timed wait with no signal: %s after %lu ticks.\n",
+           signalled ? "signalled" : "timed out", waited);
+    ASSERT(!signalled && waited >= HERD_TIMEOUT);
+
+    delete changed;
+    delete allWoken;
+    delete lock;
+}
@@ -0,0 +1,11 @@
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_THREADS_THREADTESTHERD__HH
+#define NACHOS_THREADS_THREADTESTHERD__HH
+
+void ThreadTestHerd();
+
+
+#endif
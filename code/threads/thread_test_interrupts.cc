@@ -0,0 +1,135 @@
+/// Pending interrupts: thousands of device interrupts in flight at once.
+///
+/// Schedule `INTERRUPT_EVENTS` interrupts at scattered times, each of which
+/// schedules itself again a few times when it fires, as a device with a
+/// steady stream of requests would, and advance simulated time until all of
+/// them are done.  Check that every one fires, in order of time, and never
+/// early.  Report the host time per interrupt scheduled and fired, and, for
+/// reference, the time a sorted list takes to do the same.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "thread_test_interrupts.hh"
+#include "system.hh"
+#include "lib/list.hh"
+
+#include <stdio.h>
+#include <time.h>
+
+
+static const unsigned INTERRUPT_EVENTS = 4096;
+static const unsigned INTERRUPT_REARMS = 4;
+
+/// Interrupts are scattered over this many ticks.
+static const unsigned INTERRUPT_SPAN = 4 * INTERRUPT_EVENTS;
+
+struct Event {
+    unsigned long due;
+    unsigned rearms;
+};
+
+static Event events[INTERRUPT_EVENTS];
+static unsigned fired;
+static unsigned long lastDue;
+static unsigned seed;
+
+/// A fixed pseudo-random sequence of delays, so that every run, with or
+/// without `-rs`, schedules the same interrupts.
+static unsigned
+NextDelay()
+{
+    seed = seed * 1103515245 + 12345;
+    return 1 + (seed >> 16) % INTERRUPT_SPAN;
+}
+
+static void
+Fire(void *arg)
+{
+    Event *e = (Event *) arg;
+    ASSERT(e->due <= stats->totalTicks);
+    ASSERT(e->due >= lastDue);
+    lastDue = e->due;
+    fired++;
+
+    if (e->rearms > 0) {
+        e->rearms--;
+        unsigned delay = NextDelay();
+        e->due = stats->totalTicks + delay;
+        interrupt->Schedule(Fire, e, delay, DISK_INT);
+    }
+}
+
+static double
+Micros(clock_t start, clock_t end, unsigned n)
+{
+    return 1e6 * (end - start) / CLOCKS_PER_SEC / n;
+}
+
+/// The same work on a `List` kept sorted, as the pending set used to be.
+static void
+SortedListReference()
+{
+    List<Event *> list;
+
+    seed = 1;
+    clock_t start = clock();
+    unsigned long now = 0;
+    for (unsigned i = 0; i < INTERRUPT_EVENTS; i++) {
+        events[i].rearms = INTERRUPT_REARMS;
+        list.SortedInsert(&events[i], now + NextDelay());
+    }
+    Event *e;
+    int when;
+    while ((e = list.SortedPop(&when)) != nullptr) {
+        now = when;
+        if (e->rearms > 0) {
+            e->rearms--;
+            list.SortedInsert(e, now + NextDelay());
+        }
+    }
+    clock_t end = clock();
+
+    printf("Sorted list: %.3f us per interrupt.\n",
+           Micros(start, end, INTERRUPT_EVENTS * (INTERRUPT_REARMS + 1)));
+}
+
+void
+ThreadTestInterrupts()
+{
+    const unsigned total = INTERRUPT_EVENTS * (INTERRUPT_REARMS + 1);
+
+    seed = 1;
+    fired = 0;
+    lastDue = stats->totalTicks;
+
+    IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
+    clock_t start = clock();
+    for (unsigned i = 0; i < INTERRUPT_EVENTS; i++) {
+        unsigned delay = NextDelay();
+        events[i].due = stats->totalTicks + delay;
+        events[i].rearms = INTERRUPT_REARMS;
+        interrupt->Schedule(Fire, &events[i], delay, DISK_INT);
+    }
+    clock_t scheduled = clock();
+    unsigned pending = interrupt->GetNumPending();
+    interrupt->SetLevel(oldLevel);
+    ASSERT(pending >= INTERRUPT_EVENTS);
+
+    unsigned long startTicks = stats->totalTicks;
+    while (fired < total) {
+        interrupt->SetLevel(INT_OFF);
+        interrupt->SetLevel(INT_ON);  // Advance simulated time.
+    }
+    clock_t end = clock();
+
+    printf("%u interrupts pending, %u fired over %lu ticks.\n",
+           pending, fired, stats->totalTicks - startTicks);
+    printf("Heap: %.3f us per interrupt scheduled, %.3f us per interrupt"
+           " fired, ticks included.\n",
+           Micros(start, scheduled, INTERRUPT_EVENTS),
+           Micros(scheduled, end, total));
+    SortedListReference();
+}
@@ -0,0 +1,144 @@
+/// Priority inversion through nested locks: a benchmark for priority
+/// inheritance.
+///
+/// A low priority thread holds lock A.  A middle priority thread takes
+/// lock B and then blocks on A.  A high priority thread then blocks on B,
+/// while CPU-bound threads of a priority between the middle and the high
+/// one are ready.  Unless the high priority is passed on transitively, down
+/// to the holder of A, those threads run first and the high priority thread
+/// waits for all of their work; with it, the holder of A takes turns with
+/// them, as `Yield` goes round the ready threads.  Report how long the high
+/// priority thread waited, in ticks, and how much work the CPU-bound
+/// threads got done meanwhile.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "thread_test_inversion.hh"
+#include "system.hh"
+#include "lock.hh"
+
+#include <stdio.h>
+
+
+static const unsigned LOW_PRIORITY    = 1;
+static const unsigned MIDDLE_PRIORITY = 5;
+static const unsigned HOG_PRIORITY    = 7;
+static const unsigned HIGH_PRIORITY   = 9;
+
+static const unsigned NUM_HOGS  = 3;
+static const unsigned LOW_WORK  = 30;
+static const unsigned MID_WORK  = 5;
+static const unsigned HOG_WORK  = 100;
+
+/// When each thread shows up, in ticks from the start.
+static const unsigned long MIDDLE_ARRIVAL = 2 * TIMER_TICKS;
+static const unsigned long HOG_ARRIVAL    = 4 * TIMER_TICKS;
+static const unsigned long HIGH_ARRIVAL   = 6 * TIMER_TICKS;
+
+static Lock *lockA;
+static Lock *lockB;
+
+static unsigned hogWork;
+static bool highWaiting;
+static unsigned hogWorkWhileWaiting;
+static unsigned long highLatency;
+
+/// One unit of work: let a few ticks go by, then give other threads a
+/// chance.
+static void
+Work()
+{
+    for (unsigned i = 0; i < 5; i++) {
+        IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
+        interrupt->SetLevel(oldLevel);
+    }
+    currentThread->Yield();
+}
+
+static void
+LowThread(void *arg)
+{
+    lockA->Acquire();
+    for (unsigned i = 0; i < LOW_WORK; i++) {
+        Work();
+    }
+    lockA->Release();
+}
+
+static void
+MiddleThread(void *arg)
+{
+    currentThread->SleepFor(MIDDLE_ARRIVAL);
+    lockB->Acquire();
+    lockA->Acquire();
+    for (unsigned i = 0; i < MID_WORK; i++) {
+        Work();
+    }
+    lockA->Release();
+    lockB->Release();
+}
+
+static void
+HogThread(void *arg)
+{
+    currentThread->SleepFor(HOG_ARRIVAL);
+    for (unsigned i = 0; i < HOG_WORK; i++) {
+        Work();
+        hogWork++;
+        if (highWaiting) {
+            hogWorkWhileWaiting++;
+        }
+    }
+}
+
+static void
+HighThread(void *arg)
+{
+    currentThread->SleepFor(HIGH_ARRIVAL);
+    unsigned long start = stats->totalTicks;
+    highWaiting = true;
+    lockB->Acquire();
+    highWaiting = false;
+    highLatency = stats->totalTicks - start;
+    lockB->Release();
+}
+
+void
+ThreadTestInversion()
+{
+    lockA = new Lock("A");
+    lockB = new Lock("B");
+
+    Thread *low = new Thread("low", 1, LOW_PRIORITY);
+    Thread *middle = new Thread("middle", 1, MIDDLE_PRIORITY);
+    Thread *high = new Thread("high", 1, HIGH_PRIORITY);
+    Thread *hogs[NUM_HOGS];
+    char names[NUM_HOGS][16];
+
+    low->Fork(LowThread, nullptr);
+    middle->Fork(MiddleThread, nullptr);
+    high->Fork(HighThread, nullptr);
+    for (unsigned i = 0; i < NUM_HOGS; i++) {
+        sprintf(names[i], "hog %u", i);
+        hogs[i] = new Thread(names[i], 1, HOG_PRIORITY);
+        hogs[i]->Fork(HogThread, nullptr);
+    }
+
+    low->Join();
+    middle->Join();
+    high->Join();
+    for (unsigned i = 0; i < NUM_HOGS; i++) {
+        hogs[i]->Join();
+    }
+
+    printf("High priority thread waited %lu ticks for its lock.\n",
+           highLatency);
+    printf("CPU-bound threads did %u of %u units of work meanwhile.\n",
+           hogWorkWhileWaiting, hogWork);
+
+    delete lockA;
+    delete lockB;
+}
@@ -0,0 +1,106 @@
+/// Lock contention profile and lock order checks.
+///
+/// A few threads share a hot lock and a cold one, with their own private
+/// locks of the same name, and pass work through a semaphore.  The profile
+/// must rank the hot lock first among locks.  Then a single thread takes
+/// two locks in both orders, one after the other: it cannot deadlock by
+/// itself, but two threads doing the same could, and the lock order check
+/// must say so.
+///
+/// The test profiles on its own, whether `-lp` was given or not.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "thread_test_lockprof.hh"
+#include "system.hh"
+#include "lock.hh"
+
+#include <stdio.h>
+
+
+static const unsigned PROF_THREADS = 4;
+static const unsigned PROF_ROUNDS  = 20;
+
+static Lock *hot;
+static Lock *cold;
+static Semaphore *work;
+
+static void
+ProfThread(void *dummy)
+{
+    Lock *mine = new Lock("private");
+
+    for (unsigned i = 0; i < PROF_ROUNDS; i++) {
+        mine->Acquire();
+        hot->Acquire();
+        currentThread->Yield();  // Hold it for a while.
+        hot->Release();
+        mine->Release();
+
+        if (i % 5 == 0) {
+            cold->Acquire();
+            cold->Release();
+        }
+        work->V();
+    }
+    delete mine;
+}
+
+void
+ThreadTestLockProf()
+{
+    LockProfiler *saved = lockProfiler;
+    LockProfiler *profiler = new LockProfiler;
+    lockProfiler = profiler;
+
+    static char names[PROF_THREADS][16];
+    Thread *threads[PROF_THREADS];
+
+    hot  = new Lock("hot");
+    cold = new Lock("cold");
+    work = new Semaphore("work", 0);
+    for (unsigned i = 0; i < PROF_THREADS; i++) {
+        sprintf(names[i], "profiled %u", i);
+        threads[i] = new Thread(names[i], 1);
+        threads[i]->Fork(ProfThread, nullptr);
+    }
+    for (unsigned i = 0; i < PROF_THREADS * PROF_ROUNDS; i++) {
+        work->P();
+    }
+    for (unsigned i = 0; i < PROF_THREADS; i++) {
+        threads[i]->Join();
+    }
+    ASSERT(profiler->GetCycles() == 0);
+
+    Lock *a = new Lock("first");
+    Lock *b = new Lock("second");
+    a->Acquire();
+    b->Acquire();
+    b->Release();
+    a->Release();
+    ASSERT(profiler->GetCycles() == 0);
+    b->Acquire();
+    a->Acquire();
+    a->Release();
+    b->Release();
+    ASSERT(profiler->GetCycles() == 1);
+
+    profiler->Print();
+
+    const SyncProfile *top = profiler->GetTop(SYNC_LOCK);
+    ASSERT(top == profiler->Find(SYNC_LOCK, "hot"));
+    ASSERT(top->objects == 1);
+    ASSERT(top->acquires == PROF_THREADS * PROF_ROUNDS);
+    ASSERT(top->contended > 0 && top->holdTicks > 0);
+
+    delete a;
+    delete b;
+    delete hot;
+    delete cold;
+    delete work;
+    lockProfiler = saved;
+    delete profiler;
+}
@@ -0,0 +1,193 @@
+/// Channel throughput: a producer and a consumer joined by a pipe.
+///
+/// The producer sends a run of numbers over a channel and the consumer
+/// checks that they arrive in order, first one message at a time and then
+/// in batches, for channels of several capacities.  Report the messages
+/// moved per tick and per context switch.  A rendezvous channel
+/// switches threads on every message; a buffered one lets either side run
+/// on until the ring fills up or runs dry.  A batch blocks at most once, so
+/// on a uniprocessor batches must take fewer switches than single
+/// messages.  (On a multiprocessor both sides run at once, and single
+/// messages may hardly block at all.)
+///
+/// Then check the non-blocking operations, and `Channel::Select` over
+/// channels fed by different senders.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "thread_test_pipe.hh"
+#include "system.hh"
+#include "channel.hh"
+
+#include <stdio.h>
+
+
+static const unsigned PIPE_MESSAGES = 1024;
+static const unsigned PIPE_BATCH    = 16;
+static const unsigned PIPE_CAPACITIES[] = { 0, 1, 4, 16, 64 };
+static const unsigned PIPE_NUM_CAPACITIES
+  = sizeof PIPE_CAPACITIES / sizeof PIPE_CAPACITIES[0];
+
+static const unsigned SELECT_SENDERS  = 3;
+static const unsigned SELECT_MESSAGES = 20;
+
+static Channel *pipe;
+static bool batched;
+
+static void
+Producer(void *dummy)
+{
+    int batch[PIPE_BATCH];
+
+    for (unsigned i = 0; i < PIPE_MESSAGES; i += PIPE_BATCH) {
+        for (unsigned j = 0; j < PIPE_BATCH; j++) {
+            batch[j] = i + j;
+        }
+        if (batched) {
+            pipe->SendN(batch, PIPE_BATCH);
+        } else {
+            for (unsigned j = 0; j < PIPE_BATCH; j++) {
+                pipe->Send(batch[j]);
+            }
+        }
+    }
+}
+
+static void
+Consumer(void *dummy)
+{
+    int batch[PIPE_BATCH];
+
+    for (unsigned i = 0; i < PIPE_MESSAGES; i += PIPE_BATCH) {
+        if (batched) {
+            pipe->ReceiveN(batch, PIPE_BATCH);
+        } else {
+            for (unsigned j = 0; j < PIPE_BATCH; j++) {
+                pipe->Receive(&batch[j]);
+            }
+        }
+        for (unsigned j = 0; j < PIPE_BATCH; j++) {
+            ASSERT(batch[j] == (int) (i + j));
+        }
+    }
+}
+
+/// Returns the number of context switches taken.
+static unsigned long
+RunPipe(unsigned capacity, bool batch)
+{
+    pipe = new Channel("pipe", capacity);
+    batched = batch;
+
+    unsigned long startTicks = stats->totalTicks;
+    unsigned long startSwitches = stats->numContextSwitches;
+
+    Thread *producer = new Thread("producer", 1);
+    Thread *consumer = new Thread("consumer", 1);
+    producer->Fork(Producer, nullptr);
+    consumer->Fork(Consumer, nullptr);
+    producer->Join();
+    consumer->Join();
+
+    unsigned long ticks = stats->totalTicks - startTicks;
+    unsigned long switches = stats->numContextSwitches - startSwitches;
+    printf("%8u  %-6s  %7lu  %13.3f  %8lu  %15.2f\n",
+           capacity, batch ? "batch" : "single", ticks,
+           (double) PIPE_MESSAGES / ticks, switches,
+           (double) PIPE_MESSAGES / switches);
+
+    ASSERT(pipe->GetCount() == 0);
+    delete pipe;
+    return switches;
+}
+
+static Channel *feeds[SELECT_SENDERS];
+
+static void
+Feeder(void *arg)
+{
+    unsigned *n = (unsigned *) arg;
+
+    for (unsigned i = 0; i < SELECT_MESSAGES; i++) {
+        feeds[*n]->Send(*n * SELECT_MESSAGES + i);
+    }
+}
+
+static void
+TestTry()
+{
+    Channel *c = new Channel("try", 2);
+    int message;
+
+    ASSERT(!c->TryReceive(&message));
+    ASSERT(c->TrySend(1));
+    ASSERT(c->TrySend(2));
+    ASSERT(!c->TrySend(3));
+    ASSERT(c->TryReceive(&message) && message == 1);
+    ASSERT(c->TryReceive(&message) && message == 2);
+    ASSERT(!c->TryReceive(&message));
+    delete c;
+
+    Channel *r = new Channel("try rendezvous");
+    ASSERT(!r->TrySend(1));
+    ASSERT(!r->TryReceive(&message));
+    delete r;
+
+    printf("Non-blocking operations fail instead of waiting.\n");
+}
+
+static void
+TestSelect()
+{
+    static unsigned ids[SELECT_SENDERS];
+    static char names[SELECT_SENDERS][16];
+    Thread *feeders[SELECT_SENDERS];
+    unsigned next[SELECT_SENDERS];
+
+    for (unsigned i = 0; i < SELECT_SENDERS; i++) {
+        ids[i] = i;
+        next[i] = 0;
+        sprintf(names[i], "feeder %u", i);
+        feeds[i] = new Channel(names[i], i);  // Rendezvous, 1 and 2.
+        feeders[i] = new Thread(names[i], 1);
+        feeders[i]->Fork(Feeder, &ids[i]);
+    }
+
+    for (unsigned i = 0; i < SELECT_SENDERS * SELECT_MESSAGES; i++) {
+        int message;
+        unsigned which = Channel::Select(feeds, SELECT_SENDERS, &message);
+        ASSERT(which < SELECT_SENDERS);
+        // Messages from each sender arrive in order, on its own channel.
+        ASSERT(message == (int) (which * SELECT_MESSAGES + next[which]));
+        next[which]++;
+    }
+
+    for (unsigned i = 0; i < SELECT_SENDERS; i++) {
+        feeders[i]->Join();
+        ASSERT(next[i] == SELECT_MESSAGES);
+        delete feeds[i];
+    }
+    printf("Select received %u messages from each of %u channels.\n",
+           SELECT_MESSAGES, SELECT_SENDERS);
+}
+
+void
+ThreadTestPipe()
+{
+    printf("%u messages, in batches of %u.\n", PIPE_MESSAGES, PIPE_BATCH);
+    printf("capacity  mode      ticks  messages/tick  switches"
+           "  messages/switch\n");
+    for (unsigned i = 0; i < PIPE_NUM_CAPACITIES; i++) {
+        unsigned long single = RunPipe(PIPE_CAPACITIES[i], false);
+        unsigned long batch = RunPipe(PIPE_CAPACITIES[i], true);
+        if (scheduler->GetNumCpus() == 1) {
+            ASSERT(batch < single);
+        }
+    }
+
+    TestTry();
+    TestSelect();
+}
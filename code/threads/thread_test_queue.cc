@@ -0,0 +1,116 @@
+/// A bounded work queue: fast producers, a slow consumer.
+///
+/// Several producers append work items to a bounded `SynchList` as fast as
+/// they can, while a single consumer drains it in batches, yielding between
+/// batches as if doing the work.  The queue never grows beyond its
+/// capacity: the producers are held back instead.  Report how many items
+/// each batch took on average.
+///
+/// Then check that a timed `Pop` gives up on an empty queue, and that it
+/// gets an item appended before its timeout.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "thread_test_queue.hh"
+#include "system.hh"
+#include "synch_list.hh"
+
+#include <stdio.h>
+
+
+static const unsigned QUEUE_CAPACITY  = 8;
+static const unsigned QUEUE_PRODUCERS = 3;
+static const unsigned QUEUE_ITEMS     = 100;
+static const unsigned QUEUE_BATCH     = 16;
+
+static const unsigned long QUEUE_TIMEOUT = 500;
+static const unsigned long QUEUE_DELAY   = 200;
+
+static SynchList<unsigned> *queue;
+
+static void
+Producer(void *arg)
+{
+    unsigned *n = (unsigned *) arg;
+
+    for (unsigned i = 0; i < QUEUE_ITEMS; i++) {
+        queue->Append(*n * QUEUE_ITEMS + i);
+    }
+}
+
+static void
+LateProducer(void *dummy)
+{
+    currentThread->SleepFor(QUEUE_DELAY);
+    queue->Append(42);
+}
+
+void
+ThreadTestQueue()
+{
+    static unsigned ids[QUEUE_PRODUCERS];
+    static char names[QUEUE_PRODUCERS][16];
+    Thread *producers[QUEUE_PRODUCERS];
+    unsigned next[QUEUE_PRODUCERS];
+
+    queue = new SynchList<unsigned>(QUEUE_CAPACITY);
+    for (unsigned i = 0; i < QUEUE_PRODUCERS; i++) {
+        ids[i] = i;
+        next[i] = 0;
+        sprintf(names[i], "producer %u", i);
+        producers[i] = new Thread(names[i], 1);
+        producers[i]->Fork(Producer, &ids[i]);
+    }
+
+    unsigned items[QUEUE_BATCH];
+    unsigned batches = 0, received = 0, mostQueued = 0;
+    while (received < QUEUE_PRODUCERS * QUEUE_ITEMS) {
+        unsigned queued = queue->GetCount();
+        if (queued > mostQueued) {
+            mostQueued = queued;
+        }
+        unsigned n = queue->PopBatch(items, QUEUE_BATCH);
+        ASSERT(n > 0 && n <= QUEUE_CAPACITY);
+        for (unsigned i = 0; i < n; i++) {
+            // Items from each producer come out in order.
+            unsigned p = items[i] / QUEUE_ITEMS;
+            ASSERT(p < QUEUE_PRODUCERS);
+            ASSERT(items[i] % QUEUE_ITEMS == next[p]);
+            next[p]++;
+        }
+        received += n;
+        batches++;
+        currentThread->Yield();
+    }
+    for (unsigned i = 0; i < QUEUE_PRODUCERS; i++) {
+        producers[i]->Join();
+    }
+    printf("%u items in %u batches, %.1f per batch; "
+           "at most %u of %u queued.\n",
+           received, batches, (double) received / batches,
+           mostQueued, QUEUE_CAPACITY);
+    ASSERT(mostQueued <= QUEUE_CAPACITY);
+
+    unsigned item;
+    unsigned long start = stats->totalTicks;
+    bool got = queue->Pop(&item, QUEUE_TIMEOUT);
+    unsigned long waited = stats->totalTicks - start;
+    printf("Timed pop on an empty queue: %s after %lu ticks.\n",
+           got ? "got an item" : "gave up", waited);
+    ASSERT(!got && waited >= QUEUE_TIMEOUT);
+
+    Thread *late = new Thread("late producer", 1);
+    late->Fork(LateProducer, nullptr);
+    start = stats->totalTicks;
+    got = queue->Pop(&item, QUEUE_TIMEOUT * 10);
+    waited = stats->totalTicks - start;
+    late->Join();
+    printf("Timed pop with an item on its way: %s after %lu ticks.\n",
+           got ? "got it" : "gave up", waited);
+    ASSERT(got && item == 42 && waited < QUEUE_TIMEOUT * 10);
+
+    delete queue;
+}
@@ -0,0 +1,174 @@
+/// Reader-writer locks: exclusion, writer preference, recursive reads, and
+/// upgrading and downgrading.
+///
+/// First, readers and writers take turns on a lock, yielding while they hold
+/// it, and check that writers are alone.  Then the main thread walks through
+/// the special cases step by step, with helper threads.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "thread_test_rwlock.hh"
+#include "system.hh"
+#include "rw_lock.hh"
+
+#include <stdio.h>
+
+
+static const unsigned RW_READERS = 4;
+static const unsigned RW_WRITERS = 2;
+static const unsigned RW_ROUNDS  = 10;
+
+static RWLock *rwLock;
+static unsigned readersIn, writersIn, mostReaders;
+static unsigned reads, writes;
+
+static void
+ReaderThread(void *arg)
+{
+    for (unsigned i = 0; i < RW_ROUNDS; i++) {
+        rwLock->AcquireRead();
+        ASSERT(writersIn == 0);
+        readersIn++;
+        if (readersIn > mostReaders) {
+            mostReaders = readersIn;
+        }
+        currentThread->Yield();
+        reads++;
+        readersIn--;
+        rwLock->ReleaseRead();
+        currentThread->Yield();
+    }
+}
+
+static void
+WriterThread(void *arg)
+{
+    for (unsigned i = 0; i < RW_ROUNDS; i++) {
+        rwLock->AcquireWrite();
+        ASSERT(readersIn == 0 && writersIn == 0);
+        writersIn++;
+        currentThread->Yield();
+        writes++;
+        writersIn--;
+        rwLock->ReleaseWrite();
+        currentThread->Yield();
+    }
+}
+
+/// Log of the order in which the helpers of the step by step part got in.
+static char order[8];
+static unsigned numOrder;
+static bool started;
+static bool upgraded;
+
+/// Yield until a helper thread has started and blocked.
+static void
+WaitUntilStarted()
+{
+    while (!started) {
+        currentThread->Yield();
+    }
+    started = false;
+}
+
+static void
+LateWriter(void *arg)
+{
+    started = true;
+    rwLock->AcquireWrite();
+    order[numOrder++] = 'W';
+    rwLock->ReleaseWrite();
+}
+
+static void
+LateReader(void *arg)
+{
+    started = true;
+    rwLock->AcquireRead();
+    order[numOrder++] = 'R';
+    rwLock->ReleaseRead();
+}
+
+static void
+RivalUpgrader(void *arg)
+{
+    Semaphore *go = (Semaphore *) arg;
+
+    rwLock->AcquireRead();
+    started = true;
+    go->P();
+    upgraded = rwLock->Upgrade();
+    if (upgraded) {
+        rwLock->ReleaseWrite();
+    } else {
+        rwLock->ReleaseRead();
+    }
+}
+
+void
+ThreadTestRWLock()
+{
+    rwLock = new RWLock("rwlock test");
+
+    Thread *threads[RW_READERS + RW_WRITERS];
+    static char names[RW_READERS + RW_WRITERS][16];
+    for (unsigned i = 0; i < RW_READERS + RW_WRITERS; i++) {
+        bool reader = i < RW_READERS;
+        sprintf(names[i], "%s %u", reader ? "reader" : "writer", i);
+        threads[i] = new Thread(names[i], 1);
+        threads[i]->Fork(reader ? ReaderThread : WriterThread, nullptr);
+    }
+    for (unsigned i = 0; i < RW_READERS + RW_WRITERS; i++) {
+        threads[i]->Join();
+    }
+    printf("%u reads, %u writes, up to %u readers at once.\n",
+           reads, writes, mostReaders);
+    ASSERT(reads == RW_READERS * RW_ROUNDS && writes == RW_WRITERS * RW_ROUNDS);
+    ASSERT(mostReaders > 1);
+
+    // A waiting writer keeps new readers out, but not the nested reads of
+    // a thread already reading.
+    rwLock->AcquireRead();
+    Thread *writer = new Thread("late writer", 1);
+    writer->Fork(LateWriter, nullptr);
+    WaitUntilStarted();
+    Thread *reader = new Thread("late reader", 1);
+    reader->Fork(LateReader, nullptr);
+    WaitUntilStarted();
+    ASSERT(numOrder == 0);
+    rwLock->AcquireRead();
+    ASSERT(rwLock->IsReadHeldByCurrentThread());
+    rwLock->ReleaseRead();
+    rwLock->ReleaseRead();
+    writer->Join();
+    reader->Join();
+    order[numOrder] = '\0';
+    printf("Order after the first reader left: %s.\n", order);
+    ASSERT(order[0] == 'W' && order[1] == 'R');
+
+    // Only one of two readers can upgrade.  Which one depends on who gets
+    // there first, under random time slicing.
+    Semaphore *go = new Semaphore("go", 0);
+    rwLock->AcquireRead();
+    Thread *rival = new Thread("rival upgrader", 1);
+    rival->Fork(RivalUpgrader, go);
+    WaitUntilStarted();
+    go->V();
+    bool mine = rwLock->Upgrade();
+    if (mine) {
+        ASSERT(rwLock->IsWriteHeldByCurrentThread());
+        rwLock->Downgrade();
+        ASSERT(rwLock->IsReadHeldByCurrentThread());
+        ASSERT(!rwLock->IsWriteHeldByCurrentThread());
+    }
+    rwLock->ReleaseRead();
+    rival->Join();
+    printf("Rival upgrade %s.\n", upgraded ? "succeeded" : "refused");
+    ASSERT(mine != upgraded);
+
+    delete go;
+    delete rwLock;
+}
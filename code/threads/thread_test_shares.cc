@@ -0,0 +1,104 @@
+/// Proportional share: a benchmark for the scheduling policies.
+///
+/// Fork CPU-bound threads holding different numbers of tickets and let them
+/// compete for a fixed number of ticks.  Then compare the CPU time each one
+/// got, as charged by the scheduler, with the share its tickets entitle it
+/// to.
+///
+/// Meant to be run with `-sp stride` or `-sp lottery`, on one CPU or more
+/// (for example `-sp stride -cpus 2`); under those two policies the test
+/// asserts that every share is close to the expected one.  Under the other
+/// policies the tickets are ignored.  Shares are not checked either when
+/// some of them are above what a single CPU gives, as with `-cpus 3`: a
+/// thread cannot run on two CPUs at once.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "thread_test_shares.hh"
+#include "system.hh"
+
+#include <stdio.h>
+#include <string.h>
+
+
+static const unsigned SHARES_THREADS = 4;
+static const unsigned SHARES_TICKETS[SHARES_THREADS] = { 100, 200, 300, 400 };
+static const unsigned long SHARES_TICKS = 400 * TIMER_TICKS;
+
+/// Largest deviation accepted, in percentage points of the total.
+static const double SHARES_MAX_ERROR = 2.0;
+
+static unsigned long endTick;
+static unsigned long cpuTicks[SHARES_THREADS];
+
+/// Burn CPU until `endTick`.  Toggling interrupts makes simulated time
+/// advance, and lets the timer preempt the thread.
+static void
+SharesThread(void *arg)
+{
+    unsigned *n = (unsigned *) arg;
+
+    while (stats->totalTicks < endTick) {
+        IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
+        interrupt->SetLevel(oldLevel);
+    }
+    cpuTicks[*n] = currentThread->GetCpuTicks();
+}
+
+void
+ThreadTestShares()
+{
+    Thread *threads[SHARES_THREADS];
+    unsigned ids[SHARES_THREADS];
+    char names[SHARES_THREADS][16];
+
+    endTick = stats->totalTicks + SHARES_TICKS;
+
+    unsigned totalTickets = 0;
+    for (unsigned i = 0; i < SHARES_THREADS; i++) {
+        ids[i] = i;
+        sprintf(names[i], "shares %u", i);
+        threads[i] = new Thread(names[i], 1, 4);
+        threads[i]->SetTickets(SHARES_TICKETS[i]);
+        threads[i]->Fork(SharesThread, &ids[i]);
+        totalTickets += SHARES_TICKETS[i];
+    }
+    for (unsigned i = 0; i < SHARES_THREADS; i++) {
+        threads[i]->Join();
+    }
+
+    unsigned long totalTicks = 0;
+    for (unsigned i = 0; i < SHARES_THREADS; i++) {
+        totalTicks += cpuTicks[i];
+    }
+
+    const char *policy = scheduler->GetPolicyName();
+    unsigned numCpus = scheduler->GetNumCpus();
+    printf("Policy: %s, %u CPU(s).\n", policy, numCpus);
+    double maxError = 0.0;
+    bool feasible = true;
+    for (unsigned i = 0; i < SHARES_THREADS; i++) {
+        double expected = 100.0 * SHARES_TICKETS[i] / totalTickets;
+        if (expected * numCpus > 100.0) {
+            feasible = false;
+        }
+        double achieved = totalTicks ? 100.0 * cpuTicks[i] / totalTicks : 0.0;
+        double error = achieved > expected ? achieved - expected
+                                           : expected - achieved;
+        if (error > maxError) {
+            maxError = error;
+        }
+        printf("Thread %u: %u tickets, %lu ticks, %.1f%% (expected %.1f%%).\n",
+               i, SHARES_TICKETS[i], cpuTicks[i], achieved, expected);
+    }
+    printf("Largest deviation from the expected share: %.1f points.\n",
+           maxError);
+
+    if (feasible && (strcmp(policy, "stride") == 0
+                       || strcmp(policy, "lottery") == 0)) {
+        ASSERT(maxError <= SHARES_MAX_ERROR);
+    }
+}
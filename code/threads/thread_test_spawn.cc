@@ -0,0 +1,66 @@
+/// Fork/exit storm: a benchmark for thread creation and destruction.
+///
+/// Spawn many short-lived threads, a few at a time, and wait for each wave
+/// to finish before starting the next one, so that the run is dominated by
+/// `Fork`, `Finish` and the destruction of finished threads.  Report the
+/// host time and the simulated ticks per spawn, and how many threads and
+/// stacks came from the recycling pool (compare with `-pool 0`).
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "thread_test_spawn.hh"
+#include "system.hh"
+
+#include <stdio.h>
+#include <sys/time.h>
+
+
+static const unsigned SPAWN_TOTAL = 5000;
+static const unsigned SPAWN_WAVE  = 8;
+
+static void
+SpawnThread(void *arg)
+{
+    // Nothing to do: the point is the cost of coming and going.
+}
+
+static double
+HostSeconds()
+{
+    struct timeval tv;
+    gettimeofday(&tv, nullptr);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+void
+ThreadTestSpawn()
+{
+    Thread *threads[SPAWN_WAVE];
+
+    unsigned long startTicks = stats->totalTicks;
+    double        startHost  = HostSeconds();
+
+    for (unsigned spawned = 0; spawned < SPAWN_TOTAL; spawned += SPAWN_WAVE) {
+        for (unsigned i = 0; i < SPAWN_WAVE; i++) {
+            threads[i] = new Thread("spawn", 1);
+            threads[i]->Fork(SpawnThread, nullptr);
+        }
+        for (unsigned i = 0; i < SPAWN_WAVE; i++) {
+            threads[i]->Join();
+        }
+    }
+
+    unsigned long ticks = stats->totalTicks - startTicks;
+    double        host  = HostSeconds() - startHost;
+
+    printf("Spawn storm: %u threads, in waves of %u.\n",
+           SPAWN_TOTAL, SPAWN_WAVE);
+    printf("Simulated time: %lu ticks (%.1f ticks/spawn).\n",
+           ticks, (double) ticks / SPAWN_TOTAL);
+    printf("Host time: %.3f s (%.2f us/spawn).\n",
+           host, host * 1e6 / SPAWN_TOTAL);
+    threadPool->Print();
+}
@@ -0,0 +1,75 @@
+/// Thread storm: a benchmark for the dispatcher.
+///
+/// Fork many threads spread over every priority level and have each of them
+/// yield repeatedly, so that the run is dominated by `FindNextToRun`,
+/// `ReadyToRun` and `Run`.  Report how many context switches happened per
+/// simulated tick, and how long the run took on the host.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "thread_test_storm.hh"
+#include "system.hh"
+#include "ready_queue.hh"
+
+#include <stdio.h>
+#include <sys/time.h>
+
+
+static const unsigned STORM_THREADS = 300;
+static const unsigned STORM_YIELDS  = 50;
+
+static void
+StormThread(void *arg)
+{
+    for (unsigned i = 0; i < STORM_YIELDS; i++) {
+        currentThread->Yield();
+    }
+}
+
+static double
+HostSeconds()
+{
+    struct timeval tv;
+    gettimeofday(&tv, nullptr);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+void
+ThreadTestStorm()
+{
+    Thread **threads = new Thread *[STORM_THREADS];
+    char **names = new char *[STORM_THREADS];
+
+    unsigned long startTicks    = stats->totalTicks;
+    unsigned long startSwitches = stats->numContextSwitches;
+    double        startHost     = HostSeconds();
+
+    for (unsigned i = 0; i < STORM_THREADS; i++) {
+        names[i] = new char [16];
+        sprintf(names[i], "storm %u", i);
+        threads[i] = new Thread(names[i], 1, i % NUM_QUEUES);
+        threads[i]->Fork(StormThread, nullptr);
+    }
+    for (unsigned i = 0; i < STORM_THREADS; i++) {
+        threads[i]->Join();
+    }
+
+    unsigned long ticks    = stats->totalTicks - startTicks;
+    unsigned long switches = stats->numContextSwitches - startSwitches;
+    double        host     = HostSeconds() - startHost;
+
+    printf("Storm: %u threads x %u yields.\n", STORM_THREADS, STORM_YIELDS);
+    printf("Context switches: %lu in %lu ticks (%.4f switches/tick).\n",
+           switches, ticks, ticks ? (double) switches / ticks : 0.0);
+    printf("Host time: %.3f s (%.0f switches/s).\n",
+           host, host > 0 ? switches / host : 0.0);
+
+    for (unsigned i = 0; i < STORM_THREADS; i++) {
+        delete [] names[i];
+    }
+    delete [] names;
+    delete [] threads;
+}
@@ -62,4 +62,53 @@ void itoa (int n , char *str)
   str[i] = '\0';
   reverse(str, i);
   return;
-}
\ No newline at end of file
+}
+
+// Mutexes for the threads of a program.
+//
+// `state` is 0 while the mutex is free, 1 while it is held, and 2 while it
+// is held and other threads may be blocked on it.  Taking a free mutex, and
+// releasing one nobody waits for, is done in user memory alone; the kernel
+// is only entered to block on the mutex and to wake up a waiter.
+typedef struct {
+  int state;
+} Mutex;
+
+// Store `value` in `*addr`, and return what it held.
+static int AtomicExchange (volatile int *addr, int value)
+{
+  int old;
+  do {
+    old = *addr;
+  } while (CompareAndSwap((int *) addr, old, value) != old);
+  return old;
+}
+
+void MutexInit (Mutex *m)
+{
+  // `CompareAndSwap` is only atomic once registered.  Doing it again is
+  // harmless.
+  SetAtomicSequence(AtomicSequenceBegin, AtomicSequenceEnd);
+  m->state = 0;
+}
+
+void MutexLock (Mutex *m)
+{
+  int c = CompareAndSwap(&m->state, 0, 1);
+  if (c == 0)
+    return;  // It was free.
+
+  // Mark it as contended before blocking, so that the holder wakes us up.
+  if (c != 2)
+    c = AtomicExchange(&m->state, 2);
+  while (c != 0) {
+    FutexWait(&m->state, 2);
+    c = AtomicExchange(&m->state, 2);
+  }
+}
+
+void MutexUnlock (Mutex *m)
+{
+  if (AtomicExchange(&m->state, 0) == 2)
+    FutexWake(&m->state, 1);
+}
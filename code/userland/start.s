@@ -157,6 +157,84 @@ Cd:
         j       $31
         .end    Cd 
 
+        .globl  SetTickets
+        .ent    SetTickets
+SetTickets:
+        addiu   $2, $0, SC_TICKETS
+        syscall
+        j       $31
+        .end    SetTickets
+
+        .globl  Sleep
+        .ent    Sleep
+Sleep:
+        addiu   $2, $0, SC_SLEEP
+        syscall
+        j       $31
+        .end    Sleep
+
+        .globl  GetSchedStats
+        .ent    GetSchedStats
+GetSchedStats:
+        addiu   $2, $0, SC_SCHEDSTATS
+        syscall
+        j       $31
+        .end    GetSchedStats
+
+        .globl  SetRealTime
+        .ent    SetRealTime
+SetRealTime:
+        addiu   $2, $0, SC_REALTIME
+        syscall
+        j       $31
+        .end    SetRealTime
+
+        .globl  FutexWait
+        .ent    FutexWait
+FutexWait:
+        addiu   $2, $0, SC_FUTEX_WAIT
+        syscall
+        j       $31
+        .end    FutexWait
+
+        .globl  FutexWake
+        .ent    FutexWake
+FutexWake:
+        addiu   $2, $0, SC_FUTEX_WAKE
+        syscall
+        j       $31
+        .end    FutexWake
+
+        .globl  SetAtomicSequence
+        .ent    SetAtomicSequence
+SetAtomicSequence:
+        addiu   $2, $0, SC_ATOMIC_SEQ
+        syscall
+        j       $31
+        .end    SetAtomicSequence
+
+/// `CompareAndSwap(addr, expected, desired)`, as a restartable atomic
+/// sequence: from the load up to the store, the kernel restarts it if the
+/// thread is preempted.  Delay slots are filled by hand, so that the
+/// assembler does not move instructions across the bounds.
+        .globl  CompareAndSwap
+        .globl  AtomicSequenceBegin
+        .globl  AtomicSequenceEnd
+        .ent    CompareAndSwap
+CompareAndSwap:
+        .set    noreorder
+AtomicSequenceBegin:
+        lw      $2, 0($4)
+        nop
+        bne     $2, $5, 1f
+        nop
+        sw      $6, 0($4)
+AtomicSequenceEnd:
+1:      j       $31
+        nop
+        .set    reorder
+        .end    CompareAndSwap
+
 /// Dummy function to keep gcc happy.
         .globl  __main
         .ent    __main
@@ -21,6 +21,7 @@
 AddressSpace::AddressSpace(OpenFile *executable_file)
 {
     executableFile = executable_file;
+    atomicBegin = atomicEnd = 0;
 
     ASSERT(executableFile != nullptr);
 
@@ -85,8 +86,10 @@ AddressSpace::AddressSpace(OpenFile *executable_file)
     }
 
     char *mainMemory = machine->mainMemory;
-    for (unsigned i = 0; i < numPages; i++) 
+    for (unsigned i = 0; i < numPages; i++) {
         memset(&mainMemory[pageTable[i].physicalPage * PAGE_SIZE], 0, PAGE_SIZE);
+        machine->InvalidateCode(pageTable[i].physicalPage * PAGE_SIZE, PAGE_SIZE);
+    }
     
     codeSize = exe.GetCodeSize();
     initDataSize = exe.GetInitDataSize();
@@ -148,6 +151,11 @@ AddressSpace::~AddressSpace()
     #endif
 
     delete [] pageTable;
+
+    // The frames may be given to another address space now.
+    for (unsigned c = 0; c < machine->GetNumCpus(); c++) {
+        machine->GetMMU(c)->FlushHostTlb();
+    }
 }
 
 /// Set the initial values for the user-level register set.
@@ -211,8 +219,44 @@ AddressSpace::RestoreState()
     machine->GetMMU()->pageTable     = pageTable;
     machine->GetMMU()->pageTableSize = numPages;
     #endif
+    machine->GetMMU()->FlushHostTlb();
+}
+
+
+/// The sequence must lie within the code of the program.
+bool
+AddressSpace::SetAtomicSequence(unsigned begin, unsigned end)
+{
+    if (begin % 4 != 0 || end % 4 != 0 || begin >= end
+          || end - begin > ATOMIC_SEQUENCE_MAX * 4
+          || begin < codeVAddr || end > codeVAddr + codeSize) {
+        return false;
+    }
+    atomicBegin = begin;
+    atomicEnd   = end;
+    return true;
 }
 
+/// A load still in its delay slot is dropped: it is in the sequence, and
+/// will be done again.
+void
+AddressSpace::RestartAtomicSequence()
+{
+    if (atomicEnd == 0) {
+        return;
+    }
+
+    unsigned pc = machine->ReadRegister(PC_REG);
+    if (pc <= atomicBegin || pc >= atomicEnd) {
+        return;
+    }
+
+    DEBUG('a', "Restarting atomic sequence at 0x%X, was at 0x%X.\n",
+          atomicBegin, pc);
+    machine->WriteRegister(PC_REG, atomicBegin);
+    machine->WriteRegister(NEXT_PC_REG, atomicBegin + 4);
+    machine->WriteRegister(LOAD_REG, 0);
+}
 
 TranslationEntry* 
 AddressSpace::GetPageTable() 
@@ -260,6 +304,7 @@ AddressSpace::CheckPageinMemory(uint32_t vpn)
 
             uint32_t virtAddr = vpn * PAGE_SIZE; // direcc donde comienza la pag a cargar en memoria
             char *mainMemory = machine->mainMemory;
+            machine->InvalidateCode(physPage * PAGE_SIZE, PAGE_SIZE);
 
             /* de donde saco el ejecutable? */
             ASSERT(executableFile != nullptr);
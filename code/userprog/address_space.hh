@@ -22,6 +22,10 @@
 
 const unsigned USER_STACK_SIZE = 1024;  ///< Increase this as necessary!
 
+/// Longest restartable atomic sequence a program may register, in
+/// instructions.
+const unsigned ATOMIC_SEQUENCE_MAX = 16;
+
 
 class AddressSpace {
 public:
@@ -49,6 +53,19 @@ public:
     void SaveState();
     void RestoreState();
 
+    /// Register the restartable atomic sequence of the program: the code
+    /// from `begin` up to `end`.  A thread that is preempted within it
+    /// starts it over when it resumes, so that no other thread of the
+    /// program can see it half done.
+    ///
+    /// Returns false if the sequence is not valid.
+    bool SetAtomicSequence(unsigned begin, unsigned end);
+
+    /// If the user registers in the machine leave the thread inside the
+    /// atomic sequence, move it back to the start of it.  Called when the
+    /// thread resumes after other threads may have run.
+    void RestartAtomicSequence();
+
     TranslationEntry* GetPageTable();
 
     unsigned GetNumPages();
@@ -73,6 +90,10 @@ private:
 
     /// Number of pages in the virtual address space.
     unsigned numPages;
+
+    /// Bounds of the restartable atomic sequence, or 0 if none.
+    unsigned atomicBegin;
+    unsigned atomicEnd;
 };
 
 void PrintPageTable(AddressSpace* space);
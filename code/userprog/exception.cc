@@ -491,6 +491,7 @@ SyscallHandler(ExceptionType _et)
 
             // crear un nuevo hilo
             Thread *newProc = new Thread("child", allowJoin, currentThread->GetPriority());
+            newProc->SetTickets(currentThread->GetTickets());
             #ifdef FILESYS
             newProc->ChangeDirectory(currentThread->numDirectories, currentThread->directories);
             #endif
@@ -549,6 +550,7 @@ SyscallHandler(ExceptionType _et)
             DEBUG('e', "`Exec2` requested for file %s.\n", filename);
             // crear un nuevo hilo
             Thread *newProc = new Thread("child", allowJoin, currentThread->GetPriority());
+            newProc->SetTickets(currentThread->GetTickets());
             #ifdef FILESYS
             newProc->ChangeDirectory(currentThread->numDirectories, currentThread->directories);
             #endif
@@ -594,6 +596,143 @@ SyscallHandler(ExceptionType _et)
             currentThread->Finish(status);
             break;
         }
+
+        case SC_TICKETS: {
+            SpaceId sid = machine->ReadRegister(4);
+            int tickets = machine->ReadRegister(5);
+            if (tickets <= 0 || (unsigned) tickets > MAX_TICKETS) {
+                DEBUG('e', "Error: invalid number of tickets %d.\n", tickets);
+                machine->WriteRegister(2, -1);
+                break;
+            }
+            if (sid < 0 || !threadsTable->HasKey(sid)) {
+                DEBUG('e', "Error: pid %d does not exists.\n", sid);
+                machine->WriteRegister(2, -1);
+                break;
+            }
+
+            DEBUG('e', "`SetTickets` requested for pid %d, %d tickets.\n",
+                  sid, tickets);
+            Thread *t = threadsTable->Get(sid);
+            machine->WriteRegister(2, t->GetTickets());
+            t->SetTickets(tickets);
+            break;
+        }
+
+        case SC_SLEEP: {
+            int ticks = machine->ReadRegister(4);
+            if (ticks < 0) {
+                DEBUG('e', "Error: negative sleep time %d.\n", ticks);
+                break;
+            }
+
+            DEBUG('e', "`Sleep` requested for %d ticks.\n", ticks);
+            currentThread->SleepFor(ticks);
+            break;
+        }
+
+        case SC_SCHEDSTATS: {
+            SpaceId sid = machine->ReadRegister(4);
+            int statsAddr = machine->ReadRegister(5);
+            if (statsAddr == 0) {
+                DEBUG('e', "Error: address to statistics is null.\n");
+                machine->WriteRegister(2, -1);
+                break;
+            }
+            if (sid < 0 || !threadsTable->HasKey(sid)) {
+                DEBUG('e', "Error: pid %d does not exists.\n", sid);
+                machine->WriteRegister(2, -1);
+                break;
+            }
+
+            DEBUG('e', "`GetSchedStats` requested for pid %d.\n", sid);
+            static_assert(READY_WAIT_BUCKETS == SCHED_WAIT_BUCKETS,
+                          "kernel and user histograms differ");
+            ThreadStats st;
+            threadsTable->Get(sid)->GetStats(&st);
+            int fields[5 + SCHED_WAIT_BUCKETS] = {
+                (int) st.runningTicks, (int) st.readyTicks,
+                (int) st.blockedTicks, (int) st.voluntarySwitches,
+                (int) st.involuntarySwitches
+            };
+            for (unsigned i = 0; i < SCHED_WAIT_BUCKETS; i++) {
+                fields[5 + i] = st.readyWaits[i];
+            }
+            for (unsigned i = 0; i < sizeof fields / sizeof fields[0]; i++) {
+                int j;
+                for (j = 0; j < 3
+                       && !machine->WriteMem(statsAddr + 4 * i, 4, fields[i]);
+                     j++);
+                ASSERT(j < 3);
+            }
+            machine->WriteRegister(2, 0);
+            break;
+        }
+
+        case SC_REALTIME: {
+            int period = machine->ReadRegister(4);
+            int budget = machine->ReadRegister(5);
+            if (period < 0 || (period > 0 && (budget <= 0 || budget > period))) {
+                DEBUG('e', "Error: invalid real-time period %d, budget %d.\n",
+                      period, budget);
+                machine->WriteRegister(2, -1);
+                break;
+            }
+
+            DEBUG('e', "`SetRealTime` requested, period %d, budget %d.\n",
+                  period, budget);
+            bool ok = scheduler->SetRealTime(currentThread, period, budget);
+            machine->WriteRegister(2, ok ? 0 : -1);
+            break;
+        }
+
+        case SC_FUTEX_WAIT: {
+            int addr = machine->ReadRegister(4);
+            int expected = machine->ReadRegister(5);
+            if (addr == 0 || addr % 4 != 0) {
+                DEBUG('e', "Error: invalid futex address 0x%X.\n", addr);
+                machine->WriteRegister(2, -1);
+                break;
+            }
+
+            DEBUG('e', "`FutexWait` requested on 0x%X, expecting %d.\n",
+                  addr, expected);
+            int result = futexTable->Wait(currentThread->space, addr, expected);
+            machine->WriteRegister(2, result);
+            break;
+        }
+
+        case SC_FUTEX_WAKE: {
+            int addr = machine->ReadRegister(4);
+            int n = machine->ReadRegister(5);
+            if (addr == 0 || addr % 4 != 0 || n < 0) {
+                DEBUG('e', "Error: invalid futex address 0x%X or count %d.\n",
+                      addr, n);
+                machine->WriteRegister(2, -1);
+                break;
+            }
+
+            DEBUG('e', "`FutexWake` requested on 0x%X, for %d threads.\n",
+                  addr, n);
+            int woken = futexTable->Wake(currentThread->space, addr, n);
+            machine->WriteRegister(2, woken);
+            break;
+        }
+
+        case SC_ATOMIC_SEQ: {
+            unsigned begin = machine->ReadRegister(4);
+            unsigned end = machine->ReadRegister(5);
+
+            DEBUG('e', "`SetAtomicSequence` requested, 0x%X to 0x%X.\n",
+                  begin, end);
+            bool ok = currentThread->space->SetAtomicSequence(begin, end);
+            if (!ok) {
+                DEBUG('e', "Error: invalid atomic sequence.\n");
+            }
+            machine->WriteRegister(2, ok ? 0 : -1);
+            break;
+        }
+
         default:
             fprintf(stderr, "Unexpected system call: id %d.\n", scid);
             ASSERT(false);
@@ -617,6 +756,7 @@ PageFaultHandler (ExceptionType _et)
         TranslationEntry* pageTable = currentThread->space->GetPageTable();
         pageTable[machine->GetMMU()->tlb[i].virtualPage].use = machine->GetMMU()->tlb[i].use;
         pageTable[machine->GetMMU()->tlb[i].virtualPage].dirty = machine->GetMMU()->tlb[i].dirty;
+        machine->GetMMU()->FlushHostTlbPage(machine->GetMMU()->tlb[i].virtualPage);
     }
     machine->GetMMU()->tlb[i] = page; 
 }
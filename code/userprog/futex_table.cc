@@ -0,0 +1,106 @@
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "futex_table.hh"
+#include "threads/system.hh"
+
+#include <stdint.h>
+
+
+FutexTable::FutexTable()
+{
+    for (unsigned i = 0; i < FUTEX_BUCKETS; i++) {
+        buckets[i] = nullptr;
+    }
+    waiting = 0;
+}
+
+FutexTable::~FutexTable()
+{
+    ASSERT(waiting == 0);
+}
+
+/// Reading the word may take a page fault, which is served right away, so
+/// try again a few times, as `ReadBufferFromUser` does.
+int
+FutexTable::Wait(AddressSpace *space, int addr, int expected)
+{
+    ASSERT(space != nullptr);
+
+    IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
+
+    int value;
+    bool read = false;
+    for (unsigned i = 0; i < 3 && !read; i++) {
+        read = machine->ReadMem(addr, 4, &value);
+    }
+    if (!read || value != expected) {
+        interrupt->SetLevel(oldLevel);
+        return -1;
+    }
+
+    Waiter w;
+    w.space  = space;
+    w.addr   = addr;
+    w.thread = currentThread;
+    w.woken  = false;
+    w.next   = nullptr;
+
+    Waiter **p = &buckets[Hash(space, addr)];
+    while (*p != nullptr) {
+        p = &(*p)->next;
+    }
+    *p = &w;
+    waiting++;
+
+    DEBUG('e', "Thread \"%s\" waiting on futex 0x%X.\n",
+          currentThread->GetName(), addr);
+    while (!w.woken) {
+        currentThread->Sleep();
+    }
+
+    interrupt->SetLevel(oldLevel);
+    return 0;
+}
+
+int
+FutexTable::Wake(AddressSpace *space, int addr, int n)
+{
+    ASSERT(space != nullptr);
+
+    IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
+
+    int woken = 0;
+    Waiter **p = &buckets[Hash(space, addr)];
+    while (*p != nullptr && woken < n) {
+        Waiter *w = *p;
+        if (w->space != space || w->addr != addr) {
+            p = &w->next;
+            continue;
+        }
+        *p = w->next;
+        w->woken = true;
+        waiting--;
+        woken++;
+        scheduler->ReadyToRun(w->thread);
+    }
+
+    DEBUG('e', "Woke up %d threads on futex 0x%X.\n", woken, addr);
+    interrupt->SetLevel(oldLevel);
+    return woken;
+}
+
+unsigned
+FutexTable::GetWaiting() const
+{
+    return waiting;
+}
+
+unsigned
+FutexTable::Hash(AddressSpace *space, int addr)
+{
+    uintptr_t key = (uintptr_t) space / sizeof (void *) + (unsigned) addr / 4;
+    return key % FUTEX_BUCKETS;
+}
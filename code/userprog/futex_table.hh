@@ -0,0 +1,72 @@
+/// Wait queues for user-space synchronization, keyed by address.
+///
+/// A user program synchronizes its threads through words in its own memory,
+/// and only enters the kernel when it has to block or to wake someone up:
+/// `FutexWait` blocks the calling thread on a word, provided the word still
+/// holds the value the caller last saw there, and `FutexWake` wakes up
+/// threads blocked on a word.  The kernel keeps no state for a word nobody
+/// waits on.
+///
+/// Waiting threads are kept in a hash table of FIFO queues, keyed by
+/// address space and virtual address.  Every method runs with interrupts
+/// disabled, so that checking the word and going to sleep are atomic with
+/// respect to other threads.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_USERPROG_FUTEXTABLE__HH
+#define NACHOS_USERPROG_FUTEXTABLE__HH
+
+
+class AddressSpace;
+class Thread;
+
+/// Number of buckets of the hash table.  A power of two.
+const unsigned FUTEX_BUCKETS = 64;
+
+class FutexTable {
+public:
+
+    FutexTable();
+
+    /// No thread may be waiting.
+    ~FutexTable();
+
+    /// Block the current thread on the word at `addr` of `space`, if it
+    /// holds `expected`.
+    ///
+    /// Returns 0 once woken up, or -1 right away if the word holds anything
+    /// else, or cannot be read.
+    int Wait(AddressSpace *space, int addr, int expected);
+
+    /// Wake up to `n` threads blocked on the word at `addr` of `space`, in
+    /// the order they blocked.
+    ///
+    /// Returns the number of threads woken up.
+    int Wake(AddressSpace *space, int addr, int n);
+
+    /// Number of threads blocked, on any word.
+    unsigned GetWaiting() const;
+
+private:
+
+    /// A thread blocked on a word.  It lives on the stack of that thread.
+    struct Waiter {
+        AddressSpace *space;
+        int addr;
+        Thread *thread;
+        bool woken;
+        Waiter *next;
+    };
+
+    Waiter *buckets[FUTEX_BUCKETS];
+
+    unsigned waiting;
+
+    static unsigned Hash(AddressSpace *space, int addr);
+};
+
+
+#endif
@@ -105,3 +105,144 @@ ConsoleTest(const char *in, const char *out)
         }
     }
 }
+
+/// Data structures needed for the futex test.
+///
+/// Kernel threads stand in for the threads of two user programs: each one
+/// is given one of two address spaces loaded from the same executable, and
+/// waits on the same virtual address, the last word of the stack.
+
+static const unsigned FUTEX_WAITERS = 4;
+
+static int futexAddr;
+static bool woken[FUTEX_WAITERS + 1];
+static unsigned numWoken;
+
+static void
+FutexWaiter(void *arg)
+{
+    unsigned *n = (unsigned *) arg;
+
+    currentThread->space->RestoreState();  // Like a new user thread.
+    ASSERT(futexTable->Wait(currentThread->space, futexAddr, 0) == 0);
+    woken[*n] = true;
+    numWoken++;
+}
+
+/// Switch the current thread to `space`, and store `value` in its futex
+/// word.  Writing may take a page fault, which is served right away, so
+/// try again a few times, as `WriteBufferToUser` does.
+static void
+SetFutexWord(AddressSpace *space, int value)
+{
+    currentThread->space = space;
+    space->RestoreState();
+
+    bool written = false;
+    for (unsigned i = 0; i < 3 && !written; i++) {
+        written = machine->WriteMem(futexAddr, 4, value);
+    }
+    ASSERT(written);
+}
+
+/// Fork a thread that waits on the futex word of `space`, and yield until
+/// it has blocked, so that waiters block in the order they are forked.
+static Thread *
+ForkFutexWaiter(AddressSpace *space, unsigned *id)
+{
+    static char names[FUTEX_WAITERS + 1][16];
+
+    sprintf(names[*id], "futex %u", *id);
+    Thread *t = new Thread(names[*id], 1);
+    t->space = space;
+
+    unsigned waiting = futexTable->GetWaiting();
+    t->Fork(FutexWaiter, id);
+    while (futexTable->GetWaiting() == waiting) {
+        currentThread->Yield();
+    }
+    return t;
+}
+
+/// Wake up to `n` threads waiting on the futex word of `space`, and yield
+/// until those woken up have run, as the scheduler may run them in any
+/// order.  Then check that the first `total` waiters, and only those, have
+/// been woken up.  Returns the number of threads woken up.
+static int
+WakeFutex(AddressSpace *space, int n, unsigned total)
+{
+    unsigned before = numWoken;
+    int count = futexTable->Wake(space, futexAddr, n);
+    while (numWoken < before + count) {
+        currentThread->Yield();
+    }
+    for (unsigned i = 0; i <= FUTEX_WAITERS; i++) {
+        ASSERT(woken[i] == (i < total));
+    }
+    return count;
+}
+
+/// Test `FutexTable` directly, without a user program running: waiters are
+/// woken up in FIFO order, `Wake` wakes up no more threads than asked, a
+/// word that does not hold the expected value fails without blocking, and
+/// the same address in two address spaces is two different futexes.
+void
+FutexTest(const char *filename)
+{
+    ASSERT(filename != nullptr);
+
+    OpenFile *executables[2];
+    AddressSpace *spaces[2];
+    for (unsigned i = 0; i < 2; i++) {
+        executables[i] = fileSystem->Open(filename);
+        if (executables[i] == nullptr) {
+            printf("Unable to open file %s\n", filename);
+            return;
+        }
+        spaces[i] = new AddressSpace(executables[i]);
+    }
+    futexAddr = spaces[0]->GetNumPages() * PAGE_SIZE - 4;
+    SetFutexWord(spaces[1], 0);
+    SetFutexWord(spaces[0], 1);
+
+    // The word holds 1, so expecting 0 fails right away.
+    ASSERT(futexTable->Wait(spaces[0], futexAddr, 0) == -1);
+    ASSERT(futexTable->GetWaiting() == 0);
+    SetFutexWord(spaces[0], 0);
+
+    // Waiters 0 to 3 in the first address space, 4 in the second.
+    Thread *threads[FUTEX_WAITERS + 1];
+    unsigned ids[FUTEX_WAITERS + 1];
+    numWoken = 0;
+    for (unsigned i = 0; i <= FUTEX_WAITERS; i++) {
+        ids[i] = i;
+        woken[i] = false;
+        threads[i] = ForkFutexWaiter(spaces[i < FUTEX_WAITERS ? 0 : 1],
+                                     &ids[i]);
+    }
+    ASSERT(futexTable->GetWaiting() == FUTEX_WAITERS + 1);
+    printf("%u threads waiting on one address, in two address spaces.\n",
+           FUTEX_WAITERS + 1);
+
+    ASSERT(WakeFutex(spaces[0], 1, 1) == 1);
+    ASSERT(WakeFutex(spaces[0], 2, 3) == 2);
+    ASSERT(WakeFutex(spaces[0], FUTEX_WAITERS, FUTEX_WAITERS) == 1);
+    ASSERT(WakeFutex(spaces[0], FUTEX_WAITERS, FUTEX_WAITERS) == 0);
+    ASSERT(futexTable->GetWaiting() == 1);
+    printf("Waiters of one address space woken up in FIFO order, at most"
+           " as many as asked.\n");
+
+    ASSERT(WakeFutex(spaces[1], FUTEX_WAITERS, FUTEX_WAITERS + 1) == 1);
+    ASSERT(futexTable->GetWaiting() == 0);
+    for (unsigned i = 0; i <= FUTEX_WAITERS; i++) {
+        threads[i]->Join();
+    }
+    printf("The waiter of the other address space was left alone until"
+           " woken up.\n");
+
+    currentThread->space = nullptr;
+    for (unsigned i = 0; i < 2; i++) {
+        delete spaces[i];
+        delete executables[i];
+    }
+}
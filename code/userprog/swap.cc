@@ -37,6 +37,9 @@ int PickVictim(AddressSpace** spaceDir, unsigned* vpnDir)
                 }
                 else {
                     pageTable[vpn].use = 0;
+                    for (unsigned c = 0; c < machine->GetNumCpus(); c++) {
+                        machine->GetMMU(c)->FlushHostTlbFrame(frame);
+                    }
                     memCoreMap->clockFrames->Pop();
                     memCoreMap->clockFrames->Append(frame);
                 }
@@ -78,12 +81,17 @@ int DoSwapOut()
 
     // actualizar la tabla del proceso al que pertenece
     pageTable[vpn].valid = false;
+    machine->InvalidateCode(frame * PAGE_SIZE, PAGE_SIZE);
 
-    // actualizar la tlb
-    for (unsigned i = 0; i < TLB_SIZE; i++) {
-        if (machine->GetMMU()->tlb[i].virtualPage == vpn) {
-            machine->GetMMU()->tlb[i].valid = false;
+    // actualizar la tlb de cada CPU que pueda tener mapeado el marco
+    for (unsigned c = 0; c < machine->GetNumCpus(); c++) {
+        TranslationEntry *tlb = machine->GetMMU(c)->tlb;
+        for (unsigned i = 0; i < TLB_SIZE; i++) {
+            if (tlb[i].valid && tlb[i].physicalPage == (unsigned) frame) {
+                tlb[i].valid = false;
+            }
         }
+        machine->GetMMU(c)->FlushHostTlbFrame(frame);
     }
     return frame;
 }
@@ -99,6 +107,7 @@ int DoSwapIn(unsigned vpn)
   DEBUG('w', "Swap In: Bring VPN: %d, to PPN: %d.\n", vpn, physPage);
   char *mainMemory = machine->mainMemory;
   currentThread->space->swapFile->ReadAt(&mainMemory[physPage * PAGE_SIZE], PAGE_SIZE, vpn * PAGE_SIZE);
+  machine->InvalidateCode(physPage * PAGE_SIZE, PAGE_SIZE);
   return physPage;
 }
 
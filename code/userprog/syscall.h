@@ -34,6 +34,13 @@
 #define SC_EXEC2   16
 #define SC_LS      17
 #define SC_CD      18
+#define SC_TICKETS 19
+#define SC_SLEEP   20
+#define SC_SCHEDSTATS 21
+#define SC_REALTIME   22
+#define SC_FUTEX_WAIT 23
+#define SC_FUTEX_WAKE 24
+#define SC_ATOMIC_SEQ 25
 
 #ifndef IN_ASM
 
@@ -130,6 +137,90 @@ void Ls();
 
 void Cd(char *newDir);
 
+
+/// Scheduling control.
+
+/// Give the user program `id` a share of `tickets` (between 1 and 10000,
+/// 100 by default) under the proportional share scheduling policies.
+///
+/// Return the tickets it held before, or -1 on error.
+int SetTickets(SpaceId id, int tickets);
+
+/// Block the calling thread for at least `ticks` ticks of simulated time,
+/// without using the CPU.
+void Sleep(int ticks);
+
+/// Number of buckets of the ready wait histogram in `SchedStats`.
+#define SCHED_WAIT_BUCKETS 12
+
+/// Scheduling statistics of a user program, in ticks and counts.
+///
+/// `readyWaits[i]` counts the times the program waited in the ready queue
+/// for less than `10 << i` ticks (and no less than the bound before it);
+/// the last bucket counts all longer waits.
+typedef struct {
+    int runningTicks;
+    int readyTicks;
+    int blockedTicks;
+    int voluntarySwitches;
+    int involuntarySwitches;
+    int readyWaits[SCHED_WAIT_BUCKETS];
+} SchedStats;
+
+/// Fill in `stats` with the scheduling statistics of the user program
+/// `id`.
+///
+/// Return 0 on success, or -1 on error.
+int GetSchedStats(SpaceId id, SchedStats *stats);
+
+/// Put the calling program in the real-time scheduling class: it may run
+/// for `budget` ticks every `period` ticks, ahead of every non real-time
+/// program, and is throttled if it runs for longer.  A `period` of 0 takes
+/// it back out of the class.
+///
+/// Return 0 on success, or -1 if the parameters are invalid or the
+/// program cannot be admitted without risking missed deadlines.
+int SetRealTime(int period, int budget);
+
+
+/// User-space synchronization.
+///
+/// Threads of a program synchronize through words in its memory, updated
+/// with `CompareAndSwap`, and only call into the kernel to block and to
+/// wake each other up.  See `lib.c` for a mutex built on these.
+
+/// Block the calling thread on the word at `addr`, if it still holds
+/// `expected`; otherwise return right away.
+///
+/// Return 0 once woken up by `FutexWake`, or -1 if the word held anything
+/// else or `addr` is not a valid word address.
+int FutexWait(int *addr, int expected);
+
+/// Wake up to `n` threads blocked on the word at `addr`, in the order they
+/// blocked.
+///
+/// Return the number of threads woken up, or -1 on error.
+int FutexWake(int *addr, int n);
+
+/// If `*addr` holds `expected`, replace it with `desired`.  Return the
+/// value it held before.
+///
+/// There are no atomic instructions in the machine, so this is atomic only
+/// once the program has registered it with `SetAtomicSequence`.
+int CompareAndSwap(int *addr, int expected, int desired);
+
+/// Bounds of the code of `CompareAndSwap` that must run without
+/// interference.
+extern char AtomicSequenceBegin[], AtomicSequenceEnd[];
+
+/// Register the code from `begin` up to `end` as the restartable atomic
+/// sequence of the program: a thread preempted within it starts it over
+/// when it resumes.  Call with `AtomicSequenceBegin` and
+/// `AtomicSequenceEnd`.
+///
+/// Return 0 on success, or -1 if the bounds are invalid.
+int SetAtomicSequence(void *begin, void *end);
+
 #endif
 
 